@@ -17,4 +17,5 @@
 
 option(WITH_WARNINGS         "Show all warnings during compile"                           0)
 option(WITH_CORE_DEBUG       "Include additional debug-code in core"                      1)
-option(WITH_HEADLESS_DEBUG   "Include Headless Players"                     		      1)
\ No newline at end of file
+option(WITH_HEADLESS_DEBUG   "Include Headless Players"                     		      1)
+option(WITH_BENCHMARK        "Build the end-to-end network benchmark"                     0)
@@ -37,4 +37,10 @@ if( WITH_HEADLESS_DEBUG )
   add_definitions(-DHEADLESS_DEBUG)
 else()
   message("* Enable Headless Players      : No  (default)")
-endif()
\ No newline at end of file
+endif()
+
+if( WITH_BENCHMARK )
+  message("* Build network benchmark      : Yes")
+else()
+  message("* Build network benchmark      : No  (default)")
+endif()
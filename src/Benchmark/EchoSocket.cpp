@@ -0,0 +1,67 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EchoSocket.hpp"
+#include "Network/PacketReader.hpp"
+#include "Network/PacketWriter.hpp"
+
+namespace SteerStone { namespace Benchmark {
+
+    /// Constructor
+    /// @p_Service : Boost Service
+    /// @p_CloseHandler : Close Handler Custom function
+    EchoSocket::EchoSocket(boost::asio::io_service& p_Service, std::function<void(Socket*)> p_CloseHandler)
+        : Socket(p_Service, std::move(p_CloseHandler))
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Handle incoming data
+    /// Every complete frame is written back as is
+    Core::Network::ProcessState EchoSocket::ProcessIncomingData()
+    {
+        while (ReadLengthRemaining() >= BENCHMARK_LENGTH_HEADER_SIZE)
+        {
+            uint8 const* l_Header = InPeak();
+
+            uint32 l_Length = 0;
+            if (!Core::Network::PacketReader::DecodeBase64(l_Header, BENCHMARK_LENGTH_HEADER_SIZE, l_Length))
+                return Core::Network::ProcessState::Error;
+
+            /// Wait for the rest of the frame
+            if (ReadLengthRemaining() < BENCHMARK_LENGTH_HEADER_SIZE + l_Length)
+                break;
+
+            /// Serialize the echo straight into the out queue, the writer fills in the length header
+            {
+                Core::Network::PacketWriter l_Writer(*this);
+                l_Writer.WriteBytes(l_Header + BENCHMARK_LENGTH_HEADER_SIZE, l_Length);
+                l_Writer.Commit();
+            }
+
+            ReadSkip(BENCHMARK_LENGTH_HEADER_SIZE + l_Length);
+            CountMessagesIn();
+        }
+
+        return Core::Network::ProcessState::Successful;
+    }
+
+}   ///< namespace Benchmark
+}   ///< namespace Steerstone
@@ -0,0 +1,51 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "Network/Listener.hpp"
+
+#define BENCHMARK_LENGTH_HEADER_SIZE 3      ///< Base64 encoded length in front of every frame, as the game client sends it
+
+namespace SteerStone { namespace Benchmark {
+
+    /// Sends every frame it receives straight back
+    class EchoSocket : public Core::Network::Socket
+    {
+        DISALLOW_COPY_AND_ASSIGN(EchoSocket);
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            /// @p_Service : Boost Service
+            /// @p_CloseHandler : Close Handler Custom function
+            EchoSocket(boost::asio::io_service& p_Service, std::function<void(Socket*)> p_CloseHandler);
+            /// Deconstructor
+            ~EchoSocket() {}
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        private:
+            /// Handle incoming data
+            virtual Core::Network::ProcessState ProcessIncomingData() override;
+    };
+
+}   ///< namespace Benchmark
+}   ///< namespace Steerstone
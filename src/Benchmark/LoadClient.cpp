@@ -0,0 +1,312 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "LoadClient.hpp"
+#include "EchoSocket.hpp"
+
+namespace SteerStone { namespace Benchmark {
+
+    /// Get the clock used for send times, in nanoseconds
+    static uint64 GetTimestamp()
+    {
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /// Constructor
+    /// @p_Service : Service of the load client
+    /// @p_Seed    : Seed of the message mix
+    LoadConnection::LoadConnection(boost::asio::io_service& p_Service, uint32 const p_Seed)
+        : m_Socket(p_Service), m_Strand(p_Service), m_Random(p_Seed), m_Scenario(nullptr), m_Running(false), m_Recording(false),
+        m_InFlight(0), m_Messages(0), m_Bytes(0)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Connect, blocking
+    /// @p_EndPoint : Server
+    bool LoadConnection::Connect(boost::asio::ip::tcp::endpoint const& p_EndPoint)
+    {
+        boost::system::error_code l_ErrorCode;
+        m_Socket.connect(p_EndPoint, l_ErrorCode);
+
+        if (l_ErrorCode)
+            return false;
+
+        m_Socket.set_option(boost::asio::ip::tcp::no_delay(true), l_ErrorCode);
+
+        StartRead();
+        return true;
+    }
+    /// Close the connection
+    void LoadConnection::Close()
+    {
+        std::shared_ptr<LoadConnection> l_Ptr = shared_from_this();
+        m_Strand.post([l_Ptr]()
+        {
+            boost::system::error_code l_ErrorCode;
+            l_Ptr->m_Socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, l_ErrorCode);
+            l_Ptr->m_Socket.close(l_ErrorCode);
+        });
+    }
+
+    /// Start replaying a scenario
+    /// @p_Scenario : Scenario, must outlive the run
+    void LoadConnection::Start(Scenario const* p_Scenario)
+    {
+        std::shared_ptr<LoadConnection> l_Ptr = shared_from_this();
+        m_Strand.post([l_Ptr, p_Scenario]()
+        {
+            l_Ptr->m_Scenario   = p_Scenario;
+            l_Ptr->m_Running    = true;
+
+            for (uint32 l_I = 0; l_I < p_Scenario->Window; l_I++)
+                l_Ptr->SendOne();
+        });
+    }
+    /// Stop sending, frames in flight still come back
+    void LoadConnection::Stop()
+    {
+        m_Running = false;
+    }
+    /// Start or stop recording results
+    /// @p_Recording : Record
+    void LoadConnection::SetRecording(bool const p_Recording)
+    {
+        m_Recording = p_Recording;
+    }
+
+    /// Get frames sent but not echoed yet
+    uint32 LoadConnection::GetInFlight() const
+    {
+        return m_InFlight;
+    }
+    /// Move recorded results into p_Result
+    /// @p_Result : Result
+    void LoadConnection::Collect(ScenarioResult& p_Result)
+    {
+        std::lock_guard<std::mutex> l_Guard(m_ResultLock);
+
+        p_Result.Messages   += m_Messages;
+        p_Result.Bytes      += m_Bytes;
+        p_Result.Latencies.insert(p_Result.Latencies.end(), m_Latencies.begin(), m_Latencies.end());
+
+        m_Messages  = 0;
+        m_Bytes     = 0;
+        m_Latencies.clear();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Queue one frame from the mix
+    void LoadConnection::SendOne()
+    {
+        uint32 l_TotalWeight = 0;
+        for (MessageMix const& l_Mix : m_Scenario->Mix)
+            l_TotalWeight += l_Mix.Weight;
+
+        uint32 l_Pick = std::uniform_int_distribution<uint32>(0, l_TotalWeight - 1)(m_Random);
+        uint32 l_Size = BENCHMARK_MIN_BODY_SIZE;
+        for (MessageMix const& l_Mix : m_Scenario->Mix)
+        {
+            if (l_Pick < l_Mix.Weight)
+            {
+                l_Size = std::max<uint32>(l_Mix.Size, BENCHMARK_MIN_BODY_SIZE);
+                break;
+            }
+
+            l_Pick -= l_Mix.Weight;
+        }
+
+        std::vector<uint8> l_Frame(BENCHMARK_LENGTH_HEADER_SIZE + l_Size, 'a');
+
+        /// Length as 3 base64 characters, like the game client
+        l_Frame[0] = static_cast<uint8>(64 | ((l_Size >> 12) & 0x3F));
+        l_Frame[1] = static_cast<uint8>(64 | ((l_Size >> 6) & 0x3F));
+        l_Frame[2] = static_cast<uint8>(64 | (l_Size & 0x3F));
+
+        const uint64 l_Timestamp = GetTimestamp();
+        memcpy(&l_Frame[BENCHMARK_LENGTH_HEADER_SIZE], &l_Timestamp, sizeof(l_Timestamp));
+
+        m_InFlight++;
+        m_WriteQueue.push_back(std::move(l_Frame));
+
+        if (m_WriteQueue.size() == 1)
+            StartWrite();
+    }
+    /// Write the front of the queue
+    void LoadConnection::StartWrite()
+    {
+        std::shared_ptr<LoadConnection> l_Ptr = shared_from_this();
+        boost::asio::async_write(m_Socket, boost::asio::buffer(m_WriteQueue.front()), m_Strand.wrap(
+            [l_Ptr](boost::system::error_code const& p_ErrorCode, std::size_t)
+            {
+                if (p_ErrorCode)
+                    return;
+
+                l_Ptr->m_WriteQueue.pop_front();
+
+                if (!l_Ptr->m_WriteQueue.empty())
+                    l_Ptr->StartWrite();
+            }));
+    }
+    /// Read the next frame header
+    void LoadConnection::StartRead()
+    {
+        std::shared_ptr<LoadConnection> l_Ptr = shared_from_this();
+        boost::asio::async_read(m_Socket, boost::asio::buffer(m_Header), m_Strand.wrap(
+            [l_Ptr](boost::system::error_code const& p_ErrorCode, std::size_t) { l_Ptr->OnReadHeader(p_ErrorCode); }));
+    }
+    /// Frame header read
+    /// @p_ErrorCode : Error code
+    void LoadConnection::OnReadHeader(boost::system::error_code const& p_ErrorCode)
+    {
+        if (p_ErrorCode)
+            return;
+
+        std::size_t l_Length = 0;
+        for (std::size_t l_I = 0; l_I < BENCHMARK_LENGTH_HEADER_SIZE; l_I++)
+            l_Length = (l_Length << 6) | ((m_Header[l_I] - 64) & 0x3F);
+
+        m_Body.resize(l_Length);
+
+        std::shared_ptr<LoadConnection> l_Ptr = shared_from_this();
+        boost::asio::async_read(m_Socket, boost::asio::buffer(m_Body), m_Strand.wrap(
+            [l_Ptr](boost::system::error_code const& p_ErrorCode, std::size_t) { l_Ptr->OnReadBody(p_ErrorCode); }));
+    }
+    /// Frame body read
+    /// @p_ErrorCode : Error code
+    void LoadConnection::OnReadBody(boost::system::error_code const& p_ErrorCode)
+    {
+        if (p_ErrorCode)
+            return;
+
+        m_InFlight--;
+
+        if (m_Recording && m_Body.size() >= BENCHMARK_MIN_BODY_SIZE)
+        {
+            uint64 l_Timestamp = 0;
+            memcpy(&l_Timestamp, m_Body.data(), sizeof(l_Timestamp));
+
+            std::lock_guard<std::mutex> l_Guard(m_ResultLock);
+            m_Messages++;
+            m_Bytes += BENCHMARK_LENGTH_HEADER_SIZE + m_Body.size();
+            m_Latencies.push_back(static_cast<uint32>((GetTimestamp() - l_Timestamp) / 1000));
+        }
+
+        if (m_Running)
+            SendOne();
+
+        StartRead();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Threads : Client threads
+    LoadClient::LoadClient(uint32 const p_Threads)
+        : m_Work(new boost::asio::io_service::work(m_Service))
+    {
+        for (uint32 l_I = 0; l_I < std::max<uint32>(p_Threads, 1); l_I++)
+            m_Threads.emplace_back([this]() { this->m_Service.run(); });
+    }
+    /// Deconstructor
+    LoadClient::~LoadClient()
+    {
+        for (auto const& l_Connection : m_Connections)
+            l_Connection->Close();
+
+        m_Work.reset();
+        m_Service.stop();
+
+        for (std::thread& l_Thread : m_Threads)
+            l_Thread.join();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Open connections, returns how many connected
+    /// @p_EndPoint    : Server
+    /// @p_Connections : Connections to open
+    uint32 LoadClient::Connect(boost::asio::ip::tcp::endpoint const& p_EndPoint, uint32 const p_Connections)
+    {
+        for (uint32 l_I = 0; l_I < p_Connections; l_I++)
+        {
+            std::shared_ptr<LoadConnection> l_Connection = std::make_shared<LoadConnection>(m_Service, l_I);
+
+            if (!l_Connection->Connect(p_EndPoint))
+                break;
+
+            m_Connections.push_back(l_Connection);
+        }
+
+        return static_cast<uint32>(m_Connections.size());
+    }
+    /// Replay a scenario
+    /// @p_Scenario : Scenario
+    /// @p_Warmup   : Seconds to run before measuring
+    /// @p_Duration : Seconds to measure
+    ScenarioResult LoadClient::Run(Scenario const& p_Scenario, uint32 const p_Warmup, uint32 const p_Duration)
+    {
+        ScenarioResult l_Result;
+        l_Result.Connections = static_cast<uint32>(m_Connections.size());
+
+        for (auto const& l_Connection : m_Connections)
+            l_Connection->Start(&p_Scenario);
+
+        std::this_thread::sleep_for(std::chrono::seconds(p_Warmup));
+
+        for (auto const& l_Connection : m_Connections)
+            l_Connection->SetRecording(true);
+
+        const std::chrono::steady_clock::time_point l_Start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::seconds(p_Duration));
+
+        for (auto const& l_Connection : m_Connections)
+            l_Connection->SetRecording(false);
+
+        l_Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - l_Start).count();
+
+        for (auto const& l_Connection : m_Connections)
+            l_Connection->Stop();
+
+        /// Let the frames in flight come back so the next scenario starts from a quiet server
+        const std::chrono::steady_clock::time_point l_Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        for (auto const& l_Connection : m_Connections)
+        {
+            while (l_Connection->GetInFlight() && std::chrono::steady_clock::now() < l_Deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            l_Connection->Collect(l_Result);
+        }
+
+        std::sort(l_Result.Latencies.begin(), l_Result.Latencies.end());
+
+        return l_Result;
+    }
+
+}   ///< namespace Benchmark
+}   ///< namespace Steerstone
@@ -0,0 +1,138 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "Core/Core.hpp"
+#include "Scenario.hpp"
+
+namespace SteerStone { namespace Benchmark {
+
+    /// Headless client connection, keeps a window of frames in flight and times their echo
+    class LoadConnection : public std::enable_shared_from_this<LoadConnection>
+    {
+        DISALLOW_COPY_AND_ASSIGN(LoadConnection);
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            /// @p_Service : Service of the load client
+            /// @p_Seed    : Seed of the message mix
+            LoadConnection(boost::asio::io_service& p_Service, uint32 const p_Seed);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Connect, blocking
+            /// @p_EndPoint : Server
+            bool Connect(boost::asio::ip::tcp::endpoint const& p_EndPoint);
+            /// Close the connection
+            void Close();
+
+            /// Start replaying a scenario
+            /// @p_Scenario : Scenario, must outlive the run
+            void Start(Scenario const* p_Scenario);
+            /// Stop sending, frames in flight still come back
+            void Stop();
+            /// Start or stop recording results
+            /// @p_Recording : Record
+            void SetRecording(bool const p_Recording);
+
+            /// Get frames sent but not echoed yet
+            uint32 GetInFlight() const;
+            /// Move recorded results into p_Result
+            /// @p_Result : Result
+            void Collect(ScenarioResult& p_Result);
+
+        private:
+            /// Queue one frame from the mix
+            void SendOne();
+            /// Write the front of the queue
+            void StartWrite();
+            /// Read the next frame header
+            void StartRead();
+            /// Frame header read
+            /// @p_ErrorCode : Error code
+            void OnReadHeader(boost::system::error_code const& p_ErrorCode);
+            /// Frame body read
+            /// @p_ErrorCode : Error code
+            void OnReadBody(boost::system::error_code const& p_ErrorCode);
+
+        private:
+            boost::asio::ip::tcp::socket m_Socket;                  ///< Socket
+            boost::asio::io_service::strand m_Strand;               ///< Serializes our handlers
+            std::mt19937 m_Random;                                  ///< Picks sizes from the mix
+            Scenario const* m_Scenario;                             ///< Scenario being replayed
+            std::atomic<bool> m_Running;                            ///< Keep sending
+            std::atomic<bool> m_Recording;                          ///< Record results
+            std::atomic<uint32> m_InFlight;                         ///< Frames sent but not echoed
+            std::deque<std::vector<uint8>> m_WriteQueue;            ///< Frames waiting to be written
+            uint8 m_Header[3];                                      ///< Header being read
+            std::vector<uint8> m_Body;                              ///< Body being read
+            std::mutex m_ResultLock;                                ///< Guards results
+            uint64 m_Messages;                                      ///< Echoes received while recording
+            uint64 m_Bytes;                                         ///< Bytes received while recording
+            std::vector<uint32> m_Latencies;                        ///< Round trips in microseconds
+    };
+
+    /// Opens many loopback connections and replays scenarios over them
+    class LoadClient
+    {
+        DISALLOW_COPY_AND_ASSIGN(LoadClient);
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            /// @p_Threads : Client threads
+            explicit LoadClient(uint32 const p_Threads);
+            /// Deconstructor
+            ~LoadClient();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Open connections, returns how many connected
+            /// @p_EndPoint    : Server
+            /// @p_Connections : Connections to open
+            uint32 Connect(boost::asio::ip::tcp::endpoint const& p_EndPoint, uint32 const p_Connections);
+            /// Replay a scenario
+            /// @p_Scenario : Scenario
+            /// @p_Warmup   : Seconds to run before measuring
+            /// @p_Duration : Seconds to measure
+            ScenarioResult Run(Scenario const& p_Scenario, uint32 const p_Warmup, uint32 const p_Duration);
+
+        private:
+            boost::asio::io_service m_Service;                                  ///< Service of every connection
+            std::unique_ptr<boost::asio::io_service::work> m_Work;              ///< Keeps m_Service running
+            std::vector<std::thread> m_Threads;                                 ///< Threads running m_Service
+            std::vector<std::shared_ptr<LoadConnection>> m_Connections;         ///< Connections
+    };
+
+}   ///< namespace Benchmark
+}   ///< namespace Steerstone
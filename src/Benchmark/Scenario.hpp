@@ -0,0 +1,76 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+
+#define BENCHMARK_MIN_BODY_SIZE 8           ///< Every body starts with its send time
+
+namespace SteerStone { namespace Benchmark {
+
+    /// One kind of message in a mix
+    struct MessageMix
+    {
+        uint32 Size;                        ///< Body size, at least BENCHMARK_MIN_BODY_SIZE
+        uint32 Weight;                      ///< Relative share of the mix
+    };
+
+    /// Traffic replayed by every connection
+    struct Scenario
+    {
+        std::string Name;                   ///< Name
+        std::vector<MessageMix> Mix;        ///< Message sizes and their share
+        uint32 Window;                      ///< Messages each connection keeps in flight
+    };
+
+    /// Result of one scenario
+    struct ScenarioResult
+    {
+        uint64 Messages = 0;                ///< Echoes received while measuring
+        uint64 Bytes = 0;                   ///< Echoed bytes received while measuring
+        double Seconds = 0.0;               ///< Length of the measurement
+        uint32 Connections = 0;             ///< Connections which took part
+        std::vector<uint32> Latencies;      ///< Round trips in microseconds, sorted
+
+        /// Get a round trip percentile in microseconds
+        /// @p_Percentile : 0.0 - 1.0
+        uint32 GetPercentile(double const p_Percentile) const
+        {
+            if (Latencies.empty())
+                return 0;
+
+            const std::size_t l_Index = std::min(Latencies.size() - 1, static_cast<std::size_t>(p_Percentile * Latencies.size()));
+            return Latencies[l_Index];
+        }
+    };
+
+    /// Built in scenarios
+    inline std::vector<Scenario> GetDefaultScenarios()
+    {
+        return
+        {
+            { "chat",   { { 48, 70 }, { 128, 30 } },                1 },    ///< Request / response chatter
+            { "status", { { 16, 100 } },                            8 },    ///< Small pipelined status updates
+            { "mixed",  { { 64, 90 }, { 512, 9 }, { 8192, 1 } },    4 },    ///< Room traffic with the odd large list
+            { "bulk",   { { 16000, 100 } },                         2 },    ///< Large frames, close to the client limit
+        };
+    }
+
+}   ///< namespace Benchmark
+}   ///< namespace Steerstone
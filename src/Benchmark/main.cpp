@@ -0,0 +1,156 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/program_options.hpp>
+#include <cstdio>
+#include <iostream>
+
+#include "Network/Listener.hpp"
+
+#include "EchoSocket.hpp"
+#include "LoadClient.hpp"
+
+int main(int argc, char** argv)
+{
+    namespace po = boost::program_options;
+
+    std::string l_Address;
+    uint32 l_Port;
+    uint32 l_Connections;
+    uint32 l_ClientThreads;
+    uint32 l_NetworkThreads;
+    uint32 l_Seconds;
+    uint32 l_Warmup;
+    std::vector<std::string> l_ScenarioNames;
+
+    SteerStone::Core::Network::NetworkSettings l_NetworkSettings;
+    int32 l_FlushMode;
+    bool l_IoUring = false;
+
+    po::options_description l_Options("Benchmark options");
+    l_Options.add_options()
+        ("help,h",                                                                                          "Show this help")
+        ("address",         po::value(&l_Address)->default_value("127.0.0.1"),                              "Address to listen and connect on")
+        ("port",            po::value(&l_Port)->default_value(37999),                                       "Port to listen and connect on")
+        ("connections,c",   po::value(&l_Connections)->default_value(1000),                                 "Loopback connections to open")
+        ("client-threads",  po::value(&l_ClientThreads)->default_value(2),                                  "Threads driving the load client")
+        ("network-threads", po::value(&l_NetworkThreads)->default_value(2),                                 "NetworkThreads of the listener")
+        ("seconds,s",       po::value(&l_Seconds)->default_value(10),                                       "Seconds to measure each scenario")
+        ("warmup",          po::value(&l_Warmup)->default_value(2),                                         "Seconds to run each scenario before measuring")
+        ("scenario",        po::value(&l_ScenarioNames)->multitoken(),                                      "Scenarios to run: chat, status, mixed, bulk (default: all)")
+        ("flush-mode",      po::value(&l_FlushMode)->default_value(1),                                      "0 = timer, 1 = adaptive")
+        ("flush-delay",     po::value(&l_NetworkSettings.Flush.CoalesceDelay)->default_value(60),           "Coalesce delay in milliseconds")
+        ("flush-hot-bytes", po::value(&l_NetworkSettings.Flush.HotBytes)->default_value(4096),               "Adaptive: bytes per hot window which make output hot")
+        ("flush-threshold", po::value(&l_NetworkSettings.Flush.ByteThreshold)->default_value(16384),        "Flush once this many bytes are queued")
+        ("reuse-port",      po::bool_switch(&l_NetworkSettings.ReusePort),                                  "Accept on one SO_REUSEPORT acceptor per NetworkThread")
+        ("io-uring",        po::bool_switch(&l_IoUring),                                                    "Run the NetworkThreads on io_uring instead of the reactor")
+        ("timer-tick",      po::value(&l_NetworkSettings.TimerTick)->default_value(5),                      "Timing wheel resolution in milliseconds")
+        ("read-chunk",      po::value(&l_NetworkSettings.Inbound.ReadChunk)->default_value(4096),           "Free space given to every read, in bytes")
+        ("read-burst",      po::value(&l_NetworkSettings.Inbound.ReadBurst)->default_value(4),              "Reads made on each wakeup before waiting again")
+        ("websocket",       po::bool_switch(&l_NetworkSettings.WebSocket),                                  "Detect WebSocket clients, the load client stays raw")
+        ("balance-interval", po::value(&l_NetworkSettings.Balance.Interval)->default_value(0),              "Milliseconds between two balancer looks, 0 never moves a connection")
+        ("max-connections", po::value(&l_NetworkSettings.Admission.MaxConnections)->default_value(0),       "Connections served at once, 0 for no cap")
+        ("accept-rate",     po::value(&l_NetworkSettings.Admission.Rate)->default_value(0),                 "Connections accepted per second, 0 for no limit");
+
+    po::variables_map l_Variables;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, l_Options), l_Variables);
+        po::notify(l_Variables);
+    }
+    catch (po::error const& l_Error)
+    {
+        std::cerr << l_Error.what() << std::endl << l_Options << std::endl;
+        return -1;
+    }
+
+    if (l_Variables.count("help"))
+    {
+        std::cout << l_Options << std::endl;
+        return 0;
+    }
+
+    l_NetworkSettings.Flush.Mode = static_cast<SteerStone::Core::Network::FlushMode>(l_FlushMode);
+    l_NetworkSettings.Backend = l_IoUring ? SteerStone::Core::Network::NetworkBackend::IoUring : SteerStone::Core::Network::NetworkBackend::Reactor;
+
+    std::vector<SteerStone::Benchmark::Scenario> l_Scenarios;
+    for (SteerStone::Benchmark::Scenario const& l_Scenario : SteerStone::Benchmark::GetDefaultScenarios())
+    {
+        if (l_ScenarioNames.empty() || std::find(l_ScenarioNames.begin(), l_ScenarioNames.end(), l_Scenario.Name) != l_ScenarioNames.end())
+            l_Scenarios.push_back(l_Scenario);
+    }
+
+    if (l_Scenarios.empty())
+    {
+        std::cerr << "No known scenario selected" << std::endl;
+        return -1;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    SteerStone::Core::Network::Listener<SteerStone::Benchmark::EchoSocket> l_Listener(l_Address, l_Port, l_NetworkThreads, l_NetworkSettings);
+
+    SteerStone::Benchmark::LoadClient l_Client(l_ClientThreads);
+
+    const uint32 l_Connected = l_Client.Connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(l_Address), l_Port), l_Connections);
+    if (!l_Connected)
+    {
+        std::cerr << "Could not connect to " << l_Address << ":" << l_Port << std::endl;
+        return -1;
+    }
+
+    printf("%u connections, %u client threads, %u network threads, flush mode %d, delay %u ms, threshold %u bytes, tick %u ms\n\n",
+        l_Connected, l_ClientThreads, l_NetworkThreads, l_FlushMode, l_NetworkSettings.Flush.CoalesceDelay, l_NetworkSettings.Flush.ByteThreshold, l_NetworkSettings.TimerTick);
+
+    printf("%-10s %14s %14s %10s %10s %10s\n", "scenario", "msgs/s", "bytes/s", "p50 us", "p99 us", "p999 us");
+
+    /// Server side counters of each scenario, warm up included
+    std::vector<std::pair<SteerStone::Core::Network::NetworkCountersSnapshot, SteerStone::Core::Network::NetworkCountersSnapshot>> l_Counters;
+
+    for (SteerStone::Benchmark::Scenario const& l_Scenario : l_Scenarios)
+    {
+        SteerStone::Core::Network::NetworkCountersSnapshot l_Before = l_Listener.GetCounters();
+        SteerStone::Benchmark::ScenarioResult l_Result = l_Client.Run(l_Scenario, l_Warmup, l_Seconds);
+        l_Counters.emplace_back(l_Before, l_Listener.GetCounters());
+
+        printf("%-10s %14.0f %14.0f %10u %10u %10u\n", l_Scenario.Name.c_str(),
+            l_Result.Messages / l_Result.Seconds, l_Result.Bytes / l_Result.Seconds,
+            l_Result.GetPercentile(0.50), l_Result.GetPercentile(0.99), l_Result.GetPercentile(0.999));
+    }
+
+    printf("\n%-10s %14s %14s %14s %10s %10s %12s\n", "server", "reads/s", "writes/s", "partial/s", "msgs/write", "grows", "heap allocs");
+
+    for (std::size_t l_I = 0; l_I < l_Scenarios.size(); l_I++)
+    {
+        SteerStone::Core::Network::NetworkCountersSnapshot const& l_Before = l_Counters[l_I].first;
+        SteerStone::Core::Network::NetworkCountersSnapshot const& l_After  = l_Counters[l_I].second;
+
+        const uint64 l_WriteCalls = l_After.WriteCalls - l_Before.WriteCalls;
+
+        printf("%-10s %14.0f %14.0f %14.0f %10.1f %10llu %12llu\n", l_Scenarios[l_I].Name.c_str(),
+            l_After.GetRate(&SteerStone::Core::Network::NetworkCountersSnapshot::ReadCalls, l_Before),
+            l_After.GetRate(&SteerStone::Core::Network::NetworkCountersSnapshot::WriteCalls, l_Before),
+            l_After.GetRate(&SteerStone::Core::Network::NetworkCountersSnapshot::PartialWrites, l_Before),
+            l_WriteCalls ? static_cast<double>(l_After.MessagesOut - l_Before.MessagesOut) / l_WriteCalls : 0.0,
+            static_cast<unsigned long long>(l_After.BufferGrows - l_Before.BufferGrows),
+            static_cast<unsigned long long>(l_After.HandlerHeapAllocs - l_Before.HandlerHeapAllocs));
+    }
+
+    return 0;
+}
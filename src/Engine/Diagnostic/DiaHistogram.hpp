@@ -0,0 +1,144 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <PCH/Precompiled.hpp>
+#include <array>
+#include "Core/Core.hpp"
+
+#define HISTOGRAM_BUCKET_COUNT 24
+
+namespace SteerStone { namespace Core { namespace Diagnostic {
+
+    /// Fixed size histogram with power of two buckets
+    /// Bucket 0 holds 0, bucket N holds values in [2^(N-1), 2^N), the last bucket holds everything above
+    class Histogram
+    {
+    public:
+        /// Constructor
+        Histogram()
+            : m_Count(0), m_Max(0)
+        {
+            m_Buckets.fill(0);
+        }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+        /// Record a value
+        /// @p_Value : Value to record
+        void Record(uint64 const p_Value)
+        {
+            m_Buckets[GetBucketIndex(p_Value)]++;
+            m_Count++;
+
+            if (p_Value > m_Max)
+                m_Max = p_Value;
+        }
+        /// Add values straight into a bucket, to rebuild a histogram from buckets counted elsewhere
+        /// @p_Bucket : Bucket index
+        /// @p_Count  : Amount of values
+        /// @p_Max    : Largest of those values
+        void AddBucket(std::size_t const p_Bucket, uint32 const p_Count, uint64 const p_Max)
+        {
+            m_Buckets[p_Bucket] += p_Count;
+            m_Count += p_Count;
+
+            if (p_Count && p_Max > m_Max)
+                m_Max = p_Max;
+        }
+        /// Add the values of another histogram into this one
+        /// @p_Other : Histogram to merge
+        void Merge(Histogram const& p_Other)
+        {
+            for (std::size_t l_I = 0; l_I < HISTOGRAM_BUCKET_COUNT; l_I++)
+                m_Buckets[l_I] += p_Other.m_Buckets[l_I];
+
+            m_Count += p_Other.m_Count;
+
+            if (p_Other.m_Max > m_Max)
+                m_Max = p_Other.m_Max;
+        }
+        /// Reset all buckets
+        void Reset()
+        {
+            m_Buckets.fill(0);
+            m_Count = 0;
+            m_Max = 0;
+        }
+
+        /// Get the upper bound of the bucket holding the given percentile
+        /// @p_Percentile : 0.0 - 1.0
+        uint64 GetPercentile(double const p_Percentile) const
+        {
+            if (!m_Count)
+                return 0;
+
+            const uint64 l_Target = static_cast<uint64>(p_Percentile * m_Count);
+            uint64 l_Seen = 0;
+
+            for (std::size_t l_I = 0; l_I < HISTOGRAM_BUCKET_COUNT; l_I++)
+            {
+                l_Seen += m_Buckets[l_I];
+
+                if (l_Seen > l_Target)
+                    return l_I == HISTOGRAM_BUCKET_COUNT - 1 ? m_Max : (uint64(1) << l_I) - 1;
+            }
+
+            return m_Max;
+        }
+        /// Get amount of recorded values
+        uint64 GetCount() const
+        {
+            return m_Count;
+        }
+        /// Get largest recorded value
+        uint64 GetMax() const
+        {
+            return m_Max;
+        }
+        /// Get the bucket a value is recorded in
+        /// @p_Value : Value
+        static std::size_t GetBucketIndex(uint64 const p_Value)
+        {
+            std::size_t l_Bucket = 0;
+            for (uint64 l_Value = p_Value; l_Value && l_Bucket < HISTOGRAM_BUCKET_COUNT - 1; l_Value >>= 1)
+                l_Bucket++;
+
+            return l_Bucket;
+        }
+        /// Get amount of values in a bucket
+        /// @p_Bucket : Bucket index
+        uint32 GetBucket(std::size_t const p_Bucket) const
+        {
+            return m_Buckets[p_Bucket];
+        }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    private:
+        std::array<uint32, HISTOGRAM_BUCKET_COUNT> m_Buckets;  ///< Buckets
+        uint64 m_Count;                                         ///< Recorded values
+        uint64 m_Max;                                           ///< Largest recorded value
+    };
+
+}   ///< namespace Diagnostic
+}   ///< namespace Core
+}   ///< namespace SteerStone
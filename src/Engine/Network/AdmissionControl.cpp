@@ -0,0 +1,191 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "AdmissionControl.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Get the capacity of a bucket in thousandths, its burst or its rate when no burst is set
+    /// @p_Rate  : Tokens per second
+    /// @p_Burst : Tokens held at most
+    static uint32 GetBucketCapacity(uint32 const p_Rate, uint32 const p_Burst)
+    {
+        return std::min<uint32>(std::max<uint32>(p_Burst ? p_Burst : p_Rate, 1), 4000000) * 1000;
+    }
+
+    /// Constructor
+    /// @p_Policy : Policy
+    AdmissionControl::AdmissionControl(AdmissionPolicy const& p_Policy)
+        : m_Policy(p_Policy), m_Capacity(GetBucketCapacity(p_Policy.Rate, p_Policy.Burst)),
+        m_PerIPCapacity(GetBucketCapacity(p_Policy.PerIPRate, p_Policy.PerIPBurst)), m_Start(std::chrono::steady_clock::now()),
+        m_Connections(0), m_Global{ 0, m_Capacity }, m_Mask(0)
+    {
+        if (!m_Policy.PerIPRate)
+            return;
+
+        std::size_t l_Slots = ADMISSION_PROBE_LIMIT;
+        while (l_Slots < m_Policy.PerIPSlots)
+            l_Slots <<= 1;
+
+        m_Slots.assign(l_Slots, Slot{ 0, { 0, 0 } });
+        m_Mask = l_Slots - 1;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Decide if a connection from p_Address is served, from any accepting thread
+    /// MaxConnections may be passed by one connection per thread accepting at the same time
+    /// @p_Address : Remote address
+    AdmissionResult AdmissionControl::Admit(boost::asio::ip::address const& p_Address)
+    {
+        if (m_Policy.MaxConnections && m_Connections.load(std::memory_order_relaxed) >= m_Policy.MaxConnections)
+            return AdmissionResult::Full;
+
+        if (!m_Policy.Rate && !m_Policy.PerIPRate)
+            return AdmissionResult::Admitted;
+
+        const uint32 l_Now = GetNow();
+
+        std::lock_guard<std::mutex> l_Guard(m_Lock);
+
+        /// Address first, one address flooding us must not use up the tokens of everyone else
+        if (m_Policy.PerIPRate && !Take(FindSlot(GetKey(p_Address), l_Now).Tokens, l_Now, m_Policy.PerIPRate, m_PerIPCapacity))
+            return AdmissionResult::AddressRateLimited;
+
+        if (m_Policy.Rate && !Take(m_Global, l_Now, m_Policy.Rate, m_Capacity))
+            return AdmissionResult::RateLimited;
+
+        return AdmissionResult::Admitted;
+    }
+    /// Count a connection being served
+    void AdmissionControl::Add()
+    {
+        m_Connections.fetch_add(1, std::memory_order_relaxed);
+    }
+    /// Stop counting a connection given to Add
+    void AdmissionControl::Release()
+    {
+        m_Connections.fetch_sub(1, std::memory_order_relaxed);
+    }
+    /// Get the connections being served
+    uint32 AdmissionControl::GetConnections() const
+    {
+        return m_Connections.load(std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get the table key of an address, IPv6 clients are keyed by their /64 which one host usually owns whole
+    /// @p_Address : Address
+    uint64 AdmissionControl::GetKey(boost::asio::ip::address const& p_Address)
+    {
+        if (p_Address.is_v4())
+            return (1ull << 63) | p_Address.to_v4().to_uint();
+
+        const boost::asio::ip::address_v6 l_Address = p_Address.to_v6();
+
+        /// Dual stack acceptors see IPv4 clients as mapped addresses
+        if (l_Address.is_v4_mapped())
+            return GetKey(boost::asio::ip::make_address_v4(boost::asio::ip::v4_mapped, l_Address));
+
+        const boost::asio::ip::address_v6::bytes_type l_Bytes = l_Address.to_bytes();
+
+        uint64 l_Key = 0;
+        for (std::size_t l_I = 0; l_I < 8; l_I++)
+            l_Key = (l_Key << 8) | l_Bytes[l_I];
+
+        /// The top bit is never set in unicast IPv6, so keys never meet IPv4 ones; 0 marks free slots
+        return l_Key ? l_Key : 1;
+    }
+    /// Refill a bucket and take a token from it, false if it is empty
+    /// @p_Bucket   : Bucket
+    /// @p_Now      : Milliseconds since our start
+    /// @p_Rate     : Tokens per second
+    /// @p_Capacity : Most tokens it holds, in thousandths
+    bool AdmissionControl::Take(Bucket& p_Bucket, uint32 const p_Now, uint32 const p_Rate, uint32 const p_Capacity)
+    {
+        /// A rate of N per second is N thousandths per millisecond
+        const uint64 l_Elapsed  = static_cast<uint32>(p_Now - p_Bucket.Stamp);
+        const uint64 l_Tokens   = std::min<uint64>(p_Bucket.Tokens + l_Elapsed * p_Rate, p_Capacity);
+
+        p_Bucket.Stamp = p_Now;
+
+        if (l_Tokens < 1000)
+        {
+            p_Bucket.Tokens = static_cast<uint32>(l_Tokens);
+            return false;
+        }
+
+        p_Bucket.Tokens = static_cast<uint32>(l_Tokens - 1000);
+        return true;
+    }
+    /// Find the slot of a key, taking over a free, idle or the stalest slot of its probe window
+    /// @p_Key : Key
+    /// @p_Now : Milliseconds since our start
+    AdmissionControl::Slot& AdmissionControl::FindSlot(uint64 const p_Key, uint32 const p_Now)
+    {
+        const uint64 l_Hash = (p_Key * 0x9E3779B97F4A7C15ull) >> 32;
+
+        /// The whole window first, taking over an earlier slot would hand the address a full bucket
+        for (uint32 l_I = 0; l_I < ADMISSION_PROBE_LIMIT; l_I++)
+        {
+            Slot& l_Slot = m_Slots[(l_Hash + l_I) & m_Mask];
+            if (l_Slot.Key == p_Key)
+                return l_Slot;
+        }
+
+        Slot* l_Stalest = nullptr;
+        uint32 l_StalestAge = 0;
+
+        for (uint32 l_I = 0; l_I < ADMISSION_PROBE_LIMIT; l_I++)
+        {
+            Slot& l_Slot = m_Slots[(l_Hash + l_I) & m_Mask];
+            const uint32 l_Age = p_Now - l_Slot.Tokens.Stamp;
+
+            /// Free, or idle long enough to have a full bucket, forgetting it changes nothing
+            if (!l_Slot.Key || l_Slot.Tokens.Tokens + static_cast<uint64>(l_Age) * m_Policy.PerIPRate >= m_PerIPCapacity)
+            {
+                l_Stalest = &l_Slot;
+                break;
+            }
+
+            if (!l_Stalest || l_Age > l_StalestAge)
+            {
+                l_Stalest       = &l_Slot;
+                l_StalestAge    = l_Age;
+            }
+        }
+
+        l_Stalest->Key      = p_Key;
+        l_Stalest->Tokens   = Bucket{ p_Now, m_PerIPCapacity };
+
+        return *l_Stalest;
+    }
+    /// Get milliseconds since our start, wraps after 49 days which buckets refilled long before do not notice
+    uint32 AdmissionControl::GetNow() const
+    {
+        return static_cast<uint32>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_Start).count());
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
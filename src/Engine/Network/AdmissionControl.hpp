@@ -0,0 +1,117 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "Core/Core.hpp"
+#include "AdmissionPolicy.hpp"
+
+#define ADMISSION_PROBE_LIMIT 8             ///< Slots of the address table looked at before the stalest one is taken over
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Why a connection was turned away
+    enum class AdmissionResult : uint8
+    {
+        Admitted,                           ///< Served
+        Full,                               ///< MaxConnections reached
+        RateLimited,                        ///< Too many connections from everyone
+        AddressRateLimited                  ///< Too many connections from this address
+    };
+
+    /// Admission control shared by every acceptor of a Listener
+    /// Decides on the bare accepted descriptor, so a connection turned away never costs us its socket state;
+    /// addresses are tracked in a fixed open addressing table, an address idle long enough to have a full bucket
+    /// is as good as untracked and its slot is taken by the next one
+    class AdmissionControl
+    {
+        DISALLOW_COPY_AND_ASSIGN(AdmissionControl);
+
+        /// Token bucket, in thousandths of a connection
+        struct Bucket
+        {
+            uint32 Stamp;                   ///< Milliseconds since our start at the last refill
+            uint32 Tokens;                  ///< Tokens left
+        };
+        /// Slot of the address table
+        struct Slot
+        {
+            uint64 Key;                     ///< Address key, 0 when free
+            Bucket Tokens;                  ///< Bucket of the address
+        };
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            /// @p_Policy : Policy
+            explicit AdmissionControl(AdmissionPolicy const& p_Policy);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Decide if a connection from p_Address is served, from any accepting thread
+            /// MaxConnections may be passed by one connection per thread accepting at the same time
+            /// @p_Address : Remote address
+            AdmissionResult Admit(boost::asio::ip::address const& p_Address);
+            /// Count a connection being served
+            void Add();
+            /// Stop counting a connection given to Add
+            void Release();
+            /// Get the connections being served
+            uint32 GetConnections() const;
+
+        private:
+            /// Get the table key of an address, IPv6 clients are keyed by their /64 which one host usually owns whole
+            /// @p_Address : Address
+            static uint64 GetKey(boost::asio::ip::address const& p_Address);
+            /// Refill a bucket and take a token from it, false if it is empty
+            /// @p_Bucket   : Bucket
+            /// @p_Now      : Milliseconds since our start
+            /// @p_Rate     : Tokens per second
+            /// @p_Capacity : Most tokens it holds, in thousandths
+            static bool Take(Bucket& p_Bucket, uint32 const p_Now, uint32 const p_Rate, uint32 const p_Capacity);
+            /// Find the slot of a key, taking over a free, idle or the stalest slot of its probe window
+            /// @p_Key : Key
+            /// @p_Now : Milliseconds since our start
+            Slot& FindSlot(uint64 const p_Key, uint32 const p_Now);
+            /// Get milliseconds since our start
+            uint32 GetNow() const;
+
+        private:
+            AdmissionPolicy const m_Policy;                                         ///< Policy
+            uint32 const m_Capacity;                                                ///< Capacity of m_Global, in thousandths
+            uint32 const m_PerIPCapacity;                                           ///< Capacity of every address bucket, in thousandths
+            std::chrono::steady_clock::time_point const m_Start;                    ///< Time our stamps count from
+            std::atomic<uint32> m_Connections;                                      ///< Connections being served
+            std::mutex m_Lock;                                                      ///< Guards the buckets
+            Bucket m_Global;                                                        ///< Bucket shared by every address
+            std::vector<Slot> m_Slots;                                              ///< Address table
+            uint64 m_Mask;                                                          ///< Slots - 1
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
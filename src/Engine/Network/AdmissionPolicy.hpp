@@ -0,0 +1,39 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Decides which accepted connections are served and which are turned away
+    /// Rates are token buckets: a connection takes a token, tokens come back at Rate per second up to Burst
+    struct AdmissionPolicy
+    {
+        uint32 MaxConnections   = 0;                        ///< Connections served at once, 0 for no cap
+        uint32 Rate             = 0;                        ///< Connections accepted per second, 0 for no limit
+        uint32 Burst            = 0;                        ///< Connections accepted back to back before Rate applies, 0 takes Rate
+        uint32 PerIPRate        = 0;                        ///< Connections accepted per second from one address, 0 for no limit
+        uint32 PerIPBurst       = 0;                        ///< Connections accepted back to back from one address, 0 takes PerIPRate
+        uint32 PerIPSlots       = 4096;                     ///< Addresses tracked at once, rounded up to a power of two
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,36 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Decides when the Listener moves connections off a busy NetworkThread
+    struct BalancePolicy
+    {
+        uint32 Interval         = 0;                        ///< Milliseconds between two looks at the NetworkThreads, 0 never moves a connection
+        uint32 Threshold        = 25;                       ///< Percent a NetworkThread must be busier than the average before connections leave it
+        uint32 MinLoad          = 50;                       ///< Percent of a core the busiest NetworkThread must use before it is worth balancing, where threads have a CPU clock
+        uint32 MaxMigrations    = 16;                       ///< Most connections moved in one look
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
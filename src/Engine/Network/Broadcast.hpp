@@ -0,0 +1,56 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+#include "Socket.hpp"
+#include "SharedPayload.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Queue one payload on every socket of a range, closed sockets are skipped
+    /// @p_Sockets : Range of shared or raw socket pointers
+    /// @p_Payload : Payload, serialized once by the caller
+    template<typename Range> std::size_t Broadcast(Range const& p_Sockets, SharedPayload::Ptr const& p_Payload)
+    {
+        std::size_t l_Count = 0;
+
+        for (auto const& l_Socket : p_Sockets)
+        {
+            if (!l_Socket || l_Socket->IsClosed())
+                continue;
+
+            l_Socket->Write(p_Payload);
+            l_Count++;
+        }
+
+        return l_Count;
+    }
+    /// Serialize a message once and queue it on every socket of a range
+    /// @p_Sockets : Range of shared or raw socket pointers
+    /// @p_Buffer  : Buffer which holds the data
+    /// @p_Length  : The length of the data
+    template<typename Range> std::size_t Broadcast(Range const& p_Sockets, char const* p_Buffer, std::size_t const p_Length)
+    {
+        return Broadcast(p_Sockets, SharedPayload::Create(p_Buffer, p_Length));
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,46 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Flush Modes
+    enum class FlushMode
+    {
+        Timer,                      ///< Always wait CoalesceDelay before flushing
+        Adaptive                    ///< Flush at once unless output is hot, then coalesce for HotWindow at most
+    };
+
+    /// Decides when buffered output is handed to the kernel
+    struct FlushPolicy
+    {
+        FlushMode Mode          = FlushMode::Adaptive;  ///< Flush mode
+        uint32 CoalesceDelay    = 60;                   ///< Milliseconds to wait before flushing (Timer, Adaptive waits HotWindow at most)
+        uint32 HotWindow        = 5;                    ///< Adaptive: milliseconds output rate is measured over, and the longest hot wait
+        uint32 HotBytes         = 4096;                 ///< Adaptive: output is hot once this many bytes were flushed within HotWindow
+        uint32 ByteThreshold    = 16384;                ///< Flush at once when this many bytes are buffered
+        bool NoDelay            = true;                 ///< Set TCP_NODELAY on accepted sockets
+        bool Cork               = false;                ///< Hold TCP_CORK while a send is in flight (Linux only)
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,64 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Non-owning view over a complete frame which still lives inside the socket in buffer
+    /// The view is only valid until the handler returns, the next read may overwrite the bytes
+    class FrameView
+    {
+        public:
+            /// Constructor
+            /// @p_Data   : Start of the frame body
+            /// @p_Length : Length of the frame body
+            FrameView(uint8 const* p_Data, std::size_t const p_Length)
+                : m_Data(p_Data), m_Length(p_Length)
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get the start of the frame body
+            uint8 const* GetData() const
+            {
+                return m_Data;
+            }
+            /// Get the length of the frame body
+            std::size_t GetSize() const
+            {
+                return m_Length;
+            }
+            /// Check if the frame has no body
+            bool IsEmpty() const
+            {
+                return m_Length == 0;
+            }
+
+        private:
+            uint8 const* m_Data;        ///< Start of the frame body
+            std::size_t m_Length;       ///< Length of the frame body
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
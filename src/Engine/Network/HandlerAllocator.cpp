@@ -0,0 +1,108 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "HandlerAllocator.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Blocks of HANDLER_SLOT_SIZE given back on this thread, handed out again before the heap is used
+    /// A block may be freed on another thread than the one it was taken on, every block has the same size
+    struct HandlerCache
+    {
+        /// Deconstructor
+        ~HandlerCache()
+        {
+            for (std::size_t l_I = 0; l_I < Count; l_I++)
+                ::operator delete(Blocks[l_I]);
+        }
+
+        std::array<void*, HANDLER_CACHE_SIZE> Blocks;   ///< Free blocks
+        std::size_t Count = 0;                          ///< Free blocks in Blocks
+    };
+
+    static thread_local HandlerCache s_HandlerCache;
+
+    /// Used by allocators which were never given a counter
+    static PaddedCounter s_DefaultHeapAllocs;
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    HandlerAllocator::HandlerAllocator()
+        : m_HeapAllocs(&s_DefaultHeapAllocs)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set the counter of handler memory taken from the heap
+    /// @p_Counter : Counter, must outlive the allocator
+    void HandlerAllocator::SetHeapCounter(PaddedCounter* p_Counter)
+    {
+        m_HeapAllocs = p_Counter;
+    }
+
+    /// Get memory for a handler
+    /// @p_Slot : Operation kind
+    /// @p_Size : Size of the handler
+    void* HandlerAllocator::Allocate(HandlerSlot const p_Slot, std::size_t const p_Size)
+    {
+        if (p_Size <= HANDLER_SLOT_SIZE)
+        {
+            Slot& l_Slot = m_Slots[p_Slot];
+            if (!l_Slot.InUse.exchange(true, std::memory_order_acquire))
+                return &l_Slot.Storage;
+
+            if (s_HandlerCache.Count)
+                return s_HandlerCache.Blocks[--s_HandlerCache.Count];
+        }
+
+        m_HeapAllocs->Add(1);
+
+        /// Small handlers get a full block, so it can go to the cache when it is given back
+        return ::operator new(std::max<std::size_t>(p_Size, HANDLER_SLOT_SIZE));
+    }
+    /// Give back memory of a handler
+    /// @p_Pointer : Memory
+    /// @p_Size    : Size it was allocated with
+    void HandlerAllocator::Deallocate(void* p_Pointer, std::size_t const p_Size)
+    {
+        for (Slot& l_Slot : m_Slots)
+        {
+            if (p_Pointer != &l_Slot.Storage)
+                continue;
+
+            l_Slot.InUse.store(false, std::memory_order_release);
+            return;
+        }
+
+        if (p_Size <= HANDLER_SLOT_SIZE && s_HandlerCache.Count < HANDLER_CACHE_SIZE)
+        {
+            s_HandlerCache.Blocks[s_HandlerCache.Count++] = p_Pointer;
+            return;
+        }
+
+        ::operator delete(p_Pointer);
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,184 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#include "Core/Core.hpp"
+#include "NetworkCounters.hpp"
+
+#define HANDLER_SLOT_SIZE 256               ///< Largest handler a slot or a cached block holds
+#define HANDLER_CACHE_SIZE 64               ///< Blocks each thread keeps for handlers which found their slot busy
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Operation kinds, each has a slot of its own so they never compete for memory
+    enum HandlerSlot
+    {
+        HandlerSlot_Read,                   ///< Wait for the socket to be readable
+        HandlerSlot_Write,                  ///< Gather write
+        HandlerSlot_Max
+    };
+
+    /// Handler memory of one socket
+    /// Each operation kind has its own block, a handler which finds its block busy (or is too large
+    /// for it) takes one from a per thread cache, and only goes to the heap when that is empty.
+    /// Slots are claimed with an atomic flag, completions may run on any thread of the service.
+    class HandlerAllocator
+    {
+        DISALLOW_COPY_AND_ASSIGN(HandlerAllocator);
+
+        /// Memory of one operation kind, alone on its cache lines
+        struct alignas(NETWORK_CACHE_LINE_SIZE) Slot
+        {
+            std::aligned_storage<HANDLER_SLOT_SIZE, alignof(std::max_align_t)>::type Storage;     ///< Handler memory
+            std::atomic<bool> InUse{ false };                                                       ///< Storage is lent out
+        };
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            HandlerAllocator();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set the counter of handler memory taken from the heap
+            /// @p_Counter : Counter, must outlive the allocator
+            void SetHeapCounter(PaddedCounter* p_Counter);
+
+            /// Get memory for a handler
+            /// @p_Slot : Operation kind
+            /// @p_Size : Size of the handler
+            void* Allocate(HandlerSlot const p_Slot, std::size_t const p_Size);
+            /// Give back memory of a handler
+            /// @p_Pointer : Memory
+            /// @p_Size    : Size it was allocated with
+            void Deallocate(void* p_Pointer, std::size_t const p_Size);
+
+        private:
+            std::array<Slot, HandlerSlot_Max> m_Slots;      ///< One slot per operation kind
+            PaddedCounter* m_HeapAllocs;                    ///< Handler memory taken from the heap
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Standard allocator over one slot of a HandlerAllocator, associated with our handlers
+    /// Asio takes the memory of an operation from the associated allocator of its handler
+    template <typename T> class HandlerSlotAllocator
+    {
+        template <typename U> friend class HandlerSlotAllocator;
+
+        public:
+            using value_type = T;
+
+            /// Constructor
+            /// @p_Allocator : Allocator, must outlive the operation
+            /// @p_Slot      : Operation kind
+            HandlerSlotAllocator(HandlerAllocator& p_Allocator, HandlerSlot const p_Slot)
+                : m_Allocator(&p_Allocator), m_Slot(p_Slot)
+            {
+            }
+            /// Rebind constructor, asio rebinds us to the type of each operation
+            /// @p_Other : Allocator of another type
+            template <typename U> HandlerSlotAllocator(HandlerSlotAllocator<U> const& p_Other)
+                : m_Allocator(p_Other.m_Allocator), m_Slot(p_Other.m_Slot)
+            {
+            }
+
+            /// Get memory for p_Count objects
+            /// @p_Count : Objects
+            T* allocate(std::size_t const p_Count)
+            {
+                return static_cast<T*>(m_Allocator->Allocate(m_Slot, p_Count * sizeof(T)));
+            }
+            /// Give back memory of p_Count objects
+            /// @p_Pointer : Memory
+            /// @p_Count   : Objects it was allocated for
+            void deallocate(T* p_Pointer, std::size_t const p_Count)
+            {
+                m_Allocator->Deallocate(p_Pointer, p_Count * sizeof(T));
+            }
+
+            /// Allocators are equal when they lend the same slot
+            template <typename U> bool operator==(HandlerSlotAllocator<U> const& p_Other) const
+            {
+                return m_Allocator == p_Other.m_Allocator && m_Slot == p_Other.m_Slot;
+            }
+            template <typename U> bool operator!=(HandlerSlotAllocator<U> const& p_Other) const
+            {
+                return !(*this == p_Other);
+            }
+
+        private:
+            HandlerAllocator* m_Allocator;      ///< Allocator
+            HandlerSlot m_Slot;                 ///< Operation kind
+    };
+
+    /// Wraps a completion handler so asio takes its memory from a HandlerAllocator
+    /// Calls are forwarded to the wrapped handler
+    template <typename Handler> class AllocHandler
+    {
+        public:
+            using allocator_type = HandlerSlotAllocator<void>;
+
+            /// Constructor
+            /// @p_Allocator : Allocator, must outlive the operation
+            /// @p_Slot      : Operation kind
+            /// @p_Handler   : Handler
+            AllocHandler(HandlerAllocator& p_Allocator, HandlerSlot const p_Slot, Handler p_Handler)
+                : m_Allocator(p_Allocator, p_Slot), m_Handler(std::move(p_Handler))
+            {
+            }
+
+            /// Invoke the handler
+            template <typename... Args> void operator()(Args&&... p_Args)
+            {
+                m_Handler(std::forward<Args>(p_Args)...);
+            }
+
+            /// Get our associated allocator, asio frees the memory before the handler is invoked
+            allocator_type get_allocator() const noexcept
+            {
+                return m_Allocator;
+            }
+
+        private:
+            allocator_type m_Allocator;         ///< Slot our operation takes its memory from
+            Handler m_Handler;                  ///< Handler
+    };
+
+    /// Wrap a completion handler so asio takes its memory from p_Allocator
+    /// @p_Allocator : Allocator, must outlive the operation
+    /// @p_Slot      : Operation kind
+    /// @p_Handler   : Handler
+    template <typename Handler> inline AllocHandler<Handler> MakeAllocHandler(HandlerAllocator& p_Allocator, HandlerSlot const p_Slot, Handler p_Handler)
+    {
+        return AllocHandler<Handler>(p_Allocator, p_Slot, std::move(p_Handler));
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
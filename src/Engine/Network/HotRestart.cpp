@@ -0,0 +1,323 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "HotRestart.hpp"
+
+#ifdef NETWORK_HAS_HOT_RESTART
+    #include <cstring>
+    #include <sys/socket.h>
+    #include <sys/time.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+namespace SteerStone { namespace Core { namespace Network {
+
+#ifdef NETWORK_HAS_HOT_RESTART
+
+    /// Record types
+    enum class HotRestartRecordType : uint16
+    {
+        Acceptor,                           ///< Listening descriptor attached
+        Socket,                             ///< Client descriptor attached, buffered bytes follow
+        End                                 ///< Nothing follows, acknowledge
+    };
+
+    /// Header of every record, one message
+    struct HotRestartRecord
+    {
+        uint32 Magic;                       ///< HOT_RESTART_MAGIC
+        uint16 Version;                     ///< HOT_RESTART_VERSION
+        HotRestartRecordType Type;          ///< Type
+        uint64 SessionId;                   ///< Session of a client
+        uint32 InLength;                    ///< Unhandled bytes which follow
+        uint32 OutLength;                   ///< Unsent bytes which follow
+        uint8 Transport;                    ///< Transport of a client
+        uint32 TransportLength;             ///< Transport state bytes which follow
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Send a record header, with a descriptor if p_Fd is not -1
+    /// @p_Channel : Channel
+    /// @p_Record  : Header
+    /// @p_Fd      : Descriptor
+    static bool SendRecord(int const p_Channel, HotRestartRecord const& p_Record, int const p_Fd)
+    {
+        iovec l_Data{ const_cast<HotRestartRecord*>(&p_Record), sizeof(p_Record) };
+
+        msghdr l_Message{};
+        l_Message.msg_iov       = &l_Data;
+        l_Message.msg_iovlen    = 1;
+
+        alignas(cmsghdr) char l_Control[CMSG_SPACE(sizeof(int))];
+        if (p_Fd != -1)
+        {
+            memset(l_Control, 0, sizeof(l_Control));
+            l_Message.msg_control       = l_Control;
+            l_Message.msg_controllen    = sizeof(l_Control);
+
+            cmsghdr* l_Header   = CMSG_FIRSTHDR(&l_Message);
+            l_Header->cmsg_level = SOL_SOCKET;
+            l_Header->cmsg_type  = SCM_RIGHTS;
+            l_Header->cmsg_len   = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(l_Header), &p_Fd, sizeof(int));
+        }
+
+        return sendmsg(p_Channel, &l_Message, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(p_Record));
+    }
+    /// Receive a record header and the descriptor attached to it, -1 if none
+    /// @p_Channel : Channel
+    /// @p_Record  : Header
+    /// @p_Fd      : Descriptor
+    static bool ReceiveRecord(int const p_Channel, HotRestartRecord& p_Record, int& p_Fd)
+    {
+        iovec l_Data{ &p_Record, sizeof(p_Record) };
+
+        alignas(cmsghdr) char l_Control[CMSG_SPACE(sizeof(int))];
+
+        msghdr l_Message{};
+        l_Message.msg_iov           = &l_Data;
+        l_Message.msg_iovlen        = 1;
+        l_Message.msg_control       = l_Control;
+        l_Message.msg_controllen    = sizeof(l_Control);
+
+        p_Fd = -1;
+
+        const ssize_t l_Length = recvmsg(p_Channel, &l_Message, MSG_CMSG_CLOEXEC);
+
+        for (cmsghdr* l_Header = CMSG_FIRSTHDR(&l_Message); l_Header; l_Header = CMSG_NXTHDR(&l_Message, l_Header))
+        {
+            if (l_Header->cmsg_level == SOL_SOCKET && l_Header->cmsg_type == SCM_RIGHTS)
+                memcpy(&p_Fd, CMSG_DATA(l_Header), sizeof(int));
+        }
+
+        if (l_Length != static_cast<ssize_t>(sizeof(p_Record)) || (l_Message.msg_flags & (MSG_TRUNC | MSG_CTRUNC))
+            || p_Record.Magic != HOT_RESTART_MAGIC || p_Record.Version != HOT_RESTART_VERSION)
+        {
+            if (p_Fd != -1)
+                close(p_Fd);
+
+            return false;
+        }
+
+        return true;
+    }
+    /// Send buffered bytes, split in messages of HOT_RESTART_MESSAGE_SIZE
+    /// @p_Channel : Channel
+    /// @p_Bytes   : Bytes
+    static bool SendPayload(int const p_Channel, std::vector<uint8> const& p_Bytes)
+    {
+        for (std::size_t l_Sent = 0; l_Sent < p_Bytes.size();)
+        {
+            const std::size_t l_Length = std::min<std::size_t>(p_Bytes.size() - l_Sent, HOT_RESTART_MESSAGE_SIZE);
+
+            if (send(p_Channel, p_Bytes.data() + l_Sent, l_Length, MSG_NOSIGNAL) != static_cast<ssize_t>(l_Length))
+                return false;
+
+            l_Sent += l_Length;
+        }
+
+        return true;
+    }
+    /// Receive p_Length buffered bytes
+    /// @p_Channel : Channel
+    /// @p_Length  : Bytes expected
+    /// @p_Bytes   : Bytes
+    static bool ReceivePayload(int const p_Channel, std::size_t const p_Length, std::vector<uint8>& p_Bytes)
+    {
+        p_Bytes.resize(p_Length);
+
+        for (std::size_t l_Received = 0; l_Received < p_Length;)
+        {
+            const std::size_t l_Expected = std::min<std::size_t>(p_Length - l_Received, HOT_RESTART_MESSAGE_SIZE);
+
+            if (recv(p_Channel, p_Bytes.data() + l_Received, l_Expected, 0) != static_cast<ssize_t>(l_Expected))
+                return false;
+
+            l_Received += l_Expected;
+        }
+
+        return true;
+    }
+    /// Give up on a blocking call after HOT_RESTART_TIMEOUT
+    /// @p_Channel : Channel
+    static void SetTimeout(int const p_Channel)
+    {
+        timeval l_Timeout{ HOT_RESTART_TIMEOUT, 0 };
+        setsockopt(p_Channel, SOL_SOCKET, SO_RCVTIMEO, &l_Timeout, sizeof(l_Timeout));
+        setsockopt(p_Channel, SOL_SOCKET, SO_SNDTIMEO, &l_Timeout, sizeof(l_Timeout));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Connect to the process waiting on p_Path and take its state
+    /// Returns false if no process waits there or the transfer failed, nothing is kept then
+    /// @p_Path  : Unix socket path
+    /// @p_State : Received state, we own its descriptors
+    bool HotRestart::Receive(std::string const& p_Path, HotRestartState& p_State)
+    {
+        sockaddr_un l_Address{};
+        if (p_Path.size() >= sizeof(l_Address.sun_path))
+            return false;
+
+        l_Address.sun_family = AF_UNIX;
+        memcpy(l_Address.sun_path, p_Path.c_str(), p_Path.size());
+
+        const int l_Channel = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (l_Channel == -1)
+            return false;
+
+        /// Nobody there, this is a cold start
+        if (connect(l_Channel, reinterpret_cast<sockaddr*>(&l_Address), sizeof(l_Address)) == -1)
+        {
+            close(l_Channel);
+            return false;
+        }
+
+        SetTimeout(l_Channel);
+
+        bool l_Complete = false;
+        for (;;)
+        {
+            HotRestartRecord l_Record;
+            int l_Fd = -1;
+
+            if (!ReceiveRecord(l_Channel, l_Record, l_Fd))
+                break;
+
+            if (l_Record.Type == HotRestartRecordType::End)
+            {
+                l_Complete = true;
+                break;
+            }
+
+            if (l_Fd == -1)
+                break;
+
+            if (l_Record.Type == HotRestartRecordType::Acceptor)
+            {
+                p_State.Acceptors.push_back(l_Fd);
+                continue;
+            }
+
+            p_State.Sockets.emplace_back();
+            SocketHandoff& l_Handoff = p_State.Sockets.back();
+            l_Handoff.Fd        = l_Fd;
+            l_Handoff.SessionId = l_Record.SessionId;
+            l_Handoff.Transport = l_Record.Transport;
+
+            if (!ReceivePayload(l_Channel, l_Record.InLength, l_Handoff.InBuffer) || !ReceivePayload(l_Channel, l_Record.OutLength, l_Handoff.OutQueue)
+                || !ReceivePayload(l_Channel, l_Record.TransportLength, l_Handoff.TransportState))
+                break;
+        }
+
+        /// The acknowledgement tells the old process it may let go of its descriptors
+        const uint8 l_Ack = 1;
+        if (!l_Complete || send(l_Channel, &l_Ack, sizeof(l_Ack), MSG_NOSIGNAL) != sizeof(l_Ack))
+        {
+            close(l_Channel);
+            Close(p_State);
+            return false;
+        }
+
+        close(l_Channel);
+        return true;
+    }
+    /// Send our state over a channel accepted from our successor, blocking
+    /// Returns true once the successor acknowledged it; our descriptors are left open either way
+    /// @p_Channel : Connected unix socket
+    /// @p_State   : State to send
+    bool HotRestart::Send(int const p_Channel, HotRestartState const& p_State)
+    {
+        SetTimeout(p_Channel);
+
+        HotRestartRecord l_Record{};
+        l_Record.Magic      = HOT_RESTART_MAGIC;
+        l_Record.Version    = HOT_RESTART_VERSION;
+
+        l_Record.Type = HotRestartRecordType::Acceptor;
+        for (int const l_Fd : p_State.Acceptors)
+        {
+            if (!SendRecord(p_Channel, l_Record, l_Fd))
+                return false;
+        }
+
+        l_Record.Type = HotRestartRecordType::Socket;
+        for (SocketHandoff const& l_Handoff : p_State.Sockets)
+        {
+            l_Record.SessionId  = l_Handoff.SessionId;
+            l_Record.InLength   = static_cast<uint32>(l_Handoff.InBuffer.size());
+            l_Record.OutLength  = static_cast<uint32>(l_Handoff.OutQueue.size());
+            l_Record.Transport  = l_Handoff.Transport;
+            l_Record.TransportLength = static_cast<uint32>(l_Handoff.TransportState.size());
+
+            if (!SendRecord(p_Channel, l_Record, l_Handoff.Fd) || !SendPayload(p_Channel, l_Handoff.InBuffer) || !SendPayload(p_Channel, l_Handoff.OutQueue)
+                || !SendPayload(p_Channel, l_Handoff.TransportState))
+                return false;
+        }
+
+        l_Record = HotRestartRecord{};
+        l_Record.Magic      = HOT_RESTART_MAGIC;
+        l_Record.Version    = HOT_RESTART_VERSION;
+        l_Record.Type       = HotRestartRecordType::End;
+        if (!SendRecord(p_Channel, l_Record, -1))
+            return false;
+
+        uint8 l_Ack = 0;
+        return recv(p_Channel, &l_Ack, sizeof(l_Ack), 0) == sizeof(l_Ack) && l_Ack == 1;
+    }
+    /// Close every descriptor of a state
+    /// @p_State : State
+    void HotRestart::Close(HotRestartState& p_State)
+    {
+        for (int const l_Fd : p_State.Acceptors)
+            close(l_Fd);
+
+        for (SocketHandoff const& l_Handoff : p_State.Sockets)
+            close(l_Handoff.Fd);
+
+        p_State.Acceptors.clear();
+        p_State.Sockets.clear();
+    }
+
+#else
+
+    /// Hot restart needs unix sockets, every restart is a cold one
+    bool HotRestart::Receive(std::string const&, HotRestartState&)
+    {
+        return false;
+    }
+    bool HotRestart::Send(int const, HotRestartState const&)
+    {
+        return false;
+    }
+    void HotRestart::Close(HotRestartState& p_State)
+    {
+        p_State.Acceptors.clear();
+        p_State.Sockets.clear();
+    }
+
+#endif
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
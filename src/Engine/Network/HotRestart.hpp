@@ -0,0 +1,93 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+#include <string>
+#include <vector>
+
+#include "Core/Core.hpp"
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+    #define NETWORK_HAS_HOT_RESTART
+#endif
+
+#define HOT_RESTART_MAGIC 0x52485353         ///< "SSHR"
+#define HOT_RESTART_VERSION 2
+#define HOT_RESTART_MESSAGE_SIZE 65536      ///< Largest payload message, buffered bytes are split over several
+#define HOT_RESTART_TIMEOUT 10              ///< Seconds either side waits for the other before giving up
+
+namespace SteerStone { namespace Core { namespace Network {
+
+#ifdef NETWORK_HAS_HOT_RESTART
+    /// asio has no unix SOCK_SEQPACKET protocol of its own, message boundaries keep every record whole
+    using HotRestartProtocol = boost::asio::generic::seq_packet_protocol;
+    using HotRestartAcceptor = boost::asio::basic_socket_acceptor<HotRestartProtocol>;
+
+    /// Get the end point of a unix socket path
+    /// @p_Path : Path
+    inline HotRestartProtocol::endpoint GetHotRestartEndPoint(std::string const& p_Path)
+    {
+        return HotRestartProtocol::endpoint(boost::asio::local::stream_protocol::endpoint(p_Path));
+    }
+#endif
+
+    /// Client connection handed from the process being replaced to its successor
+    struct SocketHandoff
+    {
+        int Fd = -1;                        ///< Connected descriptor, -1 if the socket had nothing to hand over
+        uint64 SessionId = 0;               ///< Session of the client, survives the restart
+        std::vector<uint8> InBuffer;        ///< Received bytes not handled yet, a partial frame
+        std::vector<uint8> OutQueue;        ///< Queued bytes not sent yet
+        uint8 Transport = 0;                ///< Transport of the client, a SocketTransport
+        std::vector<uint8> TransportState;  ///< WebSocket state, partial frame header and pending control frames
+    };
+
+    /// Everything a Listener hands to its successor
+    struct HotRestartState
+    {
+        std::vector<int> Acceptors;         ///< Listening descriptors, connections waiting in their backlog are kept
+        std::vector<SocketHandoff> Sockets; ///< Client connections
+    };
+
+    /// Moves a HotRestartState between two processes over a unix SOCK_SEQPACKET socket
+    /// Descriptors travel as SCM_RIGHTS next to a record header, buffered bytes follow in plain messages.
+    /// The receiver acknowledges the whole state, so the sender only lets go of its descriptors
+    /// once its successor owns them.
+    class HotRestart
+    {
+        public:
+            /// Connect to the process waiting on p_Path and take its state
+            /// Returns false if no process waits there or the transfer failed, nothing is kept then
+            /// @p_Path  : Unix socket path
+            /// @p_State : Received state, we own its descriptors
+            static bool Receive(std::string const& p_Path, HotRestartState& p_State);
+            /// Send our state over a channel accepted from our successor, blocking
+            /// Returns true once the successor acknowledged it; our descriptors are left open either way
+            /// @p_Channel : Connected unix socket
+            /// @p_State   : State to send
+            static bool Send(int const p_Channel, HotRestartState const& p_State);
+            /// Close every descriptor of a state
+            /// @p_State : State
+            static void Close(HotRestartState& p_State);
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
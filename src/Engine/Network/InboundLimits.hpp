@@ -0,0 +1,38 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Bounds how much a socket reads before handling it and how much it may hold unhandled
+    struct InboundLimits
+    {
+        uint32 ReadChunk        = 4096;                     ///< Free space every read is given, storage only grows past it to fit a large frame
+        uint32 MaxBytes         = 64 * 1024;                ///< Most unhandled bytes, a client sending a larger frame is disconnected
+        uint32 ReadBurst        = 4;                        ///< Reads made on each wakeup before waiting again, so one busy client cannot hold its NetworkThread
+        uint32 MaxQueuedFrames  = 256;                      ///< Most frames of a socket waiting for the game tick, its reads pause past it until half were handled, 0 for no limit
+        uint32 MaxQueuedBytes   = 64 * 1024;                ///< Most bytes of a socket waiting for the game tick, its reads pause past it until half were handled, 0 for no limit
+        uint32 MaxQueueDepth    = 65536;                    ///< Most frames waiting in the inbound queue of a NetworkThread, a client whose frame does not fit is disconnected, 0 for no limit
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
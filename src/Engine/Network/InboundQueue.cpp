@@ -0,0 +1,215 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "InboundQueue.hpp"
+#include "Socket.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Constructor
+    /// @p_MaxDepth : Most frames waiting, 0 for no limit
+    InboundQueue::InboundQueue(uint32 const p_MaxDepth)
+        : m_Head(&m_Stub), m_Tail(&m_Stub), m_Cache(nullptr), m_Returned(nullptr), m_MaxDepth(p_MaxDepth), m_PeakDepth(0)
+    {
+    }
+    /// Deconstructor, no producer or consumer may be running
+    InboundQueue::~InboundQueue()
+    {
+        while (InboundMessage* l_Node = Dequeue())
+            delete l_Node;
+
+        for (InboundMessage* l_Chain : { m_Cache.load(), m_Returned.load() })
+        {
+            while (l_Chain)
+            {
+                InboundMessage* l_Next = l_Chain->Next.load(std::memory_order_relaxed);
+                delete l_Chain;
+                l_Chain = l_Next;
+            }
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Copy a frame into the queue, from any thread
+    /// Returns false if the queue is full, the frame is not queued
+    /// @p_Sender : Socket which received the frame
+    /// @p_Frame  : Frame body
+    bool InboundQueue::Push(std::shared_ptr<Socket> const& p_Sender, FrameView const& p_Frame)
+    {
+        /// Producers racing each other may overshoot the limit by one frame each
+        if (m_MaxDepth)
+        {
+            const uint64 l_Pushed   = m_Pushed.Get();
+            const uint64 l_Drained  = m_Drained.Get();
+
+            if (l_Pushed > l_Drained && l_Pushed - l_Drained >= m_MaxDepth)
+            {
+                m_Overflows.Add(1);
+                return false;
+            }
+        }
+
+        InboundMessage* l_Node = Acquire();
+        l_Node->Sender = p_Sender;
+        l_Node->Data.assign(p_Frame.GetData(), p_Frame.GetData() + p_Frame.GetSize());
+
+        Enqueue(l_Node);
+        m_Pushed.Add(1);
+
+        /// Drained may run ahead of Pushed for a moment, the depth is only a metric
+        const uint64 l_Pushed   = m_Pushed.Get();
+        const uint64 l_Drained  = m_Drained.Get();
+        const uint64 l_Depth    = l_Pushed > l_Drained ? l_Pushed - l_Drained : 0;
+
+        if (l_Depth > m_PeakDepth.load(std::memory_order_relaxed))
+            m_PeakDepth.store(l_Depth, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    /// Get a copy of our depth metrics
+    InboundQueueStats InboundQueue::GetStats() const
+    {
+        InboundQueueStats l_Stats;
+        l_Stats.Drained     = m_Drained.Get();
+        l_Stats.Pushed      = m_Pushed.Get();
+        l_Stats.Depth       = l_Stats.Pushed > l_Stats.Drained ? l_Stats.Pushed - l_Stats.Drained : 0;
+        l_Stats.MaxDepth    = m_PeakDepth.load(std::memory_order_relaxed);
+        l_Stats.Batches     = m_Batches.Get();
+        l_Stats.Allocated   = m_Allocated.Get();
+        l_Stats.Overflows   = m_Overflows.Get();
+
+        return l_Stats;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Link a node at the head of the queue
+    /// @p_Node : Node
+    void InboundQueue::Enqueue(InboundMessage* p_Node)
+    {
+        p_Node->Next.store(nullptr, std::memory_order_relaxed);
+
+        /// The node is visible to the consumer once the previous head points at it
+        InboundMessage* l_Previous = m_Head.exchange(p_Node, std::memory_order_acq_rel);
+        l_Previous->Next.store(p_Node, std::memory_order_release);
+    }
+    /// Unlink the node at the tail of the queue, null if empty or a producer is half way through a push
+    InboundMessage* InboundQueue::Dequeue()
+    {
+        InboundMessage* l_Tail = m_Tail;
+        InboundMessage* l_Next = l_Tail->Next.load(std::memory_order_acquire);
+
+        /// Step over the stub
+        if (l_Tail == &m_Stub)
+        {
+            if (!l_Next)
+                return nullptr;
+
+            m_Tail = l_Next;
+            l_Tail = l_Next;
+            l_Next = l_Next->Next.load(std::memory_order_acquire);
+        }
+
+        if (l_Next)
+        {
+            m_Tail = l_Next;
+            return l_Tail;
+        }
+
+        /// A producer swapped the head but has not linked it yet, pick it up on the next drain
+        if (l_Tail != m_Head.load(std::memory_order_acquire))
+            return nullptr;
+
+        /// l_Tail is the last node, put the stub behind it so it can be unlinked
+        Enqueue(&m_Stub);
+
+        l_Next = l_Tail->Next.load(std::memory_order_acquire);
+        if (l_Next)
+        {
+            m_Tail = l_Next;
+            return l_Tail;
+        }
+
+        return nullptr;
+    }
+    /// Take a node from the pool, or create one
+    InboundMessage* InboundQueue::Acquire()
+    {
+        InboundMessage* l_Node = m_Cache.exchange(nullptr, std::memory_order_acquire);
+        if (!l_Node)
+            l_Node = m_Returned.exchange(nullptr, std::memory_order_acquire);
+
+        if (!l_Node)
+        {
+            m_Allocated.Add(1);
+            return new InboundMessage();
+        }
+
+        /// Keep the rest of the chain for the next push; if another producer refilled the
+        /// cache meanwhile, hand our rest back through the returned chains instead
+        InboundMessage* l_Rest = l_Node->Next.load(std::memory_order_relaxed);
+        if (l_Rest)
+        {
+            InboundMessage* l_Expected = nullptr;
+            if (!m_Cache.compare_exchange_strong(l_Expected, l_Rest, std::memory_order_release, std::memory_order_relaxed))
+            {
+                InboundMessage* l_Last = l_Rest;
+                while (InboundMessage* l_Next = l_Last->Next.load(std::memory_order_relaxed))
+                    l_Last = l_Next;
+
+                Release(l_Rest, l_Last);
+            }
+        }
+
+        return l_Node;
+    }
+    /// Clear a handled node and tell its sender, before it goes back to the pool
+    /// @p_Node : Node
+    void InboundQueue::Recycle(InboundMessage* p_Node)
+    {
+        /// May resume its reads
+        p_Node->Sender->OnInboundHandled(p_Node->Data.size());
+        p_Node->Sender.reset();
+
+        /// Do not let one large frame pin its storage in the pool forever
+        if (p_Node->Data.capacity() > INBOUND_NODE_KEEP_CAPACITY)
+            std::vector<uint8>().swap(p_Node->Data);
+        else
+            p_Node->Data.clear();
+    }
+    /// Give a chain of nodes back to the pool
+    /// @p_Head : First node
+    /// @p_Tail : Last node
+    void InboundQueue::Release(InboundMessage* p_Head, InboundMessage* p_Tail)
+    {
+        InboundMessage* l_Returned = m_Returned.load(std::memory_order_relaxed);
+
+        do
+        {
+            p_Tail->Next.store(l_Returned, std::memory_order_relaxed);
+        } while (!m_Returned.compare_exchange_weak(l_Returned, p_Head, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
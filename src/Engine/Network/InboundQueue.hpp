@@ -0,0 +1,173 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "Core/Core.hpp"
+#include "FrameView.hpp"
+#include "NetworkCounters.hpp"
+
+#define INBOUND_NODE_KEEP_CAPACITY 4096     ///< Larger frame storage is freed when a node goes back to the pool
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    class Socket;
+
+    /// Frame copied out of a socket in buffer, waiting for the game tick
+    struct InboundMessage
+    {
+        std::shared_ptr<Socket> Sender;                 ///< Socket which received the frame, kept alive until the frame is handled
+        std::vector<uint8> Data;                        ///< Frame body, storage is kept when the node is pooled
+        std::atomic<InboundMessage*> Next{ nullptr };   ///< Next node, in the queue or in the pool
+
+        /// Get the frame body
+        FrameView GetFrame() const
+        {
+            return FrameView(Data.data(), Data.size());
+        }
+    };
+
+    /// Copy of the depth metrics of one queue
+    struct InboundQueueStats
+    {
+        uint64 Depth        = 0;                        ///< Frames waiting
+        uint64 MaxDepth     = 0;                        ///< Most frames ever waiting
+        uint64 Pushed       = 0;                        ///< Frames queued
+        uint64 Drained      = 0;                        ///< Frames handled
+        uint64 Batches      = 0;                        ///< Drains which handled at least one frame
+        uint64 Allocated    = 0;                        ///< Nodes created, stops growing once the pool is warm
+        uint64 Overflows    = 0;                        ///< Frames refused because the queue was full, their clients are disconnected
+    };
+
+    /// Frames from network threads to the game tick
+    /// Many producers push without locking, a single consumer drains in batches; nodes are pooled
+    /// so a warm queue never allocates. The queue is an intrusive MPSC list with a stub node,
+    /// the pool is handed around as whole chains so no node is ever popped with a CAS (no ABA).
+    class InboundQueue
+    {
+        DISALLOW_COPY_AND_ASSIGN(InboundQueue);
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            /// @p_MaxDepth : Most frames waiting, 0 for no limit
+            explicit InboundQueue(uint32 const p_MaxDepth = 0);
+            /// Deconstructor, no producer or consumer may be running
+            ~InboundQueue();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Copy a frame into the queue, from any thread
+            /// Returns false if the queue is full, the frame is not queued
+            /// @p_Sender : Socket which received the frame
+            /// @p_Frame  : Frame body
+            bool Push(std::shared_ptr<Socket> const& p_Sender, FrameView const& p_Frame);
+            /// Handle up to p_Max frames in queue order, from the consumer only
+            /// @p_Handler : Called with each InboundMessage, which is recycled once it returns
+            /// @p_Max     : Largest batch
+            template <typename Handler> std::size_t Drain(Handler&& p_Handler, std::size_t const p_Max);
+
+            /// Get a copy of our depth metrics
+            InboundQueueStats GetStats() const;
+
+        private:
+            /// Link a node at the head of the queue
+            /// @p_Node : Node
+            void Enqueue(InboundMessage* p_Node);
+            /// Unlink the node at the tail of the queue, null if empty or a producer is half way through a push
+            InboundMessage* Dequeue();
+            /// Take a node from the pool, or create one
+            InboundMessage* Acquire();
+            /// Clear a handled node and tell its sender, before it goes back to the pool
+            /// @p_Node : Node
+            void Recycle(InboundMessage* p_Node);
+            /// Give a chain of nodes back to the pool
+            /// @p_Head : First node
+            /// @p_Tail : Last node
+            void Release(InboundMessage* p_Head, InboundMessage* p_Tail);
+
+        private:
+            /// Queue
+            alignas(NETWORK_CACHE_LINE_SIZE) std::atomic<InboundMessage*> m_Head;  ///< Last pushed node, producers only
+            alignas(NETWORK_CACHE_LINE_SIZE) InboundMessage* m_Tail;               ///< Next node to drain, consumer only
+            InboundMessage m_Stub;                                                  ///< Keeps the list non empty
+            /// Pool
+            alignas(NETWORK_CACHE_LINE_SIZE) std::atomic<InboundMessage*> m_Cache; ///< Chain producers take nodes from
+            std::atomic<InboundMessage*> m_Returned;                                ///< Chains given back by the consumer
+            uint64 const m_MaxDepth;                                                ///< Most frames waiting, 0 for no limit
+            /// Metrics
+            PaddedCounter m_Pushed;                                                 ///< Frames queued
+            PaddedCounter m_Drained;                                                ///< Frames handled
+            PaddedCounter m_Batches;                                                ///< Non empty drains
+            PaddedCounter m_Allocated;                                              ///< Nodes created
+            PaddedCounter m_Overflows;                                              ///< Frames refused because we were full
+            std::atomic<uint64> m_PeakDepth;                                        ///< Most frames ever waiting
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Handle up to p_Max frames in queue order, from the consumer only
+    /// @p_Handler : Called with each InboundMessage, which is recycled once it returns
+    /// @p_Max     : Largest batch
+    template <typename Handler> std::size_t InboundQueue::Drain(Handler&& p_Handler, std::size_t const p_Max)
+    {
+        InboundMessage* l_Head = nullptr;
+        InboundMessage* l_Tail = nullptr;
+        std::size_t l_Count    = 0;
+
+        while (l_Count < p_Max)
+        {
+            InboundMessage* l_Node = Dequeue();
+            if (!l_Node)
+                break;
+
+            p_Handler(static_cast<InboundMessage const&>(*l_Node));
+
+            Recycle(l_Node);
+
+            /// Handled nodes go back to the pool in one go
+            l_Node->Next.store(l_Head, std::memory_order_relaxed);
+            l_Head = l_Node;
+            if (!l_Tail)
+                l_Tail = l_Node;
+
+            l_Count++;
+        }
+
+        if (!l_Count)
+            return 0;
+
+        Release(l_Head, l_Tail);
+
+        m_Drained.Add(l_Count);
+        m_Batches.Add(1);
+
+        return l_Count;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,668 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cassert>
+#include <cstring>
+
+#include "IoUring.hpp"
+#include "Logger/Base.hpp"
+
+#ifdef NETWORK_HAS_IO_URING
+    #include <sys/eventfd.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/utsname.h>
+    #include <unistd.h>
+    #include <climits>
+    #include <cstdio>
+#endif
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Constructor
+    /// @p_Callback : Called on every completion
+    UringOperation::UringOperation(Callback p_Callback)
+        : m_Callback(std::move(p_Callback))
+    {
+    }
+    /// Deconstructor
+    UringOperation::~UringOperation()
+    {
+        /// A pending operation keeps its owner alive, so it can never be destroyed while the kernel holds it
+        assert(!IsPending());
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set function called on every completion
+    /// @p_Callback : Callback
+    void UringOperation::SetCallback(Callback p_Callback)
+    {
+        m_Callback = std::move(p_Callback);
+    }
+    /// Check if the kernel holds the operation, until its last completion
+    bool UringOperation::IsPending() const
+    {
+        return Next != nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+#ifdef NETWORK_HAS_IO_URING
+
+    /// Buffer group our receives pick from
+    static uint16 const s_BufferGroup = 0;
+
+    /// Constructor
+    /// @p_Service : Service reaping our completions
+    IoUring::IoUring(boost::asio::io_service& p_Service)
+        : m_Service(p_Service), m_Event(p_Service), m_Counters(nullptr), m_Fd(-1),
+        m_SqRing(MAP_FAILED), m_SqRingSize(0), m_Entries(MAP_FAILED), m_EntriesSize(0), m_SqHead(nullptr), m_SqTail(nullptr),
+        m_SqFlags(nullptr), m_SqArray(nullptr), m_SqMask(0), m_SqEntries(0), m_SubmitPosted(false),
+        m_CqRing(MAP_FAILED), m_CqRingSize(0), m_CqHead(nullptr), m_CqTail(nullptr), m_Completions(nullptr), m_CqMask(0), m_Reaping(false),
+        m_BufferRing(MAP_FAILED), m_BufferRingSize(0), m_Buffers(nullptr), m_BufferCount(0), m_BufferSize(0), m_BufferTail(0)
+    {
+        m_Pending.Prev = m_Pending.Next = &m_Pending;
+    }
+    /// Deconstructor
+    IoUring::~IoUring()
+    {
+        Close();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set up the ring, false if the kernel cannot run it; the caller stays on the reactor then
+    /// @p_Settings : Ring size and receive buffers
+    /// @p_Counters : Counters of our NetworkThread, must outlive us
+    bool IoUring::Open(IoUringSettings const& p_Settings, NetworkCounters* p_Counters)
+    {
+        m_Counters = p_Counters;
+
+        /// Older kernels take a multishot receive for a plain one, or refuse it on every call
+        utsname l_Name;
+        int l_Major = 0;
+        int l_Minor = 0;
+        if (uname(&l_Name) || sscanf(l_Name.release, "%d.%d", &l_Major, &l_Minor) != 2 || l_Major < 6)
+        {
+            LOG_WARNING("IoUring", "io_uring needs Linux 6.0 or newer for multishot receive");
+            return false;
+        }
+
+        io_uring_params l_Params;
+        memset(&l_Params, 0, sizeof(l_Params));
+        l_Params.flags      = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP | IORING_SETUP_SUBMIT_ALL;
+        l_Params.cq_entries = std::max<uint32>(p_Settings.Entries, 1) * 4;
+
+        m_Fd = static_cast<int>(syscall(__NR_io_uring_setup, std::max<uint32>(p_Settings.Entries, 1), &l_Params));
+        if (m_Fd < 0)
+        {
+            LOG_WARNING("IoUring", "io_uring_setup failed: %0", strerror(errno));
+            return false;
+        }
+
+        /// Without it completions are dropped once the completion queue is full
+        if (!(l_Params.features & IORING_FEAT_NODROP))
+        {
+            LOG_WARNING("IoUring", "io_uring of this kernel drops completions when the completion queue is full");
+            Close();
+            return false;
+        }
+
+        m_SqRingSize    = l_Params.sq_off.array + l_Params.sq_entries * sizeof(uint32);
+        m_CqRingSize    = l_Params.cq_off.cqes + l_Params.cq_entries * sizeof(io_uring_cqe);
+        m_EntriesSize   = l_Params.sq_entries * sizeof(io_uring_sqe);
+
+        /// Both rings share one mapping
+        if (l_Params.features & IORING_FEAT_SINGLE_MMAP)
+            m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+
+        m_SqRing = mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQ_RING);
+
+        if (m_SqRing != MAP_FAILED)
+            m_CqRing = (l_Params.features & IORING_FEAT_SINGLE_MMAP) ? m_SqRing : mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_CQ_RING);
+
+        if (m_CqRing != MAP_FAILED)
+            m_Entries = mmap(nullptr, m_EntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Fd, IORING_OFF_SQES);
+
+        if (m_Entries == MAP_FAILED)
+        {
+            LOG_WARNING("IoUring", "Failed to map io_uring: %0", strerror(errno));
+            Close();
+            return false;
+        }
+
+        uint8* l_SqRing = static_cast<uint8*>(m_SqRing);
+        m_SqHead    = reinterpret_cast<uint32*>(l_SqRing + l_Params.sq_off.head);
+        m_SqTail    = reinterpret_cast<uint32*>(l_SqRing + l_Params.sq_off.tail);
+        m_SqFlags   = reinterpret_cast<uint32*>(l_SqRing + l_Params.sq_off.flags);
+        m_SqArray   = reinterpret_cast<uint32*>(l_SqRing + l_Params.sq_off.array);
+        m_SqMask    = *reinterpret_cast<uint32*>(l_SqRing + l_Params.sq_off.ring_mask);
+        m_SqEntries = l_Params.sq_entries;
+
+        /// Entries are queued in order, slot i always holds entry i
+        for (uint32 l_I = 0; l_I < m_SqEntries; l_I++)
+            m_SqArray[l_I] = l_I;
+
+        uint8* l_CqRing = static_cast<uint8*>(m_CqRing);
+        m_CqHead        = reinterpret_cast<uint32*>(l_CqRing + l_Params.cq_off.head);
+        m_CqTail        = reinterpret_cast<uint32*>(l_CqRing + l_Params.cq_off.tail);
+        m_Completions   = l_CqRing + l_Params.cq_off.cqes;
+        m_CqMask        = *reinterpret_cast<uint32*>(l_CqRing + l_Params.cq_off.ring_mask);
+
+        /// Receive buffers, the kernel takes them in order and we give them back as soon as we copied them out
+        m_BufferCount = 1;
+        while (m_BufferCount < std::min<uint32>(std::max<uint32>(p_Settings.Buffers, 1), 32768))
+            m_BufferCount <<= 1;
+
+        m_BufferSize = std::max<uint32>(p_Settings.BufferSize, 1);
+
+        const std::size_t l_PageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        m_BufferRingSize = (m_BufferCount * sizeof(io_uring_buf) + l_PageSize - 1) / l_PageSize * l_PageSize;
+        m_BufferRing = mmap(nullptr, m_BufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        m_Buffers = new (std::nothrow) uint8[static_cast<std::size_t>(m_BufferCount) * m_BufferSize];
+
+        if (m_BufferRing == MAP_FAILED || !m_Buffers)
+        {
+            LOG_WARNING("IoUring", "Failed to allocate %0 receive buffers of %1 bytes", m_BufferCount, m_BufferSize);
+            Close();
+            return false;
+        }
+
+        io_uring_buf_reg l_BufferRing;
+        memset(&l_BufferRing, 0, sizeof(l_BufferRing));
+        l_BufferRing.ring_addr      = reinterpret_cast<uint64>(m_BufferRing);
+        l_BufferRing.ring_entries   = m_BufferCount;
+        l_BufferRing.bgid           = s_BufferGroup;
+
+        if (syscall(__NR_io_uring_register, m_Fd, IORING_REGISTER_PBUF_RING, &l_BufferRing, 1) < 0)
+        {
+            LOG_WARNING("IoUring", "Failed to register receive buffers: %0", strerror(errno));
+            Close();
+            return false;
+        }
+
+        for (uint32 l_I = 0; l_I < m_BufferCount; l_I++)
+            RecycleBuffer(l_I << IORING_CQE_BUFFER_SHIFT);
+
+        /// The kernel signals it on every completion, our service waits on it next to its other descriptors
+        int l_Event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (l_Event < 0 || syscall(__NR_io_uring_register, m_Fd, IORING_REGISTER_EVENTFD, &l_Event, 1) < 0)
+        {
+            LOG_WARNING("IoUring", "Failed to register completion eventfd: %0", strerror(errno));
+
+            if (l_Event >= 0)
+                ::close(l_Event);
+
+            Close();
+            return false;
+        }
+
+        boost::system::error_code l_ErrorCode;
+        m_Event.assign(l_Event, l_ErrorCode);
+
+        if (l_ErrorCode)
+        {
+            LOG_WARNING("IoUring", "Failed to wait on completion eventfd: %0", l_ErrorCode.message());
+            ::close(l_Event);
+            Close();
+            return false;
+        }
+
+        WaitCompletions();
+
+        return true;
+    }
+    /// Check if the ring is set up
+    bool IoUring::IsOpen() const
+    {
+        return m_Fd >= 0;
+    }
+
+    /// Receive on a connected socket until cancelled, each completion carries one of our buffers
+    /// @p_Operation : Operation, completes with the bytes received, 0 at end of stream
+    /// @p_Fd        : Socket
+    /// @p_Owner     : Kept alive until the last completion
+    bool IoUring::ReceiveMultishot(UringOperation& p_Operation, int const p_Fd, std::shared_ptr<void> p_Owner)
+    {
+        io_uring_sqe* l_Entry = static_cast<io_uring_sqe*>(GetEntry());
+        if (!l_Entry)
+            return false;
+
+        l_Entry->opcode     = IORING_OP_RECV;
+        l_Entry->fd         = p_Fd;
+        l_Entry->ioprio     = IORING_RECV_MULTISHOT;
+        l_Entry->flags      = IOSQE_BUFFER_SELECT;
+        l_Entry->buf_group  = s_BufferGroup;
+        l_Entry->user_data  = reinterpret_cast<uint64>(&p_Operation);
+
+        Track(p_Operation, std::move(p_Owner));
+        Queue();
+
+        return true;
+    }
+    /// Send spans in one gather write
+    /// @p_Operation : Operation, completes with the bytes sent
+    /// @p_Fd        : Socket
+    /// @p_Spans     : Spans, must stay valid until the completion
+    /// @p_Owner     : Kept alive until the completion
+    bool IoUring::Send(UringOperation& p_Operation, int const p_Fd, std::vector<boost::asio::const_buffer> const& p_Spans, std::shared_ptr<void> p_Owner)
+    {
+        io_uring_sqe* l_Entry = static_cast<io_uring_sqe*>(GetEntry());
+        if (!l_Entry)
+            return false;
+
+        /// The rest goes out with the next send, like a partial write
+        const std::size_t l_Count = std::min<std::size_t>(p_Spans.size(), IOV_MAX);
+
+        p_Operation.m_Vectors.resize(l_Count);
+        for (std::size_t l_I = 0; l_I < l_Count; l_I++)
+        {
+            p_Operation.m_Vectors[l_I].iov_base = const_cast<void*>(p_Spans[l_I].data());
+            p_Operation.m_Vectors[l_I].iov_len  = p_Spans[l_I].size();
+        }
+
+        memset(&p_Operation.m_Message, 0, sizeof(p_Operation.m_Message));
+        p_Operation.m_Message.msg_iov       = p_Operation.m_Vectors.data();
+        p_Operation.m_Message.msg_iovlen    = l_Count;
+
+        l_Entry->opcode     = IORING_OP_SENDMSG;
+        l_Entry->fd         = p_Fd;
+        l_Entry->addr       = reinterpret_cast<uint64>(&p_Operation.m_Message);
+        l_Entry->len        = 1;
+        l_Entry->msg_flags  = MSG_NOSIGNAL;
+        l_Entry->user_data  = reinterpret_cast<uint64>(&p_Operation);
+
+        Track(p_Operation, std::move(p_Owner));
+        Queue();
+
+        return true;
+    }
+    /// Accept on a listening socket until cancelled
+    /// @p_Operation : Operation, completes with the descriptor of each connection
+    /// @p_Fd        : Listening socket
+    /// @p_Owner     : Kept alive until the last completion
+    bool IoUring::AcceptMultishot(UringOperation& p_Operation, int const p_Fd, std::shared_ptr<void> p_Owner)
+    {
+        io_uring_sqe* l_Entry = static_cast<io_uring_sqe*>(GetEntry());
+        if (!l_Entry)
+            return false;
+
+        l_Entry->opcode         = IORING_OP_ACCEPT;
+        l_Entry->fd             = p_Fd;
+        l_Entry->ioprio         = IORING_ACCEPT_MULTISHOT;
+        l_Entry->accept_flags   = SOCK_CLOEXEC;
+        l_Entry->user_data      = reinterpret_cast<uint64>(&p_Operation);
+
+        Track(p_Operation, std::move(p_Owner));
+        Queue();
+
+        return true;
+    }
+    /// Ask the kernel to cancel an operation, it completes with -ECANCELED unless it finished meanwhile
+    /// @p_Operation : Operation
+    void IoUring::Cancel(UringOperation& p_Operation)
+    {
+        if (!p_Operation.IsPending())
+            return;
+
+        io_uring_sqe* l_Entry = static_cast<io_uring_sqe*>(GetEntry());
+        if (!l_Entry)
+        {
+            LOG_ERROR("IoUring", "Submission queue is full, cannot cancel an operation");
+            return;
+        }
+
+        /// Completions of the cancel itself carry no operation
+        l_Entry->opcode     = IORING_OP_ASYNC_CANCEL;
+        l_Entry->addr       = reinterpret_cast<uint64>(&p_Operation);
+        l_Entry->user_data  = 0;
+
+        Queue();
+    }
+    /// Cancel an operation and wait for it, its last completion is handled before we return
+    /// Must not be called from a completion, the completion it waits for would be handled after it returns
+    /// @p_Operation : Operation
+    void IoUring::CancelAndWait(UringOperation& p_Operation)
+    {
+        if (!p_Operation.IsPending())
+            return;
+
+        /// The kernel can only cancel what it was handed
+        Submit();
+
+        io_uring_sync_cancel_reg l_Cancel;
+        memset(&l_Cancel, 0, sizeof(l_Cancel));
+        l_Cancel.addr               = reinterpret_cast<uint64>(&p_Operation);
+        l_Cancel.timeout.tv_sec     = -1;
+        l_Cancel.timeout.tv_nsec    = -1;
+
+        if (syscall(__NR_io_uring_register, m_Fd, IORING_REGISTER_SYNC_CANCEL, &l_Cancel, 1) < 0 && errno != ENOENT && errno != EALREADY)
+            LOG_ERROR("IoUring", "Failed to cancel an operation: %0", strerror(errno));
+
+        Reap();
+    }
+
+    /// Get the buffer a receive completion carries
+    /// @p_Flags : Flags of the completion
+    uint8 const* IoUring::GetBuffer(uint32 const p_Flags) const
+    {
+        return m_Buffers + static_cast<std::size_t>(p_Flags >> IORING_CQE_BUFFER_SHIFT) * m_BufferSize;
+    }
+    /// Give the buffer of a receive completion back to the kernel
+    /// @p_Flags : Flags of the completion
+    void IoUring::RecycleBuffer(uint32 const p_Flags)
+    {
+        const uint16 l_Id = static_cast<uint16>(p_Flags >> IORING_CQE_BUFFER_SHIFT);
+
+        /// Not through io_uring_buf_ring::bufs, compiled as C++ its flexible array does not start at the ring;
+        /// the tail shares the first slot, only the fields of a buffer are written
+        io_uring_buf& l_Buffer = static_cast<io_uring_buf*>(m_BufferRing)[m_BufferTail & (m_BufferCount - 1)];
+        l_Buffer.addr   = reinterpret_cast<uint64>(m_Buffers + static_cast<std::size_t>(l_Id) * m_BufferSize);
+        l_Buffer.len    = m_BufferSize;
+        l_Buffer.bid    = l_Id;
+
+        m_BufferTail++;
+        __atomic_store_n(&static_cast<io_uring_buf_ring*>(m_BufferRing)->tail, m_BufferTail, __ATOMIC_RELEASE);
+    }
+    /// Check if more completions of a multishot operation follow this one
+    /// @p_Flags : Flags of the completion
+    bool IoUring::IsArmed(uint32 const p_Flags)
+    {
+        return (p_Flags & IORING_CQE_F_MORE) != 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get a free submission queue entry, submits what we queued if the queue is full; null if it stays full
+    void* IoUring::GetEntry()
+    {
+        if (*m_SqTail - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE) >= m_SqEntries)
+        {
+            Submit();
+
+            if (*m_SqTail - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE) >= m_SqEntries)
+                return nullptr;
+        }
+
+        io_uring_sqe* l_Entry = static_cast<io_uring_sqe*>(m_Entries) + (*m_SqTail & m_SqMask);
+        memset(l_Entry, 0, sizeof(io_uring_sqe));
+
+        return l_Entry;
+    }
+    /// Hand an entry filled by GetEntry to the kernel with our next submit
+    void IoUring::Queue()
+    {
+        __atomic_store_n(m_SqTail, *m_SqTail + 1, __ATOMIC_RELEASE);
+        ScheduleSubmit();
+    }
+    /// Remember an operation the kernel holds from now on
+    /// @p_Operation : Operation
+    /// @p_Owner     : Owner
+    void IoUring::Track(UringOperation& p_Operation, std::shared_ptr<void> p_Owner)
+    {
+        LOG_ASSERT(!p_Operation.IsPending(), "IoUring", "Operation submitted twice!");
+
+        p_Operation.m_Owner = std::move(p_Owner);
+
+        p_Operation.Prev        = m_Pending.Prev;
+        p_Operation.Next        = &m_Pending;
+        m_Pending.Prev->Next    = &p_Operation;
+        m_Pending.Prev          = &p_Operation;
+    }
+    /// Submit once the current handler returns
+    /// Every operation queued meanwhile, by any socket of ours, goes to the kernel in the same io_uring_enter
+    void IoUring::ScheduleSubmit()
+    {
+        if (m_SubmitPosted)
+            return;
+
+        m_SubmitPosted = true;
+        boost::asio::post(m_Service, [this]() { this->Submit(); });
+    }
+    /// Hand queued entries to the kernel
+    void IoUring::Submit()
+    {
+        m_SubmitPosted = false;
+
+        const uint32 l_Queued = *m_SqTail - __atomic_load_n(m_SqHead, __ATOMIC_ACQUIRE);
+        if (!l_Queued)
+            return;
+
+        const long l_Result = syscall(__NR_io_uring_enter, m_Fd, l_Queued, 0, 0, nullptr, 0);
+        m_Counters->RingEnters.Add(1);
+
+        /// Completions are backed up, try again once we reaped them
+        if (l_Result < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY))
+        {
+            ScheduleSubmit();
+            return;
+        }
+
+        if (l_Result < 0)
+            LOG_ERROR("IoUring", "io_uring_enter failed: %0", strerror(errno));
+    }
+    /// Wait for our eventfd, the kernel signals it when a completion is posted
+    void IoUring::WaitCompletions()
+    {
+        m_Event.async_wait(boost::asio::posix::stream_descriptor::wait_read, [this](boost::system::error_code const& p_ErrorCode)
+        {
+            /// Closed, we are going away
+            if (p_ErrorCode)
+                return;
+
+            /// Reset the count, completions posted from here on signal it again
+            uint64 l_Count;
+            const ssize_t l_Read = ::read(this->m_Event.native_handle(), &l_Count, sizeof(l_Count));
+            UNUSED(l_Read);
+
+            this->Reap();
+            this->WaitCompletions();
+        });
+    }
+    /// Handle every posted completion
+    void IoUring::Reap()
+    {
+        if (m_Reaping)
+            return;
+
+        m_Reaping = true;
+
+        for (;;)
+        {
+            const uint32 l_Head = *m_CqHead;
+
+            if (l_Head == __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE))
+            {
+                /// Completions which did not fit wait in the kernel, have it move them over
+                if (!(__atomic_load_n(m_SqFlags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW))
+                    break;
+
+                syscall(__NR_io_uring_enter, m_Fd, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0);
+                m_Counters->RingEnters.Add(1);
+
+                if (l_Head == __atomic_load_n(m_CqTail, __ATOMIC_ACQUIRE))
+                    break;
+
+                continue;
+            }
+
+            io_uring_cqe const& l_Completion = static_cast<io_uring_cqe const*>(m_Completions)[l_Head & m_CqMask];
+            const uint64 l_UserData = l_Completion.user_data;
+            const int32 l_Result    = l_Completion.res;
+            const uint32 l_Flags    = l_Completion.flags;
+
+            __atomic_store_n(m_CqHead, l_Head + 1, __ATOMIC_RELEASE);
+
+            if (!l_UserData)
+                continue;
+
+            UringOperation* l_Operation = reinterpret_cast<UringOperation*>(l_UserData);
+
+            /// Last completion, the operation may be submitted again from its callback; its owner is
+            /// released once the callback returned, it may be the last reference to the operation
+            std::shared_ptr<void> l_Owner;
+            if (!(l_Flags & IORING_CQE_F_MORE))
+            {
+                Unlink(l_Operation);
+                l_Owner = std::move(l_Operation->m_Owner);
+            }
+
+            if (l_Operation->m_Callback)
+                l_Operation->m_Callback(l_Result, l_Flags);
+        }
+
+        m_Reaping = false;
+    }
+    /// Tear the ring down, cancelling whatever the kernel holds
+    void IoUring::Close()
+    {
+        if (m_Fd >= 0)
+        {
+            /// Nothing may read our buffers or spans once we unmap them
+            if (m_Pending.Next != &m_Pending)
+            {
+                io_uring_sync_cancel_reg l_Cancel;
+                memset(&l_Cancel, 0, sizeof(l_Cancel));
+                l_Cancel.flags              = IORING_ASYNC_CANCEL_ANY;
+                l_Cancel.fd                 = -1;
+                l_Cancel.timeout.tv_sec     = -1;
+                l_Cancel.timeout.tv_nsec    = -1;
+
+                syscall(__NR_io_uring_register, m_Fd, IORING_REGISTER_SYNC_CANCEL, &l_Cancel, 1);
+            }
+
+            boost::system::error_code l_ErrorCode;
+            m_Event.close(l_ErrorCode);
+
+            ::close(m_Fd);
+            m_Fd = -1;
+        }
+
+        if (m_Entries != MAP_FAILED)
+            munmap(m_Entries, m_EntriesSize);
+
+        if (m_CqRing != MAP_FAILED && m_CqRing != m_SqRing)
+            munmap(m_CqRing, m_CqRingSize);
+
+        if (m_SqRing != MAP_FAILED)
+            munmap(m_SqRing, m_SqRingSize);
+
+        if (m_BufferRing != MAP_FAILED)
+            munmap(m_BufferRing, m_BufferRingSize);
+
+        delete[] m_Buffers;
+
+        m_Entries = m_CqRing = m_SqRing = m_BufferRing = MAP_FAILED;
+        m_Buffers = nullptr;
+
+        /// Owners are released once every operation is unlinked, one of them may be the last reference to a socket
+        std::vector<std::shared_ptr<void>> l_Owners;
+
+        while (m_Pending.Next != &m_Pending)
+        {
+            UringOperation* l_Operation = static_cast<UringOperation*>(m_Pending.Next);
+            Unlink(l_Operation);
+            l_Owners.push_back(std::move(l_Operation->m_Owner));
+        }
+    }
+
+#else
+
+    /// Constructor
+    /// @p_Service : Service reaping our completions
+    IoUring::IoUring(boost::asio::io_service& p_Service)
+        : m_Service(p_Service), m_Counters(nullptr), m_Fd(-1)
+    {
+        m_Pending.Prev = m_Pending.Next = &m_Pending;
+    }
+    /// Deconstructor
+    IoUring::~IoUring()
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// io_uring only exists on Linux
+    bool IoUring::Open(IoUringSettings const& p_Settings, NetworkCounters* p_Counters)
+    {
+        UNUSED(p_Settings);
+        UNUSED(p_Counters);
+
+        LOG_WARNING("IoUring", "io_uring is not supported on this platform");
+        return false;
+    }
+    /// Check if the ring is set up
+    bool IoUring::IsOpen() const
+    {
+        return false;
+    }
+
+    /// Never called, nothing runs on a ring which is not open
+    bool IoUring::ReceiveMultishot(UringOperation&, int const, std::shared_ptr<void>)
+    {
+        return false;
+    }
+    bool IoUring::Send(UringOperation&, int const, std::vector<boost::asio::const_buffer> const&, std::shared_ptr<void>)
+    {
+        return false;
+    }
+    bool IoUring::AcceptMultishot(UringOperation&, int const, std::shared_ptr<void>)
+    {
+        return false;
+    }
+    void IoUring::Cancel(UringOperation&)
+    {
+    }
+    void IoUring::CancelAndWait(UringOperation&)
+    {
+    }
+    uint8 const* IoUring::GetBuffer(uint32 const) const
+    {
+        return nullptr;
+    }
+    void IoUring::RecycleBuffer(uint32 const)
+    {
+    }
+    bool IoUring::IsArmed(uint32 const)
+    {
+        return false;
+    }
+
+#endif
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Unlink an operation from its list
+    /// @p_Link : Link
+    void IoUring::Unlink(UringLink* p_Link)
+    {
+        p_Link->Prev->Next = p_Link->Next;
+        p_Link->Next->Prev = p_Link->Prev;
+        p_Link->Prev = p_Link->Next = nullptr;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
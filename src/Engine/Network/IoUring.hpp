@@ -0,0 +1,217 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Core/Core.hpp"
+#include "IoUringSettings.hpp"
+#include "NetworkCounters.hpp"
+
+/// io_uring is driven through its system calls, multishot receive and accept need Linux 6.0 headers
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #include <linux/io_uring.h>
+        #include <sys/socket.h>
+        #include <sys/uio.h>
+
+        #if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT)
+            #define NETWORK_HAS_IO_URING
+        #endif
+    #endif
+#endif
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Link of the intrusive list of operations the kernel holds
+    struct UringLink
+    {
+        UringLink* Prev = nullptr;
+        UringLink* Next = nullptr;
+    };
+
+    /// Operation living inside its owner, submitted to an IoUring
+    /// Only touched from the thread running the ring; a multishot operation completes many times and stays pending
+    /// until its last completion
+    class UringOperation : private UringLink
+    {
+        DISALLOW_COPY_AND_ASSIGN(UringOperation);
+
+        friend class IoUring;
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Called with the result of a completion (bytes or -errno) and its IORING_CQE_F_* flags
+            using Callback = std::function<void(int32, uint32)>;
+
+            /// Constructor
+            /// @p_Callback : Called on every completion
+            explicit UringOperation(Callback p_Callback = nullptr);
+            /// Deconstructor
+            ~UringOperation();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set function called on every completion
+            /// @p_Callback : Callback
+            void SetCallback(Callback p_Callback);
+            /// Check if the kernel holds the operation, until its last completion
+            bool IsPending() const;
+
+        private:
+            Callback m_Callback;                    ///< Called on every completion
+            std::shared_ptr<void> m_Owner;          ///< Keeps our owner alive while pending
+        #ifdef NETWORK_HAS_IO_URING
+            std::vector<iovec> m_Vectors;           ///< Spans of a send, read by the kernel until it completes
+            msghdr m_Message;                       ///< Message of a send
+        #endif
+    };
+
+    /// io_uring of one NetworkThread, completions are reaped on its io_service
+    /// Submissions made while a handler runs are batched into one io_uring_enter once it returns; the kernel picks
+    /// receive buffers from a ring we registered, which we copy out of and give straight back
+    /// Every call must be made from the thread running the service, except Open and the deconstructor
+    class IoUring
+    {
+        DISALLOW_COPY_AND_ASSIGN(IoUring);
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            /// @p_Service : Service reaping our completions
+            explicit IoUring(boost::asio::io_service& p_Service);
+            /// Deconstructor
+            ~IoUring();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set up the ring, false if the kernel cannot run it; the caller stays on the reactor then
+            /// @p_Settings : Ring size and receive buffers
+            /// @p_Counters : Counters of our NetworkThread, must outlive us
+            bool Open(IoUringSettings const& p_Settings, NetworkCounters* p_Counters);
+            /// Check if the ring is set up
+            bool IsOpen() const;
+
+            /// Receive on a connected socket until cancelled, each completion carries one of our buffers
+            /// Operations return false if the submission queue stays full, nothing was queued then
+            /// @p_Operation : Operation, completes with the bytes received, 0 at end of stream
+            /// @p_Fd        : Socket
+            /// @p_Owner     : Kept alive until the last completion
+            bool ReceiveMultishot(UringOperation& p_Operation, int const p_Fd, std::shared_ptr<void> p_Owner);
+            /// Send spans in one gather write
+            /// @p_Operation : Operation, completes with the bytes sent
+            /// @p_Fd        : Socket
+            /// @p_Spans     : Spans, must stay valid until the completion
+            /// @p_Owner     : Kept alive until the completion
+            bool Send(UringOperation& p_Operation, int const p_Fd, std::vector<boost::asio::const_buffer> const& p_Spans, std::shared_ptr<void> p_Owner);
+            /// Accept on a listening socket until cancelled
+            /// @p_Operation : Operation, completes with the descriptor of each connection
+            /// @p_Fd        : Listening socket
+            /// @p_Owner     : Kept alive until the last completion
+            bool AcceptMultishot(UringOperation& p_Operation, int const p_Fd, std::shared_ptr<void> p_Owner);
+            /// Ask the kernel to cancel an operation, it completes with -ECANCELED unless it finished meanwhile
+            /// @p_Operation : Operation
+            void Cancel(UringOperation& p_Operation);
+            /// Cancel an operation and wait for it, its last completion is handled before we return
+            /// @p_Operation : Operation
+            void CancelAndWait(UringOperation& p_Operation);
+
+            /// Get the buffer a receive completion carries
+            /// @p_Flags : Flags of the completion
+            uint8 const* GetBuffer(uint32 const p_Flags) const;
+            /// Give the buffer of a receive completion back to the kernel
+            /// @p_Flags : Flags of the completion
+            void RecycleBuffer(uint32 const p_Flags);
+            /// Check if more completions of a multishot operation follow this one
+            /// @p_Flags : Flags of the completion
+            static bool IsArmed(uint32 const p_Flags);
+
+        private:
+            /// Get a free submission queue entry, submits what we queued if the queue is full; null if it stays full
+            void* GetEntry();
+            /// Hand an entry filled by GetEntry to the kernel with our next submit
+            void Queue();
+            /// Remember an operation the kernel holds from now on
+            /// @p_Operation : Operation
+            /// @p_Owner     : Owner
+            void Track(UringOperation& p_Operation, std::shared_ptr<void> p_Owner);
+            /// Submit once the current handler returns
+            void ScheduleSubmit();
+            /// Hand queued entries to the kernel
+            void Submit();
+            /// Wait for our eventfd, the kernel signals it when a completion is posted
+            void WaitCompletions();
+            /// Handle every posted completion
+            void Reap();
+            /// Tear the ring down, cancelling whatever the kernel holds
+            void Close();
+
+            /// Unlink an operation from its list
+            /// @p_Link : Link
+            static void Unlink(UringLink* p_Link);
+
+        private:
+            boost::asio::io_service& m_Service;                                     ///< Service reaping our completions
+        #ifdef NETWORK_HAS_IO_URING
+            boost::asio::posix::stream_descriptor m_Event;                          ///< Eventfd signalled on completions
+        #endif
+            NetworkCounters* m_Counters;                                            ///< Counters of our NetworkThread
+            UringLink m_Pending;                                                    ///< Operations the kernel holds
+            int m_Fd;                                                               ///< Ring, -1 until opened
+            /// Submission queue
+            void* m_SqRing;                                                         ///< Mapping of the submission ring
+            std::size_t m_SqRingSize;                                               ///< Size of its mapping
+            void* m_Entries;                                                        ///< Mapping of the submission queue entries
+            std::size_t m_EntriesSize;                                              ///< Size of its mapping
+            uint32* m_SqHead;                                                       ///< Written by the kernel
+            uint32* m_SqTail;                                                       ///< Written by us
+            uint32* m_SqFlags;                                                      ///< Written by the kernel
+            uint32* m_SqArray;                                                      ///< Index of each queued entry
+            uint32 m_SqMask;                                                        ///< Ring mask
+            uint32 m_SqEntries;                                                     ///< Ring size
+            bool m_SubmitPosted;                                                    ///< A submit runs once the current handler returns
+            /// Completion queue
+            void* m_CqRing;                                                         ///< Mapping of the completion ring, may be m_SqRing
+            std::size_t m_CqRingSize;                                               ///< Size of its mapping
+            uint32* m_CqHead;                                                       ///< Written by us
+            uint32* m_CqTail;                                                       ///< Written by the kernel
+            void* m_Completions;                                                    ///< Completion queue entries
+            uint32 m_CqMask;                                                        ///< Ring mask
+            bool m_Reaping;                                                         ///< Reap is on the stack
+            /// Receive buffers
+            void* m_BufferRing;                                                     ///< Ring we give buffers back through
+            std::size_t m_BufferRingSize;                                           ///< Size of its mapping
+            uint8* m_Buffers;                                                       ///< Storage of every buffer
+            uint32 m_BufferCount;                                                   ///< Buffers, a power of 2
+            uint32 m_BufferSize;                                                    ///< Size of each buffer
+            uint16 m_BufferTail;                                                    ///< Next free slot of m_BufferRing
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
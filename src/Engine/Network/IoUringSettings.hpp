@@ -0,0 +1,35 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Ring every NetworkThread runs its plaintext sockets on, with the io_uring backend
+    struct IoUringSettings
+    {
+        uint32 Entries          = 1024;                     ///< Submission queue entries, the completion queue holds four times as many
+        uint32 Buffers          = 1024;                     ///< Receive buffers the kernel picks from, rounded up to a power of 2
+        uint32 BufferSize       = 4096;                     ///< Size of each receive buffer, one receive completes at most this many bytes
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
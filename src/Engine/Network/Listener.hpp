@@ -18,11 +18,17 @@
 
 #pragma once
 #include "PCH/Precompiled.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <limits>
+#include <unordered_map>
 
 #include "Core/Core.hpp"
 #include "Threading/ThrTaskManager.hpp"
 #include "NetworkThread.hpp"
 #include "Socket.hpp"
+#include "HotRestart.hpp"
 #include "Logger/LogDefines.hpp"
 
 namespace SteerStone { namespace Core { namespace Network {
@@ -39,40 +45,213 @@ namespace SteerStone { namespace Core { namespace Network {
             /// @p_Address       : IP Address
             /// @p_Port          : Port
             /// @p_WorkerThreads : Amount of services to spawn
-            Listener(std::string const& p_Address, const uint16& p_Port, const uint8& p_WorkerThreads) 
-                : m_Service(new boost::asio::io_service()),
-                  m_Acceptor(new boost::asio::ip::tcp::acceptor(*m_Service, boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(p_Address), p_Port)))
+            /// @p_Settings      : Settings applied to every socket we accept
+            Listener(std::string const& p_Address, const uint16& p_Port, const uint8& p_WorkerThreads, NetworkSettings const& p_Settings = NetworkSettings()) 
+                : m_Service(new boost::asio::io_service()), m_CacheDomain(-1), m_HandedOff(false)
             {
+                LOG_INFO("Listener", "Using %0 network backend", p_Settings.Backend == NetworkBackend::IoUring ? "io_uring" : "reactor");
+
+                m_EndPoint = boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(p_Address), p_Port);
+
+                /// One context for every NetworkThread, so a client resumes its session whichever thread it lands on
+                std::shared_ptr<TlsContext> l_TlsContext;
+                if (p_Settings.Tls.Enabled)
+                {
+                    l_TlsContext = TlsContext::Create(p_Settings.Tls);
+
+                    /// Never fall back to plaintext
+                    if (!l_TlsContext)
+                    {
+                        LOG_ERROR("Listener", "TLS could not be set up, not accepting connections on %0:%1", p_Address, p_Port);
+                        return;
+                    }
+
+                    LOG_INFO("Listener", "Accepting TLS connections, kernel TLS %0", p_Settings.Tls.KernelTls ? "when available" : "disabled");
+                }
+
+                /// Our NetworkThreads, accept loop and the consumer of our inbound queues share one last level cache
+                NetworkSettings l_Settings = p_Settings;
+                if (l_Settings.CacheDomain < 0 || static_cast<uint32>(l_Settings.CacheDomain) >= sTopology->GetCacheDomainCount())
+                {
+                    if (l_Settings.CacheDomain >= 0)
+                        LOG_WARNING("Listener", "Cache domain %0 does not exist, this host has %1", l_Settings.CacheDomain, sTopology->GetCacheDomainCount());
+
+                    l_Settings.CacheDomain = sTopology->GetDefaultCacheDomain();
+                }
+
+                m_CacheDomain = l_Settings.CacheDomain;
+
+                /// Limits count every connection of ours, whichever acceptor took it
+                std::shared_ptr<AdmissionControl> l_Admission = std::make_shared<AdmissionControl>(p_Settings.Admission);
+
                 for (uint8 l_I = 0; l_I < p_WorkerThreads; l_I++)
-                    m_NetworkThreads.push_back(std::unique_ptr<NetworkThread<T>>(new NetworkThread<T>(l_I)));
+                    m_NetworkThreads.push_back(std::unique_ptr<NetworkThread<T>>(new NetworkThread<T>(l_I, l_Settings, l_TlsContext, l_Admission)));
+
+                /// A process we replace may be waiting to hand over its acceptors and connections
+                HotRestartState l_Inherited;
+                const bool l_HotRestart = !p_Settings.HotRestartPath.empty() && HotRestart::Receive(p_Settings.HotRestartPath, l_Inherited);
+
+                if (l_HotRestart)
+                    LOG_INFO("Listener", "Hot restart, resuming %0 acceptors and %1 connections", l_Inherited.Acceptors.size(), l_Inherited.Sockets.size());
+
+                bool l_ReusePort = p_Settings.ReusePort;
+
+            #ifndef NETWORK_HAS_REUSEPORT
+                if (l_ReusePort)
+                {
+                    LOG_WARNING("Listener", "SO_REUSEPORT is not supported on this platform, using a single acceptor");
+                    l_ReusePort = false;
+                }
+            #endif
+
+                /// Every NetworkThread accepts on its own, we do not need an accept loop
+                if (l_ReusePort)
+                {
+                    if (!l_HotRestart)
+                    {
+                        for (auto& l_NetworkThread : m_NetworkThreads)
+                            l_NetworkThread->StartAccept(m_EndPoint);
+                    }
+
+                    LOG_INFO("Listener", "Accepting on %0:%1 with %2 SO_REUSEPORT acceptors", p_Address, p_Port, m_NetworkThreads.size());
+                }
+                else
+                {
+                    m_Acceptor.reset(l_HotRestart ? new boost::asio::ip::tcp::acceptor(*m_Service) : new boost::asio::ip::tcp::acceptor(*m_Service, m_EndPoint));
+
+                    if (!l_HotRestart)
+                        BeginAccept(m_Acceptor.get());
+                }
+
+                if (l_HotRestart)
+                    AdoptState(l_Inherited);
+
+                if (!p_Settings.HotRestartPath.empty())
+                    StartHotRestart(p_Settings.HotRestartPath);
+
+                if (p_Settings.Balance.Interval)
+                    StartBalance(p_Settings.Balance);
+
+                if (!m_Acceptor && m_SurplusAcceptors.empty() && m_HotRestartPath.empty() && !m_BalanceTimer)
+                    return;
 
                 std::function<bool()> l_Service = [this]() -> bool {
                     this->m_Service->run();
                     return true;
                 };
 
-                BeginAccept();
-
-                m_AcceptorTask = sThreadManager->PushTask("LISTENER_THREAD", Threading::TaskType::Moderate, 0, l_Service);
+                m_AcceptorTask = sThreadManager->PushTask("LISTENER_THREAD", Threading::TaskType::Moderate, 0, l_Service, m_CacheDomain);
             }
             /// Deconstructor
             ~Listener()
             {
-                m_Acceptor->close();
+                if (m_Acceptor)
+                    m_Acceptor->close();
+
+                for (auto& l_Acceptor : m_SurplusAcceptors)
+                    l_Acceptor->close();
+
+            #ifdef NETWORK_HAS_HOT_RESTART
+                if (m_HotRestartAcceptor)
+                {
+                    boost::system::error_code l_ErrorCode;
+                    m_HotRestartAcceptor->close(l_ErrorCode);
+
+                    /// After a hand off the path belongs to our successor
+                    if (!m_HandedOff)
+                        std::remove(m_HotRestartPath.c_str());
+                }
+            #endif
+
                 m_Service->stop();
-                sThreadManager->PopTask(m_AcceptorTask);
+
+                if (m_AcceptorTask)
+                    sThreadManager->PopTask(m_AcceptorTask);
+
+                /// A socket which moved still hands its frames to the inbound queue of the thread it came from,
+                /// so every NetworkThread stops before any of them goes away
+                for (auto& l_NetworkThread : m_NetworkThreads)
+                    l_NetworkThread->Stop();
+
+                m_BalanceTimer.reset();
                 m_Acceptor.reset();
+                m_SurplusAcceptors.clear();
+            #ifdef NETWORK_HAS_HOT_RESTART
+                m_HotRestartAcceptor.reset();
+            #endif
                 m_Service.reset();
             }
 
             //////////////////////////////////////////////////////////////////////////
             //////////////////////////////////////////////////////////////////////////
 
+            /// Check if our acceptors and connections were handed to a new process, we have nothing left to serve
+            bool IsHandedOff() const
+            {
+                return m_HandedOff.load(std::memory_order_acquire);
+            }
+            /// Get the cache domain our threads run on, push the task draining our inbound queues there, -1 before we start
+            int32 GetCacheDomain() const
+            {
+                return m_CacheDomain;
+            }
+
+            /// Get the counters of every NetworkThread merged, never locks
+            NetworkCountersSnapshot GetCounters() const
+            {
+                NetworkCountersSnapshot l_Snapshot;
+                l_Snapshot.Time = std::chrono::steady_clock::now();
+
+                for (auto const& l_NetworkThread : m_NetworkThreads)
+                    l_Snapshot.Merge(l_NetworkThread->GetCounters());
+
+                return l_Snapshot;
+            }
+            /// Handle frames queued by every NetworkThread, from the game tick only
+            /// @p_Handler : Called with each InboundMessage
+            /// @p_Max     : Largest batch taken from each NetworkThread
+            template <typename Handler> std::size_t DrainInbound(Handler&& p_Handler, std::size_t const p_Max)
+            {
+                std::size_t l_Count = 0;
+
+                for (auto const& l_NetworkThread : m_NetworkThreads)
+                    l_Count += l_NetworkThread->GetInboundQueue().Drain(p_Handler, p_Max);
+
+                return l_Count;
+            }
+            /// Get the depth metrics of the inbound queue of each NetworkThread
+            std::vector<InboundQueueStats> GetInboundStats() const
+            {
+                std::vector<InboundQueueStats> l_Stats;
+
+                for (auto const& l_NetworkThread : m_NetworkThreads)
+                    l_Stats.push_back(l_NetworkThread->GetInboundQueue().GetStats());
+
+                return l_Stats;
+            }
+            /// Get the counters of every socket
+            std::vector<SocketCountersSnapshot> GetSocketCounters() const
+            {
+                std::vector<SocketCountersSnapshot> l_Counters;
+
+                for (auto const& l_NetworkThread : m_NetworkThreads)
+                {
+                    std::vector<SocketCountersSnapshot> l_ThreadCounters = l_NetworkThread->GetSocketCounters();
+                    l_Counters.insert(l_Counters.end(), l_ThreadCounters.begin(), l_ThreadCounters.end());
+                }
+
+                return l_Counters;
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
         private:
             /// Select the worker with lowest storage size (equal distrubition)
+            /// Only reads each worker's atomic socket count, so it never contends with the workers
             NetworkThread<T>* SelectWorker() const
             {
-                std::size_t l_MinimumSize = m_NetworkThreads.size();
+                std::size_t l_MinimumSize = std::numeric_limits<std::size_t>::max();
                 std::size_t l_Index = 0;
 
                 for (std::size_t l_I = 0; l_I < m_NetworkThreads.size(); l_I++)
@@ -89,34 +268,399 @@ namespace SteerStone { namespace Core { namespace Network {
                 return m_NetworkThreads[l_Index].get();
             }
             /// Accept incoming connections
-            void Listener<T>::BeginAccept()
+            /// The connection is accepted bare on the service of its worker, its socket is only created once it is admitted
+            /// @p_Acceptor : Our acceptor or one of our surplus acceptors
+            void BeginAccept(boost::asio::ip::tcp::acceptor* p_Acceptor)
             {
                 auto l_Worker = SelectWorker();
-                auto l_Socket = l_Worker->CreateSocket();
 
-                m_Acceptor->async_accept(l_Socket->GetAsioSocket(),
-                    [this, l_Worker, l_Socket](const boost::system::error_code& p_ErrorCode)
+                p_Acceptor->async_accept(l_Worker->GetService(),
+                    [this, p_Acceptor, l_Worker](const boost::system::error_code& p_ErrorCode, boost::asio::ip::tcp::socket p_Peer)
                     {
-                        this->OnAccept(l_Worker, l_Socket, p_ErrorCode);
+                        this->OnAccept(p_Acceptor, l_Worker, std::move(p_Peer), p_ErrorCode);
                     });
             }
-            /// Accept new connection and create socket
-            void Listener<T>::OnAccept(NetworkThread<T>* p_Worker, std::shared_ptr<T> const& p_Socket, const boost::system::error_code& p_ErrorCode)
+            /// Admit new connection and create socket
+            void OnAccept(boost::asio::ip::tcp::acceptor* p_Acceptor, NetworkThread<T>* p_Worker, boost::asio::ip::tcp::socket&& p_Peer, const boost::system::error_code& p_ErrorCode)
             {
-                if (p_ErrorCode)
-                    p_Worker->RemoveSocket(p_Socket.get());
-                else
-                    p_Socket->Open();
+                if (!p_ErrorCode)
+                    p_Worker->Admit(std::move(p_Peer));
+
+                /// Acceptor closed or handed over
+                if (p_ErrorCode == boost::asio::error::operation_aborted || !p_Acceptor->is_open())
+                    return;
 
                 /// Return back and accept any more incoming connections
-                BeginAccept();
+                BeginAccept(p_Acceptor);
+            }
+
+            /// Bind and listen on our end point with our acceptor, logs instead of throwing
+            bool OpenAcceptor()
+            {
+                boost::system::error_code l_ErrorCode;
+
+                m_Acceptor.reset(new boost::asio::ip::tcp::acceptor(*m_Service));
+                m_Acceptor->open(m_EndPoint.protocol(), l_ErrorCode);
+
+                if (!l_ErrorCode)
+                    m_Acceptor->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true), l_ErrorCode);
+
+                if (!l_ErrorCode)
+                    m_Acceptor->bind(m_EndPoint, l_ErrorCode);
+
+                if (!l_ErrorCode)
+                    m_Acceptor->listen(boost::asio::socket_base::max_listen_connections, l_ErrorCode);
+
+                if (l_ErrorCode)
+                {
+                    LOG_ERROR("Listener", "Failed to accept on %0: %1", m_EndPoint, l_ErrorCode.message());
+
+                    boost::system::error_code l_CloseError;
+                    m_Acceptor->close(l_CloseError);
+                    return false;
+                }
+
+                return true;
+            }
+            /// Resume acceptors and connections, handed over by the process we replace or taken back after a failed hand off
+            /// Our acceptor takes the first listening descriptor, in ReusePort mode each NetworkThread takes the next one,
+            /// any left over keep accepting on our own service
+            /// @p_State : State, we own its descriptors
+            void AdoptState(HotRestartState& p_State)
+            {
+                std::size_t l_Next = 0;
+
+                if (m_Acceptor)
+                {
+                    boost::system::error_code l_ErrorCode;
+
+                    if (l_Next < p_State.Acceptors.size())
+                    {
+                        m_Acceptor->assign(m_EndPoint.protocol(), p_State.Acceptors[l_Next++], l_ErrorCode);
+
+                        if (l_ErrorCode)
+                        {
+                            LOG_ERROR("Listener", "Failed to adopt acceptor: %0, binding a new one", l_ErrorCode.message());
+
+                        #ifdef NETWORK_HAS_HOT_RESTART
+                            /// Not assigned, nobody owns the descriptor
+                            ::close(p_State.Acceptors[l_Next - 1]);
+                        #endif
+                        }
+                    }
+
+                    /// Nothing to adopt, bind like a cold start
+                    if (l_ErrorCode || !m_Acceptor->is_open())
+                        OpenAcceptor();
+
+                    if (m_Acceptor->is_open())
+                        BeginAccept(m_Acceptor.get());
+                }
+                else
+                {
+                    for (auto& l_NetworkThread : m_NetworkThreads)
+                    {
+                        /// The descriptor may be gone, never leave a NetworkThread without an acceptor
+                        if (l_Next < p_State.Acceptors.size() && l_NetworkThread->AdoptAcceptor(m_EndPoint, p_State.Acceptors[l_Next++]))
+                            continue;
+
+                        l_NetworkThread->StartAccept(m_EndPoint);
+                    }
+                }
+
+                /// More acceptors than we accept on, the process we replace ran more SO_REUSEPORT acceptors.
+                /// Closing one resets the connections queued on it, so we keep accepting on them from our own service
+                for (; l_Next < p_State.Acceptors.size(); l_Next++)
+                {
+                    boost::system::error_code l_ErrorCode;
+                    std::unique_ptr<boost::asio::ip::tcp::acceptor> l_Acceptor(new boost::asio::ip::tcp::acceptor(*m_Service));
+                    l_Acceptor->assign(m_EndPoint.protocol(), p_State.Acceptors[l_Next], l_ErrorCode);
+
+                    if (l_ErrorCode)
+                    {
+                        LOG_ERROR("Listener", "Failed to adopt acceptor: %0", l_ErrorCode.message());
+
+                    #ifdef NETWORK_HAS_HOT_RESTART
+                        /// Not assigned, nobody owns the descriptor
+                        ::close(p_State.Acceptors[l_Next]);
+                    #endif
+                        continue;
+                    }
+
+                    BeginAccept(l_Acceptor.get());
+                    m_SurplusAcceptors.push_back(std::move(l_Acceptor));
+                }
+
+                for (SocketHandoff& l_Handoff : p_State.Sockets)
+                    SelectWorker()->AdoptSocket(std::move(l_Handoff));
+
+                p_State.Acceptors.clear();
+                p_State.Sockets.clear();
+            }
+            /// Wait for a process to replace us on p_Path
+            /// @p_Path : Unix socket path
+            void StartHotRestart(std::string const& p_Path)
+            {
+            #ifdef NETWORK_HAS_HOT_RESTART
+                /// Our predecessor, or a process which crashed, left its path behind
+                std::remove(p_Path.c_str());
+
+                boost::system::error_code l_ErrorCode;
+                m_HotRestartAcceptor.reset(new HotRestartAcceptor(*m_Service));
+                m_HotRestartAcceptor->open(HotRestartProtocol(AF_UNIX, 0), l_ErrorCode);
+
+                if (!l_ErrorCode)
+                    m_HotRestartAcceptor->bind(GetHotRestartEndPoint(p_Path), l_ErrorCode);
+
+                if (!l_ErrorCode)
+                    m_HotRestartAcceptor->listen(1, l_ErrorCode);
+
+                if (l_ErrorCode)
+                {
+                    LOG_ERROR("Listener", "Failed to listen for hot restart on %0: %1", p_Path, l_ErrorCode.message());
+                    m_HotRestartAcceptor.reset();
+                    return;
+                }
+
+                m_HotRestartPath = p_Path;
+
+                BeginHotRestartAccept();
+            #else
+                LOG_WARNING("Listener", "Hot restart needs unix sockets, which this platform does not have");
+                UNUSED(p_Path);
+            #endif
+            }
+        #ifdef NETWORK_HAS_HOT_RESTART
+            /// Wait for the next process to replace us
+            void BeginHotRestartAccept()
+            {
+                m_HotRestartAcceptor->async_accept(
+                    [this](boost::system::error_code const& p_ErrorCode, HotRestartProtocol::socket p_Channel)
+                    {
+                        if (p_ErrorCode == boost::asio::error::operation_aborted)
+                            return;
+
+                        /// Once handed off we have nothing left to hand
+                        if (!p_ErrorCode && this->HandOff(p_Channel))
+                            return;
+
+                        this->BeginHotRestartAccept();
+                    });
+            }
+            /// Hand our acceptors and connections to the process replacing us, from our thread
+            /// We keep serving them if it does not take them
+            /// @p_Channel : Connection of our successor
+            bool HandOff(HotRestartProtocol::socket& p_Channel)
+            {
+                LOG_INFO("Listener", "Hot restart, handing our connections over to a new process");
+
+                HotRestartState l_State;
+
+                /// Stop accepting first, connections arriving from now on wait in the backlog for our successor
+                if (m_Acceptor && m_Acceptor->is_open())
+                {
+                    boost::system::error_code l_ErrorCode;
+                    const int l_Fd = m_Acceptor->release(l_ErrorCode);
+
+                    if (!l_ErrorCode)
+                        l_State.Acceptors.push_back(l_Fd);
+                }
+
+                for (auto& l_NetworkThread : m_NetworkThreads)
+                {
+                    const int l_Fd = l_NetworkThread->ReleaseAcceptor();
+
+                    if (l_Fd != -1)
+                        l_State.Acceptors.push_back(l_Fd);
+                }
+
+                for (auto& l_Acceptor : m_SurplusAcceptors)
+                {
+                    boost::system::error_code l_ErrorCode;
+                    const int l_Fd = l_Acceptor->release(l_ErrorCode);
+
+                    if (!l_ErrorCode)
+                        l_State.Acceptors.push_back(l_Fd);
+                }
+
+                m_SurplusAcceptors.clear();
+
+                std::vector<std::shared_ptr<T>> l_Retained;
+
+                for (auto& l_NetworkThread : m_NetworkThreads)
+                    l_NetworkThread->DetachSockets(l_State.Sockets, l_Retained);
+
+                boost::system::error_code l_ErrorCode;
+                p_Channel.non_blocking(false, l_ErrorCode);
+
+                if (!HotRestart::Send(p_Channel.native_handle(), l_State))
+                {
+                    LOG_ERROR("Listener", "Hot restart failed, resuming %0 connections", l_State.Sockets.size());
+                    AdoptState(l_State);
+                    return false;
+                }
+
+                LOG_INFO("Listener", "Hot restart, %0 acceptors and %1 connections handed over", l_State.Acceptors.size(), l_State.Sockets.size());
+
+                /// Our successor has its own copies now
+                HotRestart::Close(l_State);
+
+                /// Clients it could not take reconnect to it
+                for (auto const& l_Socket : l_Retained)
+                    l_Socket->Post([l_Socket]() { l_Socket->CloseSocket(); });
+                m_HandedOff.store(true, std::memory_order_release);
+
+                return true;
+            }
+        #endif
+
+            /// Look at the load of our NetworkThreads every p_Policy.Interval milliseconds
+            /// @p_Policy : Policy
+            void StartBalance(BalancePolicy const& p_Policy)
+            {
+            #ifdef NETWORK_HAS_MIGRATION
+                if (m_NetworkThreads.size() < 2)
+                    return;
+
+                m_Balance = p_Policy;
+                m_BalanceTimer.reset(new boost::asio::steady_timer(*m_Service));
+
+                for (auto const& l_NetworkThread : m_NetworkThreads)
+                    m_BalanceCounters.push_back(l_NetworkThread->GetCounters());
+
+                BeginBalance();
+            #else
+                LOG_WARNING("Listener", "Connections cannot move between NetworkThreads on this platform, not balancing");
+                UNUSED(p_Policy);
+            #endif
+            }
+            /// Wait for the next look at the load of our NetworkThreads
+            void BeginBalance()
+            {
+                m_BalanceTimer->expires_after(std::chrono::milliseconds(m_Balance.Interval));
+                m_BalanceTimer->async_wait([this](boost::system::error_code const& p_ErrorCode)
+                {
+                    /// Shutting down, or our connections belong to a new process
+                    if (p_ErrorCode == boost::asio::error::operation_aborted || this->IsHandedOff())
+                        return;
+
+                    this->Balance();
+                    this->BeginBalance();
+                });
+            }
+            /// Move the busiest connections of a NetworkThread much busier than the average to the least busy one
+            /// Load is the CPU time of each thread where threads have a CPU clock, the bytes they moved otherwise;
+            /// connections are picked by the bytes they moved since the last look
+            void Balance()
+            {
+                std::vector<NetworkCountersSnapshot> l_Counters;
+                for (auto const& l_NetworkThread : m_NetworkThreads)
+                    l_Counters.push_back(l_NetworkThread->GetCounters());
+
+                const bool l_HasCPUTime = std::all_of(l_Counters.begin(), l_Counters.end(), [](NetworkCountersSnapshot const& p_Counters) { return p_Counters.CPUTime != 0; });
+
+                std::vector<uint64> l_Load(l_Counters.size());
+                std::vector<uint64> l_Bytes(l_Counters.size());
+                uint64 l_Total = 0;
+                std::size_t l_Hot = 0;
+                std::size_t l_Cold = 0;
+
+                for (std::size_t l_I = 0; l_I < l_Counters.size(); l_I++)
+                {
+                    NetworkCountersSnapshot const& l_Previous = m_BalanceCounters[l_I];
+
+                    l_Bytes[l_I] = (l_Counters[l_I].BytesIn - l_Previous.BytesIn) + (l_Counters[l_I].BytesOut - l_Previous.BytesOut);
+                    l_Load[l_I]  = l_HasCPUTime ? l_Counters[l_I].CPUTime - l_Previous.CPUTime : l_Bytes[l_I];
+                    l_Total     += l_Load[l_I];
+
+                    if (l_Load[l_I] > l_Load[l_Hot])
+                        l_Hot = l_I;
+                    if (l_Load[l_I] < l_Load[l_Cold])
+                        l_Cold = l_I;
+                }
+
+                const double l_Seconds = std::chrono::duration<double>(l_Counters[0].Time - m_BalanceCounters[0].Time).count();
+                m_BalanceCounters = std::move(l_Counters);
+
+                const uint64 l_Average = l_Total / l_Load.size();
+
+                /// Balanced enough, or too idle for a move to be worth it (only known with a CPU clock)
+                if (!l_Bytes[l_Hot] || l_Load[l_Hot] * 100 <= l_Average * (100 + m_Balance.Threshold)
+                    || (l_HasCPUTime && l_Load[l_Hot] < l_Seconds * 10000.0 * m_Balance.MinLoad))
+                {
+                    m_BalanceBytes.clear();
+                    return;
+                }
+
+                /// Bytes of each connection since the last look, the first look after a quiet spell only takes them
+                std::unordered_map<uint64, uint64> l_SessionBytes;
+                std::vector<std::pair<uint64, SocketHandle>> l_Candidates;
+
+                for (std::size_t l_I = 0; l_I < m_NetworkThreads.size(); l_I++)
+                {
+                    for (SocketCountersSnapshot const& l_Socket : m_NetworkThreads[l_I]->GetSocketCounters())
+                    {
+                        const uint64 l_SocketBytes = l_Socket.BytesIn + l_Socket.BytesOut;
+                        l_SessionBytes[l_Socket.SessionId] = l_SocketBytes;
+
+                        if (l_I != l_Hot)
+                            continue;
+
+                        auto const l_Previous = m_BalanceBytes.find(l_Socket.SessionId);
+                        if (l_Previous != m_BalanceBytes.end() && l_SocketBytes > l_Previous->second)
+                            l_Candidates.emplace_back(l_SocketBytes - l_Previous->second, l_Socket.Handle);
+                    }
+                }
+
+                m_BalanceBytes.swap(l_SessionBytes);
+
+                /// Take the hot thread down to the average without taking the cold one above it
+                const uint64 l_Shed = std::min(l_Load[l_Hot] - l_Average, l_Average - l_Load[l_Cold]);
+                uint64 l_Excess = static_cast<uint64>(static_cast<double>(l_Bytes[l_Hot]) * l_Shed / l_Load[l_Hot]);
+
+                std::sort(l_Candidates.begin(), l_Candidates.end(), [](std::pair<uint64, SocketHandle> const& p_Left, std::pair<uint64, SocketHandle> const& p_Right)
+                {
+                    return p_Left.first > p_Right.first;
+                });
+
+                uint32 l_Moved = 0;
+                for (auto const& l_Candidate : l_Candidates)
+                {
+                    if (l_Moved >= m_Balance.MaxMigrations)
+                        break;
+
+                    /// Moving it would only make the cold thread the hot one
+                    if (l_Candidate.first > l_Excess)
+                        continue;
+
+                    m_NetworkThreads[l_Hot]->MigrateSocket(l_Candidate.second, m_NetworkThreads[l_Cold].get());
+
+                    l_Excess -= l_Candidate.first;
+                    l_Moved++;
+                }
+
+                if (l_Moved)
+                    LOG_INFO("Listener", "NetworkThread %0 is %1 percent busier than average, moving %2 connections to NetworkThread %3",
+                        l_Hot, l_Average ? (l_Load[l_Hot] - l_Average) * 100 / l_Average : 100, l_Moved, l_Cold);
             }
 
         private:
             std::unique_ptr<boost::asio::io_service> m_Service;                     ///< IO Service
             std::vector<std::unique_ptr<NetworkThread<T>>> m_NetworkThreads;        ///< Worker threads
-            std::unique_ptr<boost::asio::ip::tcp::acceptor> m_Acceptor;             ///< IO Acceptor
-            Threading::Task::Ptr m_AcceptorTask;                                    ///< Acceptor Task
+            std::unique_ptr<boost::asio::ip::tcp::acceptor> m_Acceptor;             ///< IO Acceptor (not used in ReusePort mode)
+            std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> m_SurplusAcceptors;    ///< Adopted acceptors beyond the ones we accept on
+            Threading::Task::Ptr m_AcceptorTask;                                    ///< Acceptor Task (not used in ReusePort mode without hot restart)
+            boost::asio::ip::tcp::endpoint m_EndPoint;                              ///< End point we accept on
+        #ifdef NETWORK_HAS_HOT_RESTART
+            std::unique_ptr<HotRestartAcceptor> m_HotRestartAcceptor;             ///< Waits for the process replacing us
+        #endif
+            std::string m_HotRestartPath;                                           ///< Unix socket path of m_HotRestartAcceptor
+            int32 m_CacheDomain;                                                    ///< Last level cache domain of our threads
+            std::atomic<bool> m_HandedOff;                                          ///< Our acceptors and connections belong to a new process
+            BalancePolicy m_Balance;                                                ///< When connections move between our NetworkThreads
+            std::unique_ptr<boost::asio::steady_timer> m_BalanceTimer;              ///< Runs the balancer, null unless it is enabled
+            std::vector<NetworkCountersSnapshot> m_BalanceCounters;                 ///< Counters of each NetworkThread at the last look
+            std::unordered_map<uint64, uint64> m_BalanceBytes;                      ///< Bytes of each session at the last look, empty while balanced
     };
 
 }   ///< namespace Network
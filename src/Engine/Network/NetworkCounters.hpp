@@ -0,0 +1,215 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include "Core/Core.hpp"
+#include "Diagnostic/DiaHistogram.hpp"
+
+#define NETWORK_CACHE_LINE_SIZE 64
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Counter alone on its cache line, so threads bumping neighbouring counters never share a line
+    struct alignas(NETWORK_CACHE_LINE_SIZE) PaddedCounter
+    {
+        std::atomic<uint64> Value{ 0 };     ///< Value
+
+        /// Add to the counter
+        /// @p_Value : Amount
+        void Add(uint64 const p_Value)
+        {
+            Value.fetch_add(p_Value, std::memory_order_relaxed);
+        }
+        /// Get the counter, may be a little behind the threads bumping it
+        uint64 Get() const
+        {
+            return Value.load(std::memory_order_relaxed);
+        }
+    };
+
+    /// Copy of the counters, safe to keep, merge and compare
+    struct NetworkCountersSnapshot
+    {
+        std::chrono::steady_clock::time_point Time; ///< When the snapshot was taken
+        uint64 BytesIn          = 0;                ///< Bytes read
+        uint64 MessagesIn       = 0;                ///< Frames handled
+        uint64 BytesOut         = 0;                ///< Bytes sent
+        uint64 MessagesOut      = 0;                ///< Messages queued
+        uint64 ReadCalls        = 0;                ///< Read syscalls
+        uint64 WriteCalls       = 0;                ///< Write syscalls
+        uint64 PartialWrites    = 0;                ///< Write syscalls which sent less than was queued
+        uint64 BufferGrows      = 0;                ///< In buffer grows to fit a large frame
+        uint64 Accepts          = 0;                ///< Connections accepted
+        uint64 Rejects          = 0;                ///< Connections turned away by admission control
+        uint64 HandlerHeapAllocs = 0;               ///< Completion handler memory taken from the heap
+        uint64 InboundOverflows = 0;                ///< Clients disconnected for a frame over the inbound limit
+        uint64 ReadPauses       = 0;                ///< Reads paused until the game tick handled the frames of a socket
+        uint64 TlsHandshakes    = 0;                ///< TLS handshakes completed
+        uint64 TlsResumed       = 0;                ///< TLS handshakes which resumed a session
+        uint64 TlsKernelSend    = 0;                ///< TLS connections whose records the kernel encrypts
+        uint64 Migrations       = 0;                ///< Connections moved in from another NetworkThread
+        uint64 RingEnters       = 0;                ///< io_uring_enter syscalls, submissions of a whole batch of reads and writes
+        uint64 CPUTime          = 0;                ///< Microseconds the NetworkThread ran on a CPU, 0 where threads have no CPU clock
+        Diagnostic::Histogram FlushLatency;         ///< Buffering to flush latency, in microseconds
+
+        /// Add the counters of another snapshot into this one
+        /// @p_Other : Snapshot to merge
+        void Merge(NetworkCountersSnapshot const& p_Other)
+        {
+            BytesIn         += p_Other.BytesIn;
+            MessagesIn      += p_Other.MessagesIn;
+            BytesOut        += p_Other.BytesOut;
+            MessagesOut     += p_Other.MessagesOut;
+            ReadCalls       += p_Other.ReadCalls;
+            WriteCalls      += p_Other.WriteCalls;
+            PartialWrites   += p_Other.PartialWrites;
+            BufferGrows     += p_Other.BufferGrows;
+            Accepts         += p_Other.Accepts;
+            Rejects         += p_Other.Rejects;
+            HandlerHeapAllocs += p_Other.HandlerHeapAllocs;
+            InboundOverflows += p_Other.InboundOverflows;
+            ReadPauses      += p_Other.ReadPauses;
+            TlsHandshakes   += p_Other.TlsHandshakes;
+            TlsResumed      += p_Other.TlsResumed;
+            TlsKernelSend   += p_Other.TlsKernelSend;
+            Migrations      += p_Other.Migrations;
+            RingEnters      += p_Other.RingEnters;
+            CPUTime         += p_Other.CPUTime;
+            FlushLatency.Merge(p_Other.FlushLatency);
+        }
+        /// Get how fast a counter went up since an older snapshot, per second
+        /// @p_Counter  : Counter, e.g &NetworkCountersSnapshot::Accepts
+        /// @p_Previous : Older snapshot
+        double GetRate(uint64 NetworkCountersSnapshot::* p_Counter, NetworkCountersSnapshot const& p_Previous) const
+        {
+            const double l_Seconds = std::chrono::duration<double>(Time - p_Previous.Time).count();
+            if (l_Seconds <= 0.0)
+                return 0.0;
+
+            return (this->*p_Counter - p_Previous.*p_Counter) / l_Seconds;
+        }
+    };
+
+    /// Counters of one NetworkThread
+    /// Every counter has its own cache line; bumping one is a single relaxed add and never locks,
+    /// a snapshot only reads them
+    struct NetworkCounters
+    {
+        PaddedCounter BytesIn;                      ///< Bytes read
+        PaddedCounter MessagesIn;                   ///< Frames handled
+        PaddedCounter BytesOut;                     ///< Bytes sent
+        PaddedCounter MessagesOut;                  ///< Messages queued, bumped by whichever thread writes
+        PaddedCounter ReadCalls;                    ///< Read syscalls
+        PaddedCounter WriteCalls;                   ///< Write syscalls
+        PaddedCounter PartialWrites;                ///< Write syscalls which sent less than was queued
+        PaddedCounter BufferGrows;                  ///< In buffer grows to fit a large frame
+        PaddedCounter Accepts;                      ///< Connections accepted
+        PaddedCounter Rejects;                      ///< Connections turned away by admission control
+        PaddedCounter HandlerHeapAllocs;            ///< Completion handler memory taken from the heap, 0 once warm
+        PaddedCounter InboundOverflows;             ///< Clients disconnected for a frame over the inbound limit
+        PaddedCounter ReadPauses;                   ///< Reads paused until the game tick handled the frames of a socket
+        PaddedCounter TlsHandshakes;                ///< TLS handshakes completed
+        PaddedCounter TlsResumed;                   ///< TLS handshakes which resumed a session
+        PaddedCounter TlsKernelSend;                ///< TLS connections whose records the kernel encrypts
+        PaddedCounter Migrations;                   ///< Connections moved in from another NetworkThread
+        PaddedCounter RingEnters;                   ///< io_uring_enter syscalls, submissions of a whole batch of reads and writes
+
+        /// Only written by the NetworkThread
+        alignas(NETWORK_CACHE_LINE_SIZE) std::array<std::atomic<uint32>, HISTOGRAM_BUCKET_COUNT> FlushLatency{};
+        std::atomic<uint64> FlushLatencyMax{ 0 };
+
+        /// Record a flush latency, from the NetworkThread only
+        /// @p_Value : Microseconds
+        void RecordFlushLatency(uint64 const p_Value)
+        {
+            FlushLatency[Diagnostic::Histogram::GetBucketIndex(p_Value)].fetch_add(1, std::memory_order_relaxed);
+
+            if (p_Value > FlushLatencyMax.load(std::memory_order_relaxed))
+                FlushLatencyMax.store(p_Value, std::memory_order_relaxed);
+        }
+        /// Take a snapshot of the counters
+        NetworkCountersSnapshot GetSnapshot() const
+        {
+            NetworkCountersSnapshot l_Snapshot;
+            l_Snapshot.Time             = std::chrono::steady_clock::now();
+            l_Snapshot.BytesIn          = BytesIn.Get();
+            l_Snapshot.MessagesIn       = MessagesIn.Get();
+            l_Snapshot.BytesOut         = BytesOut.Get();
+            l_Snapshot.MessagesOut      = MessagesOut.Get();
+            l_Snapshot.ReadCalls        = ReadCalls.Get();
+            l_Snapshot.WriteCalls       = WriteCalls.Get();
+            l_Snapshot.PartialWrites    = PartialWrites.Get();
+            l_Snapshot.BufferGrows      = BufferGrows.Get();
+            l_Snapshot.Accepts          = Accepts.Get();
+            l_Snapshot.Rejects          = Rejects.Get();
+            l_Snapshot.HandlerHeapAllocs = HandlerHeapAllocs.Get();
+            l_Snapshot.InboundOverflows = InboundOverflows.Get();
+            l_Snapshot.ReadPauses       = ReadPauses.Get();
+            l_Snapshot.TlsHandshakes    = TlsHandshakes.Get();
+            l_Snapshot.TlsResumed       = TlsResumed.Get();
+            l_Snapshot.TlsKernelSend    = TlsKernelSend.Get();
+            l_Snapshot.Migrations       = Migrations.Get();
+            l_Snapshot.RingEnters       = RingEnters.Get();
+
+            const uint64 l_Max = FlushLatencyMax.load(std::memory_order_relaxed);
+            for (std::size_t l_I = 0; l_I < HISTOGRAM_BUCKET_COUNT; l_I++)
+                l_Snapshot.FlushLatency.AddBucket(l_I, FlushLatency[l_I].load(std::memory_order_relaxed), l_Max);
+
+            return l_Snapshot;
+        }
+    };
+
+    /// Counters of one socket, to find the client behind a busy NetworkThread
+    struct SocketCounters
+    {
+        std::atomic<uint64> BytesIn         { 0 };  ///< Bytes read
+        std::atomic<uint64> MessagesIn      { 0 };  ///< Frames handled
+        std::atomic<uint64> BytesOut        { 0 };  ///< Bytes sent
+        std::atomic<uint64> MessagesOut     { 0 };  ///< Messages queued
+        std::atomic<uint64> ReadCalls       { 0 };  ///< Read syscalls
+        std::atomic<uint64> WriteCalls      { 0 };  ///< Write syscalls
+        std::atomic<uint64> PartialWrites   { 0 };  ///< Write syscalls which sent less than was queued
+        std::atomic<uint64> BufferGrows     { 0 };  ///< In buffer grows to fit a large frame
+        std::atomic<uint64> ReadPauses      { 0 };  ///< Reads paused until the game tick handled our frames
+    };
+
+    /// Copy of the counters of one socket
+    struct SocketCountersSnapshot
+    {
+        uint64 Handle           = 0;                ///< Handle in the NetworkThread registry
+        uint64 SessionId        = 0;                ///< Session, kept when the socket moves to another NetworkThread
+        std::string Address;                        ///< Remote address
+        uint64 BytesIn          = 0;                ///< Bytes read
+        uint64 MessagesIn       = 0;                ///< Frames handled
+        uint64 BytesOut         = 0;                ///< Bytes sent
+        uint64 MessagesOut      = 0;                ///< Messages queued
+        uint64 ReadCalls        = 0;                ///< Read syscalls
+        uint64 WriteCalls       = 0;                ///< Write syscalls
+        uint64 PartialWrites    = 0;                ///< Write syscalls which sent less than was queued
+        uint64 BufferGrows      = 0;                ///< In buffer grows to fit a large frame
+        uint64 ReadPauses       = 0;                ///< Reads paused until the game tick handled our frames
+        std::size_t Queued      = 0;                ///< Unsent bytes
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
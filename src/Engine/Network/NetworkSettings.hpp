@@ -0,0 +1,60 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <string>
+#include "Core/Core.hpp"
+#include "FlushPolicy.hpp"
+#include "OutboundLimits.hpp"
+#include "InboundLimits.hpp"
+#include "TlsSettings.hpp"
+#include "IoUringSettings.hpp"
+#include "BalancePolicy.hpp"
+#include "AdmissionPolicy.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// What our NetworkThreads read, write and accept with
+    enum class NetworkBackend
+    {
+        Reactor,                    ///< asio readiness, epoll / kqueue / IOCP
+        IoUring                     ///< io_uring, Linux 6.0 or newer; TLS connections stay on the reactor
+    };
+
+    /// Settings shared by a Listener, its NetworkThreads and their sockets
+    struct NetworkSettings
+    {
+        FlushPolicy Flush;          ///< When buffered output is flushed
+        OutboundLimits Outbound;    ///< How much unsent output a socket may hold
+        InboundLimits Inbound;      ///< How much a socket reads at once and may hold unhandled
+        uint32 TimerTick = 5;       ///< Resolution of the timing wheel of every NetworkThread, in milliseconds
+        bool ReusePort = false;     ///< Every NetworkThread accepts on its own SO_REUSEPORT acceptor
+        int32 CacheDomain = -1;     ///< Last level cache domain our threads and the game tick share, -1 picks one
+        BalancePolicy Balance;      ///< When connections move between NetworkThreads, disabled by default
+        AdmissionPolicy Admission;  ///< Which accepted connections are served, everyone by default
+        bool WebSocket = false;     ///< Clients may upgrade to WebSocket instead of speaking raw TCP
+        TlsSettings Tls;            ///< TLS connections are wrapped in, disabled by default
+        std::string HotRestartPath; ///< Unix socket to hand connections over on a restart, empty disables hot restart
+        NetworkBackend Backend = NetworkBackend::Reactor;   ///< Backend of every NetworkThread, one whose ring cannot be set up stays on the reactor
+        IoUringSettings IoUring;    ///< Ring of every NetworkThread, with the io_uring backend
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -19,53 +19,100 @@
 #pragma once
 #include <PCH/Precompiled.hpp>
 #include <boost/asio.hpp>
+#include <atomic>
+#include <future>
 
 #include "Core/Core.hpp"
 #include "Utility/UtiString.hpp"
-#include "Utility/UtiObjectGuard.hpp"
-#include "Utility/UtiLockable.hpp"
 #include "Logger/LogDefines.hpp"
 #include "Socket.hpp"
+#include "SocketRegistry.hpp"
+#include "NetworkSettings.hpp"
+#include "TimingWheel.hpp"
+#include "HotRestart.hpp"
+#include "AdmissionControl.hpp"
+
+#if defined(SO_REUSEPORT)
+    #define NETWORK_HAS_REUSEPORT
+#endif
+
+#if !defined(BOOST_ASIO_WINDOWS)
+    #include <pthread.h>
+    #include <time.h>
+    #include <unistd.h>
+
+    /// Each thread has a clock counting only the time it ran on a CPU
+    #if defined(_POSIX_THREAD_CPUTIME) && _POSIX_THREAD_CPUTIME >= 0
+        #define NETWORK_HAS_THREAD_CPU_TIME
+    #endif
+#endif
+
+#define HOT_RESTART_DETACH_TIMEOUT 5        ///< Seconds a hot restart waits for writes in flight before leaving their sockets behind
 
 namespace SteerStone { namespace Core { namespace Network {
 
-    template<typename T> class NetworkThread : private Utils::LockableReadWrite
+#ifdef NETWORK_HAS_REUSEPORT
+    /// Lets several acceptors bind the same port, the kernel spreads connections between them
+    using ReusePortOption = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+    template<typename T> class NetworkThread
     {
         DISALLOW_COPY_AND_ASSIGN(NetworkThread);
 
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
 
-        /// Allow access to lock / unlock methods
-        friend class Utils::ObjectGuard<NetworkThread>;
-        friend class Utils::ObjectReadGuard<NetworkThread>;
-        friend class Utils::ObjectWriteGuard<NetworkThread>;
-
         public:
             /// Constructor
             /// @p_WorkerThread : Worker thread number spawned
-            NetworkThread(uint8 const& p_WorkerThread) 
-                : m_Worker(new boost::asio::io_service::work(m_Service))
+            /// @p_Settings     : Settings applied to our sockets
+            /// @p_TlsContext   : TLS context shared by every NetworkThread of our Listener, null for plaintext
+            /// @p_Admission    : Admission control shared by every NetworkThread of our Listener, null for our own
+            NetworkThread(uint8 const& p_WorkerThread, NetworkSettings const& p_Settings, std::shared_ptr<TlsContext> const& p_TlsContext = nullptr,
+                std::shared_ptr<AdmissionControl> const& p_Admission = nullptr)
+                : m_Worker(new boost::asio::io_service::work(m_Service)), m_Settings(p_Settings),
+                m_BufferPool(std::make_shared<PacketBufferPool>()), m_TimingWheel(m_Service, p_Settings.TimerTick), m_InboundQueue(p_Settings.Inbound.MaxQueueDepth), m_TlsContext(p_TlsContext),
+                m_Admission(p_Admission ? p_Admission : std::make_shared<AdmissionControl>(p_Settings.Admission)), m_IoUring(m_Service)
             {
+                m_RingAccept.SetCallback([this](int32 p_Result, uint32 p_Flags) { this->OnRingAccept(p_Result, p_Flags); });
+
+                /// Our plaintext sockets run on our ring, the reactor serves them if the kernel cannot set it up
+                if (p_Settings.Backend == NetworkBackend::IoUring && !m_IoUring.Open(p_Settings.IoUring, &m_Counters))
+                    LOG_WARNING("NetworkThread", "io_uring could not be set up, NetworkThread %0 runs on the reactor", p_WorkerThread);
+
                 std::function<bool()> l_Service = [this]() -> bool {
+                #ifdef NETWORK_HAS_THREAD_CPU_TIME
+                    /// Lets our Listener see how busy we are from its own thread
+                    if (!this->m_HasCPUClock.load(std::memory_order_acquire) && !pthread_getcpuclockid(pthread_self(), &this->m_CPUClock))
+                        this->m_HasCPUClock.store(true, std::memory_order_release);
+                #endif
+
                     this->m_Service.run();
                     return true;
                 };
 
-                 l_Task = sThreadManager->PushTask(Utils::StringBuilder("NETWORK_SERVER_WORKER_THREAD_%0", p_WorkerThread), Threading::TaskType::Moderate, -1, l_Service);
+                 l_Task = sThreadManager->PushTask(Utils::StringBuilder("NETWORK_SERVER_WORKER_THREAD_%0", p_WorkerThread), Threading::TaskType::Moderate, -1, l_Service, p_Settings.CacheDomain);
             }
             /// Deconstructor
             ~NetworkThread()
             {
+                /// Stop accepting before the service goes away
+                if (m_Acceptor)
+                {
+                    boost::system::error_code l_ErrorCode;
+                    m_Acceptor->close(l_ErrorCode);
+                }
+
                 /// Allow IO Service to exit
                 m_Worker.reset();
                 m_Service.stop();
 
-                /// Close all active sockets
-                for (auto l_Itr = m_Sockets.begin(); l_Itr != m_Sockets.end(); l_Itr++)
+                /// Close all active sockets, closing removes them from the registry so work on a copy
+                for (auto const& l_Socket : m_Sockets.GetAll())
                 {
-                    if (!(*l_Itr)->IsClosed())
-                        (*l_Itr)->CloseSocket();
+                    if (!l_Socket->IsClosed())
+                        l_Socket->CloseSocket();
                 }
 
                 sThreadManager->PopTask(l_Task);
@@ -74,35 +121,441 @@ namespace SteerStone { namespace Core { namespace Network {
             //////////////////////////////////////////////////////////////////////////
             //////////////////////////////////////////////////////////////////////////
 
-            /// Get size of Socket storage
+            /// Get size of Socket storage, never locks
             std::size_t GetSize() const
             {
-                return m_Sockets.size();
+                return m_Sockets.GetSize();
+            }
+            /// Get socket by handle, null if it has been removed
+            /// @p_Handle : Handle of the socket
+            std::shared_ptr<T> GetSocket(SocketHandle const p_Handle)
+            {
+                return m_Sockets.Get(p_Handle);
+            }
+            /// Get our service, connections accepted for us are created on it
+            boost::asio::io_service& GetService()
+            {
+                return m_Service;
+            }
+            /// Get the timing wheel our sockets arm their timers on, only use it from our thread
+            TimingWheel& GetTimingWheel()
+            {
+                return m_TimingWheel;
+            }
+            /// Get outbound overflow counters of our sockets
+            OutboundCounters const& GetOutboundCounters() const
+            {
+                return m_OutboundCounters;
+            }
+            /// Get a snapshot of our counters, never locks
+            NetworkCountersSnapshot GetCounters() const
+            {
+                NetworkCountersSnapshot l_Snapshot = m_Counters.GetSnapshot();
+                l_Snapshot.CPUTime = GetCPUTime();
+
+                return l_Snapshot;
+            }
+            /// Get the microseconds our thread ran on a CPU, 0 where threads have no CPU clock
+            uint64 GetCPUTime() const
+            {
+            #ifdef NETWORK_HAS_THREAD_CPU_TIME
+                timespec l_Time;
+                if (m_HasCPUClock.load(std::memory_order_acquire) && !clock_gettime(m_CPUClock, &l_Time))
+                    return static_cast<uint64>(l_Time.tv_sec) * 1000000 + l_Time.tv_nsec / 1000;
+            #endif
+
+                return 0;
+            }
+            /// Get a snapshot of the counters of each of our sockets
+            std::vector<SocketCountersSnapshot> GetSocketCounters()
+            {
+                std::vector<SocketCountersSnapshot> l_Counters;
+
+                for (auto const& l_Socket : m_Sockets.GetAll())
+                    l_Counters.push_back(l_Socket->GetCounters());
+
+                return l_Counters;
+            }
+            /// Get the queue our sockets hand their frames to the game tick through
+            InboundQueue& GetInboundQueue()
+            {
+                return m_InboundQueue;
+            }
+            /// Get buffer pool statistics of our sockets
+            std::array<PacketBufferPoolStats, PACKET_BUFFER_POOL_CLASSES + 1> GetBufferPoolStats()
+            {
+                return m_BufferPool->GetStats();
             }
 
             /// Create socket
-            std::shared_ptr<T> NetworkThread<T>::CreateSocket()
+            std::shared_ptr<T> CreateSocket()
+            {
+                std::shared_ptr<T> l_Socket = std::make_shared<T>(m_Service, [this](Socket* p_Socket) { this->RemoveSocket(p_Socket); });
+                l_Socket->SetFlushPolicy(&m_Settings.Flush);
+                l_Socket->SetOutboundLimits(&m_Settings.Outbound, &m_OutboundCounters);
+                l_Socket->SetInboundLimits(&m_Settings.Inbound);
+                l_Socket->SetBufferPool(m_BufferPool);
+                l_Socket->SetNetworkCounters(&m_Counters);
+                l_Socket->SetTimingWheel(&m_TimingWheel);
+                l_Socket->SetInboundQueue(&m_InboundQueue);
+                l_Socket->SetIoUring(m_IoUring.IsOpen() ? &m_IoUring : nullptr);
+                l_Socket->SetWebSocket(m_Settings.WebSocket);
+                l_Socket->SetTlsContext(m_TlsContext.get());
+
+                m_Sockets.Add(l_Socket);
+                m_Admission->Add();
+
+                return l_Socket;
+            }
+            /// Serve a connection accepted for us, or turn it away before any socket state is allocated for it
+            /// @p_Peer : Accepted connection, on our service
+            void Admit(boost::asio::ip::tcp::socket&& p_Peer)
+            {
+                /// Our ring is only driven from our thread, the Listener accepts for us on its own
+                if (m_IoUring.IsOpen() && !m_Service.get_executor().running_in_this_thread())
+                {
+                    boost::asio::post(m_Service, [this, l_Peer = std::move(p_Peer)]() mutable { this->Admit(std::move(l_Peer)); });
+                    return;
+                }
+
+                boost::system::error_code l_ErrorCode;
+                const boost::asio::ip::tcp::endpoint l_EndPoint = p_Peer.remote_endpoint(l_ErrorCode);
+
+                if (l_ErrorCode || m_Admission->Admit(l_EndPoint.address()) != AdmissionResult::Admitted)
+                {
+                    /// Reset rather than close gracefully, a flood leaves no TIME_WAIT behind on our side
+                    p_Peer.set_option(boost::asio::socket_base::linger(true, 0), l_ErrorCode);
+                    p_Peer.close(l_ErrorCode);
+
+                    m_Counters.Rejects.Add(1);
+                    return;
+                }
+
+                std::shared_ptr<T> l_Socket = CreateSocket();
+                l_Socket->GetAsioSocket() = std::move(p_Peer);
+
+                if (!l_Socket->Open())
+                    RemoveSocket(l_Socket.get());
+            }
+            /// Accept connections on our own SO_REUSEPORT acceptor instead of being handed them by the Listener
+            /// Returns false if it cannot listen, e.g. another acceptor holds the end point without SO_REUSEPORT
+            /// @p_EndPoint : End point shared by every NetworkThread
+            bool StartAccept(boost::asio::ip::tcp::endpoint const& p_EndPoint)
             {
-                Utils::ObjectGuard l_Guard(this);
+            #ifdef NETWORK_HAS_REUSEPORT
+                boost::system::error_code l_ErrorCode;
 
-                m_Sockets.emplace(std::make_shared<T>(m_Service, [this](Socket* p_Socket) { this->RemoveSocket(p_Socket); }));
-                
-                return *m_Sockets.begin();
+                m_Acceptor.reset(new boost::asio::ip::tcp::acceptor(m_Service));
+                m_Acceptor->open(p_EndPoint.protocol(), l_ErrorCode);
+
+                if (!l_ErrorCode)
+                    m_Acceptor->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true), l_ErrorCode);
+
+                if (!l_ErrorCode)
+                    m_Acceptor->set_option(ReusePortOption(true), l_ErrorCode);
+
+                if (!l_ErrorCode)
+                    m_Acceptor->bind(p_EndPoint, l_ErrorCode);
+
+                if (!l_ErrorCode)
+                    m_Acceptor->listen(boost::asio::socket_base::max_listen_connections, l_ErrorCode);
+
+                if (l_ErrorCode)
+                {
+                    LOG_ERROR("NetworkThread", "Failed to accept on %0: %1", p_EndPoint, l_ErrorCode.message());
+                    m_Acceptor.reset();
+                    return false;
+                }
+
+                BeginAccept();
+                return true;
+            #else
+                UNUSED(p_EndPoint);
+                LOG_ASSERT(false, "NetworkThread", "SO_REUSEPORT is not supported on this platform");
+                return false;
+            #endif
             }
             /// Remove socket from storage
             /// @p_Socket : Socket being removed
             void RemoveSocket(Socket* p_Socket)
             {
-                Utils::ObjectGuard l_Guard(this);
+                if (m_Sockets.Remove(p_Socket->GetHandle()))
+                    m_Admission->Release();
+            }
+            /// Move one of our sockets to another NetworkThread of our Listener, from any thread
+            /// Nothing happens if it closed meanwhile or has a write in flight, the balancer tries again later
+            /// @p_Handle : Handle of the socket in our registry
+            /// @p_Target : NetworkThread taking it
+            void MigrateSocket(SocketHandle const p_Handle, NetworkThread<T>* p_Target)
+            {
+            #ifdef NETWORK_HAS_MIGRATION
+                boost::asio::post(m_Service, [this, p_Handle, p_Target]()
+                {
+                    std::shared_ptr<T> l_Socket = this->m_Sockets.Get(p_Handle);
+                    if (!l_Socket)
+                        return;
+
+                    l_Socket->Migrate(p_Target->m_Service, [this, p_Target](Socket* p_Socket)
+                    {
+                        this->m_Sockets.Remove(p_Socket->GetHandle());
+                        p_Target->AttachSocket(p_Socket->Shared<T>());
+                    });
+                });
+            #else
+                UNUSED(p_Handle);
+                UNUSED(p_Target);
+            #endif
+            }
+            /// Stop running our sockets, before any NetworkThread of our Listener goes away
+            /// A socket which moved here still hands its frames to the inbound queue of the thread it came from
+            void Stop()
+            {
+                m_Worker.reset();
+                m_Service.stop();
+            }
+
+            /// Accept on a listening descriptor handed over by the process we replace (ReusePort mode only)
+            /// @p_EndPoint : End point the descriptor is bound to
+            /// @p_Fd       : Listening descriptor, ours from now on
+            bool AdoptAcceptor(boost::asio::ip::tcp::endpoint const& p_EndPoint, int const p_Fd)
+            {
+                bool l_Adopted = false;
+
+                RunAndWait([this, &p_EndPoint, p_Fd, &l_Adopted]()
+                {
+                    if (!this->m_Acceptor)
+                        this->m_Acceptor.reset(new boost::asio::ip::tcp::acceptor(this->m_Service));
+
+                    boost::system::error_code l_ErrorCode;
+                    this->m_Acceptor->assign(p_EndPoint.protocol(), p_Fd, l_ErrorCode);
+
+                    if (l_ErrorCode)
+                    {
+                        LOG_ERROR("NetworkThread", "Failed to adopt acceptor: %0", l_ErrorCode.message());
+
+                        /// Not assigned, nobody owns the descriptor
+                        ::close(p_Fd);
+                        return;
+                    }
+
+                    this->BeginAccept();
+                    l_Adopted = true;
+                });
+
+                return l_Adopted;
+            }
+            /// Stop accepting and give up our listening descriptor, -1 if we have none
+            /// Connections waiting in its backlog stay there for whoever accepts on it next
+            int ReleaseAcceptor()
+            {
+                int l_Fd = -1;
+
+                RunAndWait([this, &l_Fd]()
+                {
+                    if (!this->m_Acceptor || !this->m_Acceptor->is_open())
+                        return;
+
+                    /// The kernel would keep accepting on the descriptor for our ring once it changed hands
+                    this->m_IoUring.CancelAndWait(this->m_RingAccept);
+
+                    /// The pending accept completes with operation_aborted and finds the acceptor closed
+                    boost::system::error_code l_ErrorCode;
+                    l_Fd = this->m_Acceptor->release(l_ErrorCode);
+
+                    if (l_ErrorCode)
+                        l_Fd = -1;
+                });
+
+                return l_Fd;
+            }
+            /// Let go of every socket so another process can resume them
+            /// Sockets with a write in flight are retried until HOT_RESTART_DETACH_TIMEOUT, then left behind
+            /// @p_Handoffs : Detached connections are appended to it
+            /// @p_Retained : Open sockets which cannot be handed over are appended to it, close them once the hand off succeeded
+            void DetachSockets(std::vector<SocketHandoff>& p_Handoffs, std::vector<std::shared_ptr<T>>& p_Retained)
+            {
+                const std::chrono::steady_clock::time_point l_Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(HOT_RESTART_DETACH_TIMEOUT);
+
+                std::vector<std::shared_ptr<T>> l_Sockets = m_Sockets.GetAll();
+
+                for (;;)
+                {
+                    std::vector<std::shared_ptr<T>> l_Pending;
+
+                    RunAndWait([this, &p_Handoffs, &p_Retained, &l_Sockets, &l_Pending]()
+                    {
+                        for (auto const& l_Socket : l_Sockets)
+                        {
+                            SocketHandoff l_Handoff;
+                            if (!l_Socket->Detach(l_Handoff))
+                            {
+                                l_Pending.push_back(l_Socket);
+                                continue;
+                            }
+
+                            /// Still registered, it keeps being served if the hand off fails
+                            if (l_Handoff.Fd == -1 && !l_Socket->IsClosed())
+                            {
+                                p_Retained.push_back(l_Socket);
+                                continue;
+                            }
+
+                            if (this->m_Sockets.Remove(l_Socket->GetHandle()))
+                                this->m_Admission->Release();
+
+                            if (l_Handoff.Fd != -1)
+                                p_Handoffs.push_back(std::move(l_Handoff));
+                        }
+                    });
+
+                    if (l_Pending.empty())
+                        return;
+
+                    if (std::chrono::steady_clock::now() >= l_Deadline)
+                    {
+                        LOG_WARNING("NetworkThread", "%0 sockets are still sending, they are not handed over", l_Pending.size());
+
+                        /// Detach stopped the reads of those on our ring
+                        RunAndWait([&l_Pending]()
+                        {
+                            for (auto const& l_Socket : l_Pending)
+                                l_Socket->CancelDetach();
+                        });
+
+                        return;
+                    }
+
+                    /// Only sockets which were sending are tried again
+                    l_Sockets.swap(l_Pending);
+
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            /// Resume a connection handed over by the process we replace
+            /// @p_Handoff : Connection, we own its descriptor
+            void AdoptSocket(SocketHandoff&& p_Handoff)
+            {
+                std::shared_ptr<T> l_Socket = CreateSocket();
+
+                boost::asio::post(m_Service, [this, l_Socket, l_Handoff = std::move(p_Handoff)]()
+                {
+                    if (!l_Socket->Adopt(l_Handoff))
+                        this->RemoveSocket(l_Socket.get());
+                });
+            }
+
+        private:
+            /// Run a function on our thread and wait for it, never call it from our thread
+            /// @p_Function : Function
+            template <typename Function> void RunAndWait(Function&& p_Function)
+            {
+                std::promise<void> l_Done;
+                std::future<void> l_Future = l_Done.get_future();
+
+                boost::asio::post(m_Service, [&p_Function, &l_Done]()
+                {
+                    p_Function();
+                    l_Done.set_value();
+                });
+
+                l_Future.wait();
+            }
+            /// Take a socket moving in from another NetworkThread, called from its old thread under its lock
+            /// Its frames keep going through the inbound queue they went through so far, so the game tick sees them in order;
+            /// storage it still borrows goes back to the pool it came from, which it keeps alive
+            /// @p_Socket : Socket
+            void AttachSocket(std::shared_ptr<T> const& p_Socket)
+            {
+                p_Socket->SetCloseHandler([this](Socket* p_Closed) { this->RemoveSocket(p_Closed); });
+                p_Socket->SetFlushPolicy(&m_Settings.Flush);
+                p_Socket->SetOutboundLimits(&m_Settings.Outbound, &m_OutboundCounters);
+                p_Socket->SetInboundLimits(&m_Settings.Inbound);
+                p_Socket->SetNetworkCounters(&m_Counters);
+                p_Socket->SetTimingWheel(&m_TimingWheel);
+                p_Socket->SetIoUring(m_IoUring.IsOpen() ? &m_IoUring : nullptr);
+
+                if (!p_Socket->HasBufferStorage())
+                    p_Socket->SetBufferPool(m_BufferPool);
+
+                m_Sockets.Add(p_Socket);
+                m_Counters.Migrations.Add(1);
+            }
+            /// Accept the next connection on our acceptor
+            void BeginAccept()
+            {
+                /// One multishot accept takes every connection until it is cancelled, submitted from our thread only
+                if (m_IoUring.IsOpen())
+                {
+                    if (!m_Service.get_executor().running_in_this_thread())
+                    {
+                        boost::asio::post(m_Service, [this]() { this->BeginAccept(); });
+                        return;
+                    }
+
+                    if (m_Acceptor && m_Acceptor->is_open() && !m_RingAccept.IsPending() && !m_IoUring.AcceptMultishot(m_RingAccept, m_Acceptor->native_handle(), nullptr))
+                        LOG_ERROR("NetworkThread", "io_uring submission queue is full, not accepting");
+
+                    return;
+                }
+
+                m_Acceptor->async_accept(m_Service,
+                    [this](const boost::system::error_code& p_ErrorCode, boost::asio::ip::tcp::socket p_Peer)
+                    {
+                        if (!p_ErrorCode)
+                            this->Admit(std::move(p_Peer));
+
+                        /// Acceptor closed, we are shutting down
+                        if (p_ErrorCode == boost::asio::error::operation_aborted || !this->m_Acceptor->is_open())
+                            return;
+
+                        this->BeginAccept();
+                    });
+            }
+
+            /// Completion of our multishot accept
+            /// @p_Result : Descriptor of the connection, or -errno
+            /// @p_Flags  : Flags of the completion
+            void OnRingAccept(int32 const p_Result, uint32 const p_Flags)
+            {
+                if (p_Result >= 0)
+                {
+                    boost::system::error_code l_ErrorCode;
+                    boost::asio::ip::tcp::socket l_Peer(m_Service);
+                    l_Peer.assign(m_Acceptor->local_endpoint(l_ErrorCode).protocol(), p_Result, l_ErrorCode);
+
+                    if (l_ErrorCode)
+                        ::close(p_Result);
+                    else
+                        Admit(std::move(l_Peer));
+                }
+
+                /// Cancelled, our acceptor is being handed over
+                if (IoUring::IsArmed(p_Flags) || p_Result == -ECANCELED || !m_Acceptor->is_open())
+                    return;
 
-                m_Sockets.erase(p_Socket->Shared<T>());
+                BeginAccept();
             }
 
         private:
             boost::asio::io_service m_Service;                          ///< IO Service
             std::unique_ptr<boost::asio::io_service::work> m_Worker;    ///< Worker of IO Service
-            std::unordered_set<std::shared_ptr<T>> m_Sockets;           ///< Storage of socket classes
+            SocketRegistry<T> m_Sockets;                                ///< Storage of socket classes
+            NetworkSettings const m_Settings;                           ///< Settings applied to our sockets
+            OutboundCounters m_OutboundCounters;                        ///< Overflow counters of our sockets
+            NetworkCounters m_Counters;                                 ///< Traffic counters of our sockets
+            std::shared_ptr<PacketBufferPool> m_BufferPool;             ///< Buffer storage lent to our sockets, shared so it outlives them
+            TimingWheel m_TimingWheel;                                  ///< Timers of our sockets
+            InboundQueue m_InboundQueue;                                ///< Frames of our sockets, drained by the game tick
+            std::shared_ptr<TlsContext> m_TlsContext;                   ///< TLS context of our Listener, null for plaintext
+            std::shared_ptr<AdmissionControl> m_Admission;              ///< Admission control of our Listener
+            UringOperation m_RingAccept;                                ///< Multishot accept on our acceptor, with the io_uring backend
+            IoUring m_IoUring;                                          ///< Ring our plaintext sockets run on, not open on the reactor
+            std::unique_ptr<boost::asio::ip::tcp::acceptor> m_Acceptor; ///< Own acceptor (ReusePort mode only)
             Threading::Task::Ptr l_Task;                                ///< Worker task
+        #ifdef NETWORK_HAS_THREAD_CPU_TIME
+            clockid_t m_CPUClock;                                       ///< CPU clock of our thread
+            std::atomic<bool> m_HasCPUClock{ false };                   ///< Set once our thread found its CPU clock
+        #endif
     };
 
 }   ///< namespace Network
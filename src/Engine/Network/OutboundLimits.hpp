@@ -0,0 +1,68 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Write Flags
+    enum WriteFlags
+    {
+        WriteFlags_None             = 0,
+        WriteFlags_Critical         = 1 << 0,       ///< Never dropped or coalesced
+        WriteFlags_Status           = 1 << 1,       ///< Only the latest message of its status key matters
+    };
+
+    /// Overflow Modes
+    enum class OverflowMode
+    {
+        Drop,                       ///< Drop non critical messages while over the limits
+        Coalesce,                   ///< Like Drop, but keep the latest status message of each key and send it once drained
+        Disconnect                  ///< Disconnect the client as soon as it goes over the limits
+    };
+
+    /// What a socket does with a write
+    enum class WriteAdmission
+    {
+        Queue,                      ///< Queue it
+        Hold,                       ///< Hold it aside as the latest status of its key
+        Discard                     ///< Drop it
+    };
+
+    /// Bounds how much unsent data a socket may hold
+    struct OutboundLimits
+    {
+        OverflowMode Mode       = OverflowMode::Coalesce;   ///< What to do with writes over the limits
+        uint32 MaxBytes         = 1024 * 1024;              ///< Most unsent bytes, critical messages may go up to twice this
+        uint32 MaxMessages      = 8192;                     ///< Most unsent messages
+    };
+
+    /// Overflow counters, shared by the sockets of one NetworkThread
+    struct OutboundCounters
+    {
+        std::atomic<uint64> Dropped     { 0 };              ///< Messages dropped
+        std::atomic<uint64> Coalesced   { 0 };              ///< Status messages replaced by a newer one
+        std::atomic<uint64> Disconnected{ 0 };              ///< Clients disconnected for not reading
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,283 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cassert>
+#include <cstring>
+
+#include "OutboundQueue.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Constructor
+    OutboundQueue::OutboundQueue()
+        : m_Ring(STORAGE_CHUNK_SIZE, PacketBufferMode::Chunked), m_RingConsumed(0), m_PayloadConsumed(0), m_PayloadBytes(0),
+        m_Queued(0), m_Sent(0), m_Pending(0), m_QueuedSize(0)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Copy data to the back of the queue
+    /// @p_Buffer : Buffer which holds the data
+    /// @p_Length : The length of the data
+    void OutboundQueue::Write(char const* p_Buffer, std::size_t const p_Length)
+    {
+        assert(!m_Pending);
+
+        if (!p_Length)
+            return;
+
+        m_Ring.Write(p_Buffer, p_Length);
+
+        m_Queued += p_Length;
+        m_MessageEnds.push_back(m_Queued);
+        m_QueuedSize.store(GetSize(), std::memory_order_relaxed);
+    }
+    /// Queue a reference to a shared payload
+    /// @p_Payload : Payload
+    void OutboundQueue::Write(SharedPayload::Ptr const& p_Payload)
+    {
+        assert(!m_Pending);
+
+        if (!p_Payload || !p_Payload->GetSize())
+            return;
+
+        m_Payloads.push_back(QueuedPayload{ p_Payload, m_RingConsumed + m_Ring.ReadLengthRemaining() });
+        m_PayloadBytes += p_Payload->GetSize();
+
+        m_Queued += p_Payload->GetSize();
+        m_MessageEnds.push_back(m_Queued);
+        m_QueuedSize.store(GetSize(), std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get room at the back of the ring to serialize a message in place, never empty
+    /// Bytes written there are pending until EndPending, DropPending or DetachPending
+    boost::asio::mutable_buffer OutboundQueue::GetWriteSpan()
+    {
+        return m_Ring.GetWriteSpan();
+    }
+    /// Mark bytes written into the write span as pending
+    /// @p_Length : The length of the data
+    void OutboundQueue::Advance(std::size_t const p_Length)
+    {
+        m_Ring.Advance(p_Length);
+        m_Pending += p_Length;
+    }
+    /// Get amount of pending bytes
+    std::size_t OutboundQueue::GetPendingSize() const
+    {
+        return m_Pending;
+    }
+    /// Queue the pending bytes as one message
+    void OutboundQueue::EndPending()
+    {
+        if (!m_Pending)
+            return;
+
+        m_Queued += m_Pending;
+        m_MessageEnds.push_back(m_Queued);
+
+        m_Pending = 0;
+        m_QueuedSize.store(GetSize(), std::memory_order_relaxed);
+    }
+    /// Drop the pending bytes
+    void OutboundQueue::DropPending()
+    {
+        m_Ring.Truncate(m_Pending);
+        m_Pending = 0;
+    }
+    /// Move the pending bytes into a new shared payload
+    SharedPayload::Ptr OutboundQueue::DetachPending()
+    {
+        std::vector<char> l_Buffer(m_Pending);
+
+        m_RingSpans.clear();
+        m_Ring.GetReadSpans(m_RingSpans);
+
+        /// Pending bytes are the tail of the ring, walk the spans back to front
+        std::size_t l_Remaining = m_Pending;
+        for (auto l_Itr = m_RingSpans.rbegin(); l_Remaining && l_Itr != m_RingSpans.rend(); ++l_Itr)
+        {
+            const std::size_t l_Length = std::min(l_Remaining, l_Itr->size());
+            l_Remaining -= l_Length;
+
+            memcpy(l_Buffer.data() + l_Remaining, static_cast<char const*>(l_Itr->data()) + l_Itr->size() - l_Length, l_Length);
+        }
+
+        DropPending();
+
+        return SharedPayload::Create(l_Buffer.data(), l_Buffer.size());
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Append every contiguous block of queued data, in order
+    /// @p_Spans : Spans are pushed to the back of this
+    void OutboundQueue::GetSpans(std::vector<boost::asio::const_buffer>& p_Spans)
+    {
+        assert(!m_Pending);
+
+        if (m_Payloads.empty())
+        {
+            m_Ring.GetReadSpans(p_Spans);
+            return;
+        }
+
+        m_RingSpans.clear();
+        m_Ring.GetReadSpans(m_RingSpans);
+
+        std::size_t l_Span      = 0;        ///< Current ring span
+        std::size_t l_Offset    = 0;        ///< Offset inside the current ring span
+        uint64 l_RingPosition   = m_RingConsumed;
+
+        /// Cut the ring spans where each payload was queued
+        auto l_AppendRing = [&](uint64 p_Length)
+        {
+            while (p_Length)
+            {
+                boost::asio::const_buffer l_RingSpan = m_RingSpans[l_Span] + l_Offset;
+                const std::size_t l_Length = static_cast<std::size_t>(std::min<uint64>(p_Length, l_RingSpan.size()));
+
+                p_Spans.push_back(boost::asio::const_buffer(l_RingSpan.data(), l_Length));
+
+                l_Offset += l_Length;
+                p_Length -= l_Length;
+
+                if (l_Offset == m_RingSpans[l_Span].size())
+                {
+                    l_Span++;
+                    l_Offset = 0;
+                }
+            }
+        };
+
+        for (std::size_t l_I = 0; l_I < m_Payloads.size(); l_I++)
+        {
+            QueuedPayload const& l_Queued = m_Payloads[l_I];
+
+            l_AppendRing(l_Queued.RingOffset - l_RingPosition);
+            l_RingPosition = l_Queued.RingOffset;
+
+            p_Spans.push_back(l_Queued.Payload->GetSpan(l_I == 0 ? m_PayloadConsumed : 0));
+        }
+
+        l_AppendRing(m_RingConsumed + m_Ring.ReadLengthRemaining() - l_RingPosition);
+    }
+    /// Drop data which has been sent
+    /// @p_Length : The length of the data
+    void OutboundQueue::Consume(std::size_t p_Length)
+    {
+        assert(GetSize() >= p_Length);
+
+        m_Sent += p_Length;
+        while (!m_MessageEnds.empty() && m_MessageEnds.front() <= m_Sent)
+            m_MessageEnds.pop_front();
+
+        while (p_Length)
+        {
+            const std::size_t l_RingAhead = GetRingBytesAhead();
+
+            if (l_RingAhead)
+            {
+                const std::size_t l_Length = std::min(p_Length, l_RingAhead);
+
+                m_Ring.Consume(l_Length);
+                m_RingConsumed  += l_Length;
+                p_Length        -= l_Length;
+                continue;
+            }
+
+            QueuedPayload const& l_Front = m_Payloads.front();
+            const std::size_t l_Length = std::min(p_Length, l_Front.Payload->GetSize() - m_PayloadConsumed);
+
+            m_PayloadConsumed   += l_Length;
+            m_PayloadBytes      -= l_Length;
+            p_Length            -= l_Length;
+
+            /// Payload fully sent, drop our reference
+            if (m_PayloadConsumed == l_Front.Payload->GetSize())
+            {
+                m_Payloads.pop_front();
+                m_PayloadConsumed = 0;
+            }
+        }
+
+        m_QueuedSize.store(GetSize(), std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get amount of queued bytes, pending bytes excluded
+    std::size_t OutboundQueue::GetSize() const
+    {
+        return m_Ring.ReadLengthRemaining() - m_Pending + m_PayloadBytes;
+    }
+    /// Get amount of queued bytes from any thread, as of the last write or consume
+    std::size_t OutboundQueue::GetQueuedSize() const
+    {
+        return m_QueuedSize.load(std::memory_order_relaxed);
+    }
+    /// Get amount of queued shared payloads
+    std::size_t OutboundQueue::GetPayloadCount() const
+    {
+        return m_Payloads.size();
+    }
+    /// Get amount of queued messages, a message is one Write call
+    std::size_t OutboundQueue::GetMessageCount() const
+    {
+        return m_MessageEnds.size();
+    }
+
+    /// Set the pool our ring is borrowed from
+    /// @p_Pool : Pool, must outlive the storage it lends
+    void OutboundQueue::SetPool(PacketBufferPool* p_Pool)
+    {
+        m_Ring.SetPool(p_Pool);
+    }
+    /// Check if our ring currently holds storage
+    bool OutboundQueue::HasStorage() const
+    {
+        return m_Ring.HasStorage();
+    }
+    /// Hand our ring storage back, only if nothing is queued
+    void OutboundQueue::Release()
+    {
+        m_Ring.Release();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get ring bytes queued ahead of the first payload
+    std::size_t OutboundQueue::GetRingBytesAhead() const
+    {
+        if (m_Payloads.empty())
+            return m_Ring.ReadLengthRemaining();
+
+        return static_cast<std::size_t>(m_Payloads.front().RingOffset - m_RingConsumed);
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
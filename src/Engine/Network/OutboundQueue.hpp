@@ -0,0 +1,152 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+#include <atomic>
+#include <deque>
+
+#include "Core/Core.hpp"
+#include "PacketBuffer.hpp"
+#include "SharedPayload.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Non-owning buffer sequence over a vector of spans
+    /// Asio keeps a copy of the sequence in the write operation, copying the vector itself would allocate
+    class SpanSequence
+    {
+        public:
+            using value_type        = boost::asio::const_buffer;
+            using const_iterator    = std::vector<boost::asio::const_buffer>::const_iterator;
+
+            /// Constructor
+            /// @p_Spans : Spans, must outlive the operation
+            explicit SpanSequence(std::vector<boost::asio::const_buffer> const& p_Spans)
+                : m_Spans(&p_Spans)
+            {
+            }
+
+            /// Get the first span
+            const_iterator begin() const
+            {
+                return m_Spans->begin();
+            }
+            /// Get the end of the spans
+            const_iterator end() const
+            {
+                return m_Spans->end();
+            }
+
+        private:
+            std::vector<boost::asio::const_buffer> const* m_Spans;      ///< Spans
+    };
+
+    /// Outgoing data of one socket, in the order it was queued
+    /// Messages written by one socket only are copied into a chunk ring, shared payloads are
+    /// queued by reference; both are sent together in one gather write
+    class OutboundQueue
+    {
+        DISALLOW_COPY_AND_ASSIGN(OutboundQueue);
+
+        /// Shared payload waiting to be sent
+        struct QueuedPayload
+        {
+            SharedPayload::Ptr Payload;     ///< Payload
+            uint64 RingOffset;              ///< Ring bytes queued before the payload, counted since the socket opened
+        };
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            OutboundQueue();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Copy data to the back of the queue
+            /// @p_Buffer : Buffer which holds the data
+            /// @p_Length : The length of the data
+            void Write(char const* p_Buffer, std::size_t const p_Length);
+            /// Queue a reference to a shared payload
+            /// @p_Payload : Payload
+            void Write(SharedPayload::Ptr const& p_Payload);
+
+            /// Get room at the back of the ring to serialize a message in place, never empty
+            /// Bytes written there are pending until EndPending, DropPending or DetachPending
+            boost::asio::mutable_buffer GetWriteSpan();
+            /// Mark bytes written into the write span as pending
+            /// @p_Length : The length of the data
+            void Advance(std::size_t const p_Length);
+            /// Get amount of pending bytes
+            std::size_t GetPendingSize() const;
+            /// Queue the pending bytes as one message
+            void EndPending();
+            /// Drop the pending bytes
+            void DropPending();
+            /// Move the pending bytes into a new shared payload
+            SharedPayload::Ptr DetachPending();
+
+            /// Append every contiguous block of queued data, in order
+            /// @p_Spans : Spans are pushed to the back of this
+            void GetSpans(std::vector<boost::asio::const_buffer>& p_Spans);
+            /// Drop data which has been sent
+            /// @p_Length : The length of the data
+            void Consume(std::size_t p_Length);
+
+            /// Get amount of queued bytes, pending bytes excluded
+            std::size_t GetSize() const;
+            /// Get amount of queued bytes from any thread, as of the last write or consume
+            std::size_t GetQueuedSize() const;
+            /// Get amount of queued shared payloads
+            std::size_t GetPayloadCount() const;
+            /// Get amount of queued messages, a message is one Write call
+            std::size_t GetMessageCount() const;
+
+            /// Set the pool our ring is borrowed from
+            /// @p_Pool : Pool, must outlive the storage it lends
+            void SetPool(PacketBufferPool* p_Pool);
+            /// Check if our ring currently holds storage
+            bool HasStorage() const;
+            /// Hand our ring storage back, only if nothing is queued
+            void Release();
+
+        private:
+            /// Get ring bytes queued ahead of the first payload
+            std::size_t GetRingBytesAhead() const;
+
+        private:
+            PacketBuffer m_Ring;                                ///< Copied data
+            std::deque<QueuedPayload> m_Payloads;               ///< Shared payloads, in order
+            std::vector<boost::asio::const_buffer> m_RingSpans; ///< Scratch spans of the ring
+            uint64 m_RingConsumed;                              ///< Ring bytes sent since the socket opened
+            std::size_t m_PayloadConsumed;                      ///< Bytes of the front payload already sent
+            std::size_t m_PayloadBytes;                         ///< Unsent bytes of every queued payload
+            std::deque<uint64> m_MessageEnds;                   ///< End of every unsent message, counted in bytes queued since the socket opened
+            uint64 m_Queued;                                    ///< Bytes queued since the socket opened
+            uint64 m_Sent;                                      ///< Bytes sent since the socket opened
+            std::size_t m_Pending;                              ///< Bytes of the message being serialized in place, at the back of the ring
+            std::atomic<std::size_t> m_QueuedSize;              ///< Copy of GetSize for other threads, stored after every write and consume
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -23,10 +23,19 @@
 namespace SteerStone { namespace Core { namespace Network {
 
     /// Constructor
-    /// @p_InitializeSize : Reserve size for our m_Storage
-    PacketBuffer::PacketBuffer(uint32 p_InitializeSize) 
-        : m_WritePosition(0), m_ReadPosition(0), m_Buffer(p_InitializeSize, 0)
+    /// @p_InitializeSize : Size of our m_Storage once it is first needed
+    /// @p_Mode           : Storage layout
+    PacketBuffer::PacketBuffer(uint32 p_InitializeSize, PacketBufferMode p_Mode) 
+        : m_Mode(p_Mode), m_Pool(nullptr), m_InitializeSize(p_InitializeSize), m_WritePosition(0), m_ReadPosition(0),
+        m_Storage(nullptr), m_Capacity(0), m_SpareChunk(nullptr), m_ChunkedSize(0)
     {
+        /// Storage is borrowed on the first write
+    }
+    /// Deconstructor
+    PacketBuffer::~PacketBuffer()
+    {
+        m_ReadPosition = m_WritePosition = m_ChunkedSize = 0;
+        Release();
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -39,25 +48,274 @@ namespace SteerStone { namespace Core { namespace Network {
     {
         assert(ReadLengthRemaining() >= p_Length);
 
-        if (p_Buffer)
-            memcpy(p_Buffer, &m_Buffer[m_ReadPosition], p_Length);
+        if (m_Mode == PacketBufferMode::Linear)
+        {
+            if (p_Buffer)
+                memcpy(p_Buffer, m_Storage + m_ReadPosition, p_Length);
+
+            m_ReadPosition += p_Length;
+            return;
+        }
+
+        std::size_t l_Copied = 0;
+        while (p_Buffer && l_Copied < p_Length)
+        {
+            boost::asio::const_buffer l_Span = GetReadSpan();
+            const std::size_t l_Length = std::min(l_Span.size(), p_Length - l_Copied);
+
+            memcpy(p_Buffer + l_Copied, l_Span.data(), l_Length);
+            Consume(l_Length);
+
+            l_Copied += l_Length;
+        }
 
-        m_ReadPosition += p_Length;
+        if (!p_Buffer)
+            Consume(p_Length);
     }
     /// Write the data to be sent
     /// @p_Buffer : Buffer which holds the data
     /// @p_Length : The length of the data
     void PacketBuffer::Write(char const* p_Buffer, std::size_t const& p_Length)
     {
-        const size_t l_NewLength = m_WritePosition + p_Length;
+        if (m_Mode == PacketBufferMode::Linear)
+        {
+            Reserve(m_WritePosition + p_Length);
+
+            memcpy(m_Storage + m_WritePosition, p_Buffer, p_Length);
+
+            m_WritePosition += p_Length;
+            return;
+        }
+
+        std::size_t l_Written = 0;
+        while (l_Written < p_Length)
+        {
+            boost::asio::mutable_buffer l_Span = GetWriteSpan();
+            const std::size_t l_Length = std::min(p_Length - l_Written, l_Span.size());
+
+            memcpy(l_Span.data(), p_Buffer + l_Written, l_Length);
+            Advance(l_Length);
+
+            l_Written += l_Length;
+        }
+    }
+    /// Move the unread bytes (a partial frame) to the front of the storage
+    /// so the next read can append the rest of the frame
+    void PacketBuffer::Compact()
+    {
+        /// Chunk storage never moves data
+        if (m_Mode == PacketBufferMode::Chunked)
+            return;
+
+        const std::size_t l_Remaining = ReadLengthRemaining();
+
+        if (l_Remaining && m_ReadPosition)
+            memmove(m_Storage, m_Storage + m_ReadPosition, l_Remaining);
+
+        m_ReadPosition  = 0;
+        m_WritePosition = l_Remaining;
+    }
+
+    /// Set the pool our storage is borrowed from, null uses the heap
+    /// @p_Pool : Pool, must outlive the storage it lends
+    void PacketBuffer::SetPool(PacketBufferPool* p_Pool)
+    {
+        assert(!HasStorage());
+
+        m_Pool = p_Pool;
+    }
+    /// Make sure the linear storage holds at least p_Size bytes
+    /// @p_Size : Wanted size
+    void PacketBuffer::Reserve(std::size_t const p_Size)
+    {
+        assert(m_Mode == PacketBufferMode::Linear);
+
+        if (m_Capacity >= p_Size)
+            return;
+
+        /// Double on growth so a large frame arriving in pieces does not copy once per piece
+        std::size_t l_Capacity = 0;
+        uint8* l_Storage = AllocateBlock(std::max(p_Size, m_Capacity ? m_Capacity * 2 : m_InitializeSize), l_Capacity);
+
+        if (m_Storage)
+        {
+            memcpy(l_Storage, m_Storage, m_WritePosition);
+            FreeBlock(m_Storage, m_Capacity);
+        }
+
+        m_Storage   = l_Storage;
+        m_Capacity  = l_Capacity;
+    }
+    /// Hand our storage back, only if nothing is left unread
+    void PacketBuffer::Release()
+    {
+        if (ReadLengthRemaining())
+            return;
+
+        m_ReadPosition = m_WritePosition = 0;
+
+        if (m_Storage)
+        {
+            FreeBlock(m_Storage, m_Capacity);
+            m_Storage   = nullptr;
+            m_Capacity  = 0;
+        }
+
+        for (uint8* l_Chunk : m_Chunks)
+            FreeBlock(l_Chunk, STORAGE_CHUNK_SIZE);
+
+        m_Chunks.clear();
+
+        if (m_SpareChunk)
+        {
+            FreeBlock(m_SpareChunk, STORAGE_CHUNK_SIZE);
+            m_SpareChunk = nullptr;
+        }
+    }
+    /// Check if we currently hold storage
+    bool PacketBuffer::HasStorage() const
+    {
+        return m_Storage || !m_Chunks.empty() || m_SpareChunk;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get the first contiguous block of unread data
+    boost::asio::const_buffer PacketBuffer::GetReadSpan() const
+    {
+        if (m_Mode == PacketBufferMode::Linear)
+            return boost::asio::const_buffer(m_Storage + m_ReadPosition, m_WritePosition - m_ReadPosition);
+
+        if (m_Chunks.empty())
+            return boost::asio::const_buffer();
+
+        const std::size_t l_End = m_Chunks.size() == 1 ? m_WritePosition : STORAGE_CHUNK_SIZE;
+
+        return boost::asio::const_buffer(m_Chunks.front() + m_ReadPosition, l_End - m_ReadPosition);
+    }
+    /// Append every contiguous block of unread data, in order
+    /// @p_Spans : Spans are pushed to the back of this
+    void PacketBuffer::GetReadSpans(std::vector<boost::asio::const_buffer>& p_Spans) const
+    {
+        if (m_Mode == PacketBufferMode::Linear || m_Chunks.size() <= 1)
+        {
+            boost::asio::const_buffer l_Span = GetReadSpan();
+
+            if (l_Span.size())
+                p_Spans.push_back(l_Span);
+
+            return;
+        }
+
+        p_Spans.push_back(GetReadSpan());
+
+        for (std::size_t l_I = 1; l_I < m_Chunks.size() - 1; l_I++)
+            p_Spans.push_back(boost::asio::const_buffer(m_Chunks[l_I], STORAGE_CHUNK_SIZE));
+
+        if (m_WritePosition)
+            p_Spans.push_back(boost::asio::const_buffer(m_Chunks.back(), m_WritePosition));
+    }
+    /// Mark data as read, without copying it anywhere
+    /// @p_Length : The length of the data
+    void PacketBuffer::Consume(std::size_t const p_Length)
+    {
+        assert(ReadLengthRemaining() >= p_Length);
+
+        if (m_Mode == PacketBufferMode::Linear)
+        {
+            m_ReadPosition += p_Length;
+
+            if (m_ReadPosition == m_WritePosition)
+                m_ReadPosition = m_WritePosition = 0;
+
+            return;
+        }
+
+        std::size_t l_Remaining = p_Length;
+        while (l_Remaining)
+        {
+            const std::size_t l_Length = std::min(l_Remaining, GetReadSpan().size());
+
+            m_ReadPosition  += l_Length;
+            m_ChunkedSize   -= l_Length;
+            l_Remaining     -= l_Length;
+
+            /// Front chunk fully read, hand it back to the pool or keep it as our spare
+            if (m_ReadPosition == STORAGE_CHUNK_SIZE && m_Chunks.size() > 1)
+            {
+                if (m_Pool || m_SpareChunk)
+                    FreeBlock(m_Chunks.front(), STORAGE_CHUNK_SIZE);
+                else
+                    m_SpareChunk = m_Chunks.front();
+
+                m_Chunks.pop_front();
+                m_ReadPosition = 0;
+            }
+        }
+
+        /// Everything read, rewind the cursors so we keep writing into the same chunk
+        if (m_ChunkedSize == 0)
+        {
+            while (m_Chunks.size() > 1)
+            {
+                FreeBlock(m_Chunks.back(), STORAGE_CHUNK_SIZE);
+                m_Chunks.pop_back();
+            }
+
+            m_ReadPosition = m_WritePosition = 0;
+        }
+    }
+
+    /// Get room at the back of the chunk ring to write into, never empty
+    boost::asio::mutable_buffer PacketBuffer::GetWriteSpan()
+    {
+        assert(m_Mode == PacketBufferMode::Chunked);
 
-        if (m_Buffer.size() < l_NewLength)
-            m_Buffer.resize(l_NewLength);
+        /// Back chunk is full (or there is none), append a new one
+        if (m_Chunks.empty() || m_WritePosition == STORAGE_CHUNK_SIZE)
+        {
+            m_Chunks.push_back(AllocateChunk());
+            m_WritePosition = 0;
+        }
 
-        memcpy(&m_Buffer[m_WritePosition], p_Buffer, p_Length);
+        return boost::asio::mutable_buffer(m_Chunks.back() + m_WritePosition, STORAGE_CHUNK_SIZE - m_WritePosition);
+    }
+    /// Mark bytes written into the write span as written
+    /// @p_Length : The length of the data
+    void PacketBuffer::Advance(std::size_t const p_Length)
+    {
+        assert(m_WritePosition + p_Length <= STORAGE_CHUNK_SIZE);
 
         m_WritePosition += p_Length;
+        m_ChunkedSize   += p_Length;
     }
+    /// Drop the last bytes written, they must not have been read
+    /// @p_Length : The length of the data
+    void PacketBuffer::Truncate(std::size_t p_Length)
+    {
+        assert(m_Mode == PacketBufferMode::Chunked && ReadLengthRemaining() >= p_Length);
+
+        m_ChunkedSize -= p_Length;
+
+        while (p_Length > m_WritePosition)
+        {
+            p_Length -= m_WritePosition;
+
+            FreeBlock(m_Chunks.back(), STORAGE_CHUNK_SIZE);
+            m_Chunks.pop_back();
+            m_WritePosition = STORAGE_CHUNK_SIZE;
+        }
+
+        m_WritePosition -= p_Length;
+
+        /// Nothing left, rewind the cursors like Consume does
+        if (m_ChunkedSize == 0)
+            m_ReadPosition = m_WritePosition = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
 
     /// Get the total read length of the packet
     std::size_t const PacketBuffer::ReadLength()
@@ -67,14 +325,56 @@ namespace SteerStone { namespace Core { namespace Network {
     /// Get the current read position
     std::size_t const PacketBuffer::ReadPosition()
     {
-        return m_Buffer[m_ReadPosition];
+        return m_Storage[m_ReadPosition];
     }
     /// Get the total read length of the packet
-    std::size_t const PacketBuffer::ReadLengthRemaining()
+    std::size_t const PacketBuffer::ReadLengthRemaining() const
     {
+        if (m_Mode == PacketBufferMode::Chunked)
+            return m_ChunkedSize;
+
         return m_WritePosition - m_ReadPosition;
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get a chunk, reusing the spare one if we have it
+    uint8* PacketBuffer::AllocateChunk()
+    {
+        if (m_SpareChunk)
+        {
+            uint8* l_Chunk = m_SpareChunk;
+            m_SpareChunk = nullptr;
+            return l_Chunk;
+        }
+
+        std::size_t l_Capacity = 0;
+        return AllocateBlock(STORAGE_CHUNK_SIZE, l_Capacity);
+    }
+    /// Borrow a block from our pool, or the heap
+    /// @p_Size     : Wanted size
+    /// @p_Capacity : Real size of the block
+    uint8* PacketBuffer::AllocateBlock(std::size_t const p_Size, std::size_t& p_Capacity)
+    {
+        if (m_Pool)
+            return m_Pool->Allocate(p_Size, p_Capacity);
+
+        /// Not value initialized, storage is never zero filled
+        p_Capacity = p_Size;
+        return new uint8[p_Size];
+    }
+    /// Hand a block back to our pool, or the heap
+    /// @p_Block    : Block
+    /// @p_Capacity : Real size of the block
+    void PacketBuffer::FreeBlock(uint8* p_Block, std::size_t const p_Capacity)
+    {
+        if (m_Pool)
+            m_Pool->Release(p_Block, p_Capacity);
+        else
+            delete[] p_Block;
+    }
+
 }   ///< namespace Network
 }   ///< namespace Core
-}   ///< namespace Steerstone
\ No newline at end of file
+}   ///< namespace Steerstone
@@ -19,13 +19,25 @@
 #pragma once
 #include <PCH/Precompiled.hpp>
 #include <boost/asio.hpp>
+#include <deque>
 #include "Core/Core.hpp"
+#include "PacketBufferPool.hpp"
 
 #define STORAGE_INITIAL_SIZE 4096
+#define STORAGE_CHUNK_SIZE 4096
 
 namespace SteerStone { namespace Core { namespace Network {
 
+    /// Storage layouts
+    enum class PacketBufferMode
+    {
+        Linear,                     ///< One contiguous block, data is moved on compaction
+        Chunked                     ///< Ring of fixed size chunks, data is never moved
+    };
+
     /// Buffer class to send/recieve packets
+    /// Storage is borrowed on the first write and can be handed back with Release once
+    /// everything has been read, so an idle buffer holds no memory
     class PacketBuffer
     {
         DISALLOW_COPY_AND_ASSIGN(PacketBuffer);
@@ -38,8 +50,11 @@ namespace SteerStone { namespace Core { namespace Network {
 
         public:
             /// Constructor
-            /// @p_InitializeSize : Reserve size for our m_Storage
-            explicit PacketBuffer(uint32 p_InitializeSize = STORAGE_INITIAL_SIZE);
+            /// @p_InitializeSize : Size of our m_Storage once it is first needed
+            /// @p_Mode           : Storage layout
+            explicit PacketBuffer(uint32 p_InitializeSize = STORAGE_INITIAL_SIZE, PacketBufferMode p_Mode = PacketBufferMode::Linear);
+            /// Deconstructor
+            ~PacketBuffer();
 
             //////////////////////////////////////////////////////////////////////////
             //////////////////////////////////////////////////////////////////////////
@@ -52,19 +67,70 @@ namespace SteerStone { namespace Core { namespace Network {
             /// @p_Buffer : Buffer which holds the data
             /// @p_Length : The length of the data
             void Write(char const* p_Buffer, std::size_t const& p_Length);
+            /// Move the unread bytes (a partial frame) to the front of the storage
+            /// so the next read can append the rest of the frame
+            void Compact();
+
+            /// Set the pool our storage is borrowed from, null uses the heap
+            /// @p_Pool : Pool, must outlive the storage it lends
+            void SetPool(PacketBufferPool* p_Pool);
+            /// Make sure the linear storage holds at least p_Size bytes
+            /// @p_Size : Wanted size
+            void Reserve(std::size_t const p_Size);
+            /// Hand our storage back, only if nothing is left unread
+            void Release();
+            /// Check if we currently hold storage
+            bool HasStorage() const;
+
+            /// Get the first contiguous block of unread data
+            boost::asio::const_buffer GetReadSpan() const;
+            /// Append every contiguous block of unread data, in order
+            /// @p_Spans : Spans are pushed to the back of this
+            void GetReadSpans(std::vector<boost::asio::const_buffer>& p_Spans) const;
+            /// Mark data as read, without copying it anywhere
+            /// @p_Length : The length of the data
+            void Consume(std::size_t const p_Length);
+
+            /// Get room at the back of the chunk ring to write into, never empty
+            boost::asio::mutable_buffer GetWriteSpan();
+            /// Mark bytes written into the write span as written
+            /// @p_Length : The length of the data
+            void Advance(std::size_t const p_Length);
+            /// Drop the last bytes written, they must not have been read
+            /// @p_Length : The length of the data
+            void Truncate(std::size_t p_Length);
 
             /// Get the total read length of the packet
             std::size_t const ReadLength();
             /// Get the total read length of the packet
-            std::size_t const ReadLengthRemaining();
+            std::size_t const ReadLengthRemaining() const;
             /// Get the current read position
             std::size_t const ReadPosition();
 
+        private:
+            /// Get a chunk, reusing the spare one if we have it
+            uint8* AllocateChunk();
+            /// Borrow a block from our pool, or the heap
+            /// @p_Size     : Wanted size
+            /// @p_Capacity : Real size of the block
+            uint8* AllocateBlock(std::size_t const p_Size, std::size_t& p_Capacity);
+            /// Hand a block back to our pool, or the heap
+            /// @p_Block    : Block
+            /// @p_Capacity : Real size of the block
+            void FreeBlock(uint8* p_Block, std::size_t const p_Capacity);
+
         private:
             /// Storage
-            std::size_t m_WritePosition;  ///< Write position in our storage
-            std::size_t m_ReadPosition;   ///< Read position in our storage
-            std::vector<uint8> m_Buffer;  ///< Vector Storage
+            PacketBufferMode m_Mode;                            ///< Storage layout
+            PacketBufferPool* m_Pool;                           ///< Pool our storage is borrowed from, may be null
+            std::size_t const m_InitializeSize;                 ///< Size of the linear storage once it is first needed
+            std::size_t m_WritePosition;                        ///< Write position in our storage (Chunked: inside the back chunk)
+            std::size_t m_ReadPosition;                         ///< Read position in our storage (Chunked: inside the front chunk)
+            uint8* m_Storage;                                   ///< Linear Storage
+            std::size_t m_Capacity;                             ///< Size of the linear storage
+            std::deque<uint8*> m_Chunks;                        ///< Chunk Storage
+            uint8* m_SpareChunk;                                ///< Last released chunk, kept to avoid churn when we have no pool
+            std::size_t m_ChunkedSize;                          ///< Unread bytes in chunk storage
     };
 
 }   ///< namespace Network
@@ -0,0 +1,148 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PacketBufferPool.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Block sizes of our size classes
+    static std::size_t const s_ClassSizes[PACKET_BUFFER_POOL_CLASSES] = { 256, 1024, 4096, 16384 };
+
+    /// Constructor
+    /// @p_MaxCached : Most free blocks kept per size class
+    PacketBufferPool::PacketBufferPool(std::size_t const p_MaxCached)
+        : m_MaxCached(p_MaxCached)
+    {
+        for (std::size_t l_I = 0; l_I < m_Classes.size(); l_I++)
+        {
+            m_Classes[l_I].BlockSize        = l_I < PACKET_BUFFER_POOL_CLASSES ? s_ClassSizes[l_I] : 0;
+            m_Classes[l_I].InUse            = 0;
+            m_Classes[l_I].HighWaterMark    = 0;
+            m_Classes[l_I].Allocations      = 0;
+        }
+    }
+    /// Deconstructor
+    PacketBufferPool::~PacketBufferPool()
+    {
+        Trim();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Borrow a block of at least p_Size bytes, never zero filled
+    /// @p_Size     : Wanted size
+    /// @p_Capacity : Real size of the block, must be passed back to Release
+    uint8* PacketBufferPool::Allocate(std::size_t const p_Size, std::size_t& p_Capacity)
+    {
+        const std::size_t l_Index = GetClass(p_Size);
+
+        std::lock_guard<std::mutex> l_Guard(m_Lock);
+
+        SizeClass& l_Class = m_Classes[l_Index];
+
+        if (++l_Class.InUse > l_Class.HighWaterMark)
+            l_Class.HighWaterMark = l_Class.InUse;
+
+        p_Capacity = l_Index < PACKET_BUFFER_POOL_CLASSES ? l_Class.BlockSize : p_Size;
+
+        if (!l_Class.Free.empty())
+        {
+            uint8* l_Block = l_Class.Free.back();
+            l_Class.Free.pop_back();
+            return l_Block;
+        }
+
+        l_Class.Allocations++;
+
+        return new uint8[p_Capacity];
+    }
+    /// Hand a block back
+    /// @p_Block    : Block given by Allocate
+    /// @p_Capacity : Capacity given by Allocate
+    void PacketBufferPool::Release(uint8* p_Block, std::size_t const p_Capacity)
+    {
+        const std::size_t l_Index = GetClass(p_Capacity);
+
+        std::lock_guard<std::mutex> l_Guard(m_Lock);
+
+        SizeClass& l_Class = m_Classes[l_Index];
+        l_Class.InUse--;
+
+        /// Oversized blocks are never kept, neither is anything past the cache limit
+        if (l_Index == PACKET_BUFFER_POOL_CLASSES || l_Class.Free.size() >= m_MaxCached)
+        {
+            delete[] p_Block;
+            return;
+        }
+
+        l_Class.Free.push_back(p_Block);
+    }
+    /// Free every cached block
+    void PacketBufferPool::Trim()
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Lock);
+
+        for (SizeClass& l_Class : m_Classes)
+        {
+            for (uint8* l_Block : l_Class.Free)
+                delete[] l_Block;
+
+            l_Class.Free.clear();
+            l_Class.Free.shrink_to_fit();
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get statistics of every size class, the last entry is oversized blocks
+    std::array<PacketBufferPoolStats, PACKET_BUFFER_POOL_CLASSES + 1> PacketBufferPool::GetStats()
+    {
+        std::lock_guard<std::mutex> l_Guard(m_Lock);
+
+        std::array<PacketBufferPoolStats, PACKET_BUFFER_POOL_CLASSES + 1> l_Stats;
+        for (std::size_t l_I = 0; l_I < m_Classes.size(); l_I++)
+        {
+            l_Stats[l_I].BlockSize      = m_Classes[l_I].BlockSize;
+            l_Stats[l_I].InUse          = m_Classes[l_I].InUse;
+            l_Stats[l_I].HighWaterMark  = m_Classes[l_I].HighWaterMark;
+            l_Stats[l_I].Cached         = m_Classes[l_I].Free.size();
+            l_Stats[l_I].Allocations    = m_Classes[l_I].Allocations;
+        }
+
+        return l_Stats;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get size class index for a size, PACKET_BUFFER_POOL_CLASSES when oversized
+    /// @p_Size : Size
+    std::size_t PacketBufferPool::GetClass(std::size_t const p_Size)
+    {
+        for (std::size_t l_I = 0; l_I < PACKET_BUFFER_POOL_CLASSES; l_I++)
+            if (p_Size <= s_ClassSizes[l_I])
+                return l_I;
+
+        return PACKET_BUFFER_POOL_CLASSES;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
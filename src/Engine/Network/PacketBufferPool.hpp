@@ -0,0 +1,97 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <array>
+#include <mutex>
+#include "Core/Core.hpp"
+
+#define PACKET_BUFFER_POOL_CLASSES 4
+#define PACKET_BUFFER_POOL_MAX_CACHED 1024
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Statistics of one size class
+    struct PacketBufferPoolStats
+    {
+        std::size_t BlockSize;          ///< Size of blocks in this class, 0 for oversized blocks
+        std::size_t InUse;              ///< Blocks lent out right now
+        std::size_t HighWaterMark;      ///< Most blocks ever lent out at once
+        std::size_t Cached;             ///< Free blocks kept for reuse
+        uint64 Allocations;             ///< Blocks taken from the heap
+    };
+
+    /// Lends buffer storage to the sockets of one NetworkThread
+    /// Blocks are rounded up to a size class and kept on a free list when handed back,
+    /// so an idle connection holds no buffer memory and a busy one does not hit the heap
+    class PacketBufferPool
+    {
+        DISALLOW_COPY_AND_ASSIGN(PacketBufferPool);
+
+        /// Size class
+        struct SizeClass
+        {
+            std::size_t BlockSize;          ///< Size of blocks
+            std::vector<uint8*> Free;       ///< Free blocks
+            std::size_t InUse;              ///< Blocks lent out
+            std::size_t HighWaterMark;      ///< Most blocks lent out at once
+            uint64 Allocations;             ///< Blocks taken from the heap
+        };
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            /// @p_MaxCached : Most free blocks kept per size class
+            explicit PacketBufferPool(std::size_t const p_MaxCached = PACKET_BUFFER_POOL_MAX_CACHED);
+            /// Deconstructor
+            ~PacketBufferPool();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Borrow a block of at least p_Size bytes, never zero filled
+            /// @p_Size     : Wanted size
+            /// @p_Capacity : Real size of the block, must be passed back to Release
+            uint8* Allocate(std::size_t const p_Size, std::size_t& p_Capacity);
+            /// Hand a block back
+            /// @p_Block    : Block given by Allocate
+            /// @p_Capacity : Capacity given by Allocate
+            void Release(uint8* p_Block, std::size_t const p_Capacity);
+            /// Free every cached block
+            void Trim();
+
+            /// Get statistics of every size class, the last entry is oversized blocks
+            std::array<PacketBufferPoolStats, PACKET_BUFFER_POOL_CLASSES + 1> GetStats();
+
+        private:
+            /// Get size class index for a size, PACKET_BUFFER_POOL_CLASSES when oversized
+            /// @p_Size : Size
+            static std::size_t GetClass(std::size_t const p_Size);
+
+        private:
+            std::array<SizeClass, PACKET_BUFFER_POOL_CLASSES + 1> m_Classes;    ///< Size classes, last one is oversized
+            std::size_t const m_MaxCached;                                      ///< Most free blocks kept per class
+            std::mutex m_Lock;                                                  ///< Mutex
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
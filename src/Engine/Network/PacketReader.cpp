@@ -0,0 +1,222 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <array>
+
+#include "PacketReader.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Flag of a byte which is not a base64 character in s_Base64Table
+    static constexpr uint8 s_Base64Invalid = 0x80;
+
+    /// 6 bit value of every base64 character, '@' to DEL; anything else carries s_Base64Invalid
+    static constexpr std::array<uint8, 256> s_Base64Table = []()
+    {
+        std::array<uint8, 256> l_Table{};
+
+        for (std::size_t l_I = 0; l_I < l_Table.size(); l_I++)
+            l_Table[l_I] = (l_I >= 64 && l_I < 128) ? static_cast<uint8>(l_I - 64) : s_Base64Invalid;
+
+        return l_Table;
+    }();
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Frame : Frame to read, must outlive the reader
+    PacketReader::PacketReader(FrameView const& p_Frame)
+        : m_Position(p_Frame.GetData()), m_End(p_Frame.GetData() + p_Frame.GetSize()), m_Error(false)
+    {
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Read a byte
+    uint8 PacketReader::ReadUInt8()
+    {
+        uint8 const* l_Data = Take(1);
+        return l_Data ? l_Data[0] : 0;
+    }
+    /// Read a 16 bit integer, big endian
+    uint16 PacketReader::ReadUInt16()
+    {
+        uint8 const* l_Data = Take(2);
+        if (!l_Data)
+            return 0;
+
+        return static_cast<uint16>((l_Data[0] << 8) | l_Data[1]);
+    }
+    /// Read a 32 bit integer, big endian
+    uint32 PacketReader::ReadUInt32()
+    {
+        uint8 const* l_Data = Take(4);
+        if (!l_Data)
+            return 0;
+
+        return (static_cast<uint32>(l_Data[0]) << 24) | (static_cast<uint32>(l_Data[1]) << 16) | (static_cast<uint32>(l_Data[2]) << 8) | l_Data[3];
+    }
+    /// Read an integer encoded as base64 characters, like opcodes and lengths
+    /// @p_Digits : Characters to read, 6 bits each
+    uint32 PacketReader::ReadBase64(std::size_t const p_Digits)
+    {
+        uint8 const* l_Data = Take(p_Digits);
+        if (!l_Data)
+            return 0;
+
+        uint32 l_Value = 0;
+        if (!DecodeBase64(l_Data, p_Digits, l_Value))
+        {
+            m_Error = true;
+            return 0;
+        }
+
+        return l_Value;
+    }
+    /// Read an integer in the client's variable length encoding
+    /// The first byte holds the byte count, the sign and the 2 lowest bits, every following byte 6 more bits
+    int32 PacketReader::ReadVL64()
+    {
+        if (m_Position == m_End)
+        {
+            m_Error = true;
+            return 0;
+        }
+
+        const uint8 l_Head = s_Base64Table[m_Position[0]];
+        const std::size_t l_Count = (l_Head >> 3) & 7;
+
+        if ((l_Head & s_Base64Invalid) || l_Count == 0 || l_Count > PACKET_READER_VL64_MAX_SIZE)
+        {
+            m_Error = true;
+            return 0;
+        }
+
+        uint8 const* l_Data = Take(l_Count);
+        if (!l_Data)
+            return 0;
+
+        uint32 l_Value  = l_Head & 3;
+        uint8 l_Invalid = 0;
+
+        for (std::size_t l_I = 1; l_I < l_Count; l_I++)
+        {
+            const uint8 l_Bits = s_Base64Table[l_Data[l_I]];
+
+            l_Invalid |= l_Bits;
+            l_Value   |= static_cast<uint32>(l_Bits & 0x3F) << (2 + 6 * (l_I - 1));
+        }
+
+        if (l_Invalid & s_Base64Invalid)
+        {
+            m_Error = true;
+            return 0;
+        }
+
+        return (l_Head & 4) ? -static_cast<int32>(l_Value) : static_cast<int32>(l_Value);
+    }
+    /// Read a string prefixed by its base64 encoded length
+    std::string_view PacketReader::ReadString()
+    {
+        const uint32 l_Length = ReadBase64(PACKET_READER_STRING_LENGTH_SIZE);
+
+        uint8 const* l_Data = Take(l_Length);
+        if (!l_Data)
+            return std::string_view();
+
+        return std::string_view(reinterpret_cast<char const*>(l_Data), l_Length);
+    }
+    /// Read raw bytes
+    /// @p_Length : The length of the data
+    FrameView PacketReader::ReadBytes(std::size_t const p_Length)
+    {
+        uint8 const* l_Data = Take(p_Length);
+        if (!l_Data)
+            return FrameView(m_Position, 0);
+
+        return FrameView(l_Data, p_Length);
+    }
+    /// Skip bytes
+    /// @p_Length : The length of the data to skip
+    void PacketReader::Skip(std::size_t const p_Length)
+    {
+        Take(p_Length);
+    }
+
+    /// Get the length remaining to read
+    std::size_t PacketReader::GetRemaining() const
+    {
+        return static_cast<std::size_t>(m_End - m_Position);
+    }
+    /// Check if a read failed
+    bool PacketReader::HasError() const
+    {
+        return m_Error;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Decode base64 characters, returns false if one is not a base64 character
+    /// @p_Data   : Characters, p_Digits of them must be readable
+    /// @p_Digits : Characters to decode, 6 bits each
+    /// @p_Value  : Decoded value
+    bool PacketReader::DecodeBase64(uint8 const* p_Data, std::size_t const p_Digits, uint32& p_Value)
+    {
+        uint32 l_Value  = 0;
+        uint8 l_Invalid = 0;
+
+        /// One table lookup per character, invalid characters are checked once at the end
+        for (std::size_t l_I = 0; l_I < p_Digits; l_I++)
+        {
+            const uint8 l_Bits = s_Base64Table[p_Data[l_I]];
+
+            l_Invalid |= l_Bits;
+            l_Value    = (l_Value << 6) | (l_Bits & 0x3F);
+        }
+
+        p_Value = l_Value;
+        return !(l_Invalid & s_Base64Invalid);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Take p_Length bytes, null and marks the reader as failed if they are not there
+    /// @p_Length : The length of the data
+    uint8 const* PacketReader::Take(std::size_t const p_Length)
+    {
+        /// A failed reader stays failed, later fields would be read from the wrong offset
+        if (m_Error || p_Length > static_cast<std::size_t>(m_End - m_Position))
+        {
+            m_Error = true;
+            return nullptr;
+        }
+
+        uint8 const* l_Data = m_Position;
+        m_Position += p_Length;
+
+        return l_Data;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
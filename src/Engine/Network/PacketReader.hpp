@@ -0,0 +1,91 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <string_view>
+
+#include "Core/Core.hpp"
+#include "FrameView.hpp"
+
+#define PACKET_READER_STRING_LENGTH_SIZE 2      ///< Base64 encoded length in front of every client string
+#define PACKET_READER_VL64_MAX_SIZE 6           ///< Longest VL64 integer, 2 + 5 * 6 bits
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Bounds checked cursor over a frame, decodes the client's wire encodings without allocating
+    /// A read past the end or of a malformed field returns 0 or an empty view and marks the reader
+    /// as failed; handlers read every field and check HasError once at the end
+    class PacketReader
+    {
+        public:
+            /// Constructor
+            /// @p_Frame : Frame to read, must outlive the reader
+            explicit PacketReader(FrameView const& p_Frame);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Read a byte
+            uint8 ReadUInt8();
+            /// Read a 16 bit integer, big endian
+            uint16 ReadUInt16();
+            /// Read a 32 bit integer, big endian
+            uint32 ReadUInt32();
+            /// Read an integer encoded as base64 characters, like opcodes and lengths
+            /// @p_Digits : Characters to read, 6 bits each
+            uint32 ReadBase64(std::size_t const p_Digits);
+            /// Read an integer in the client's variable length encoding
+            int32 ReadVL64();
+            /// Read a string prefixed by its base64 encoded length
+            std::string_view ReadString();
+            /// Read raw bytes
+            /// @p_Length : The length of the data
+            FrameView ReadBytes(std::size_t const p_Length);
+            /// Skip bytes
+            /// @p_Length : The length of the data to skip
+            void Skip(std::size_t const p_Length);
+
+            /// Get the length remaining to read
+            std::size_t GetRemaining() const;
+            /// Check if a read failed
+            bool HasError() const;
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Decode base64 characters, returns false if one is not a base64 character
+            /// @p_Data   : Characters, p_Digits of them must be readable
+            /// @p_Digits : Characters to decode, 6 bits each
+            /// @p_Value  : Decoded value
+            static bool DecodeBase64(uint8 const* p_Data, std::size_t const p_Digits, uint32& p_Value);
+
+        private:
+            /// Take p_Length bytes, null and marks the reader as failed if they are not there
+            /// @p_Length : The length of the data
+            uint8 const* Take(std::size_t const p_Length);
+
+        private:
+            uint8 const* m_Position;        ///< Next byte to read
+            uint8 const* m_End;             ///< End of the frame
+            bool m_Error;                   ///< A read failed
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
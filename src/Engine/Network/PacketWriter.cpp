@@ -0,0 +1,200 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <cstring>
+
+#include "PacketWriter.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Constructor
+    /// @p_Socket    : Socket to queue the message on
+    /// @p_Flags     : Write flags, decide what happens to the message while over the outbound limits
+    /// @p_StatusKey : Key of a WriteFlags_Status message, a newer message of the same key replaces it
+    PacketWriter::PacketWriter(Socket& p_Socket, WriteFlags const p_Flags, uint32 const p_StatusKey)
+        : m_Socket(p_Socket), m_Guard(&p_Socket), m_Flags(p_Flags), m_StatusKey(p_StatusKey),
+        m_SpanStart(nullptr), m_Cursor(nullptr), m_SpanEnd(nullptr), m_Size(0), m_Committed(false)
+    {
+        /// Reserve the header, it is filled in once the body length is known
+        for (std::size_t l_I = 0; l_I < PACKET_WRITER_LENGTH_HEADER_SIZE; l_I++)
+        {
+            if (m_Cursor == m_SpanEnd)
+                NextSpan();
+
+            m_Header[l_I] = m_Cursor++;
+        }
+    }
+    /// Deconstructor
+    PacketWriter::~PacketWriter()
+    {
+        if (m_Committed)
+            return;
+
+        Sync();
+        m_Socket.m_OutQueue.DropPending();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Write raw bytes
+    /// @p_Buffer : Buffer which holds the data
+    /// @p_Length : The length of the data
+    void PacketWriter::WriteBytes(void const* p_Buffer, std::size_t const p_Length)
+    {
+        LOG_ASSERT(!m_Committed, "PacketWriter", "Writing to a message which is already committed!");
+
+        uint8 const* l_Buffer = static_cast<uint8 const*>(p_Buffer);
+
+        std::size_t l_Written = 0;
+        while (l_Written < p_Length)
+        {
+            if (m_Cursor == m_SpanEnd)
+                NextSpan();
+
+            const std::size_t l_Length = std::min(p_Length - l_Written, static_cast<std::size_t>(m_SpanEnd - m_Cursor));
+
+            memcpy(m_Cursor, l_Buffer + l_Written, l_Length);
+
+            m_Cursor    += l_Length;
+            l_Written   += l_Length;
+        }
+
+        m_Size += p_Length;
+    }
+    /// Write a byte
+    /// @p_Value : Value
+    void PacketWriter::WriteUInt8(uint8 const p_Value)
+    {
+        LOG_ASSERT(!m_Committed, "PacketWriter", "Writing to a message which is already committed!");
+
+        if (m_Cursor == m_SpanEnd)
+            NextSpan();
+
+        *m_Cursor++ = p_Value;
+        m_Size++;
+    }
+    /// Write a 16 bit integer, big endian
+    /// @p_Value : Value
+    void PacketWriter::WriteUInt16(uint16 const p_Value)
+    {
+        const uint8 l_Bytes[2] = { static_cast<uint8>(p_Value >> 8), static_cast<uint8>(p_Value) };
+        WriteBytes(l_Bytes, sizeof(l_Bytes));
+    }
+    /// Write a 32 bit integer, big endian
+    /// @p_Value : Value
+    void PacketWriter::WriteUInt32(uint32 const p_Value)
+    {
+        const uint8 l_Bytes[4] = { static_cast<uint8>(p_Value >> 24), static_cast<uint8>(p_Value >> 16), static_cast<uint8>(p_Value >> 8), static_cast<uint8>(p_Value) };
+        WriteBytes(l_Bytes, sizeof(l_Bytes));
+    }
+    /// Write an integer as base64 characters, like opcodes and lengths
+    /// @p_Value  : Value
+    /// @p_Digits : Characters to write, 6 bits each
+    void PacketWriter::WriteBase64(uint32 const p_Value, uint32 const p_Digits)
+    {
+        LOG_ASSERT(p_Digits <= 5, "PacketWriter", "Base64 value of %0 characters does not fit in 32 bits!", p_Digits);
+
+        uint8 l_Bytes[5];
+        for (uint32 l_I = 0; l_I < p_Digits; l_I++)
+            l_Bytes[l_I] = static_cast<uint8>(64 | ((p_Value >> (6 * (p_Digits - 1 - l_I))) & 0x3F));
+
+        WriteBytes(l_Bytes, p_Digits);
+    }
+    /// Write an integer in the client's variable length encoding
+    /// The first byte holds the byte count, the sign and the 2 lowest bits, every following byte 6 more bits
+    /// @p_Value : Value
+    void PacketWriter::WriteVL64(int32 const p_Value)
+    {
+        uint32 l_Value = p_Value < 0 ? static_cast<uint32>(-static_cast<int64>(p_Value)) : static_cast<uint32>(p_Value);
+
+        uint8 l_Bytes[6];
+        uint8 l_Count = 1;
+
+        l_Bytes[0] = static_cast<uint8>(64 | (l_Value & 3));
+        for (l_Value >>= 2; l_Value != 0; l_Value >>= 6)
+            l_Bytes[l_Count++] = static_cast<uint8>(64 | (l_Value & 0x3F));
+
+        l_Bytes[0] |= static_cast<uint8>((l_Count << 3) | (p_Value < 0 ? 4 : 0));
+
+        WriteBytes(l_Bytes, l_Count);
+    }
+    /// Write a string followed by a terminator
+    /// @p_String     : String
+    /// @p_Terminator : Byte written after the string
+    void PacketWriter::WriteString(std::string_view const p_String, uint8 const p_Terminator)
+    {
+        WriteBytes(p_String.data(), p_String.size());
+        WriteUInt8(p_Terminator);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get the length of the body written so far
+    std::size_t PacketWriter::GetSize() const
+    {
+        return m_Size;
+    }
+    /// Fill in the length header and queue the message, the writer may not be used afterwards
+    void PacketWriter::Commit()
+    {
+        LOG_ASSERT(!m_Committed, "PacketWriter", "Message is already committed!");
+
+        Sync();
+        m_Committed = true;
+
+        if (m_Size > PACKET_WRITER_MAX_LENGTH)
+        {
+            LOG_ERROR("PacketWriter", "Message of %0 bytes to %1 is too large, dropping", m_Size, m_Socket.GetRemoteAddress());
+            m_Socket.m_OutQueue.DropPending();
+            return;
+        }
+
+        /// Back patch the length
+        for (std::size_t l_I = 0; l_I < PACKET_WRITER_LENGTH_HEADER_SIZE; l_I++)
+            *m_Header[l_I] = static_cast<uint8>(64 | ((m_Size >> (6 * (PACKET_WRITER_LENGTH_HEADER_SIZE - 1 - l_I))) & 0x3F));
+
+        m_Socket.CommitInPlace(m_Flags, m_StatusKey);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Mark the bytes written into the current span as pending and take the next span
+    void PacketWriter::NextSpan()
+    {
+        Sync();
+
+        boost::asio::mutable_buffer l_Span = m_Socket.m_OutQueue.GetWriteSpan();
+
+        m_SpanStart = static_cast<uint8*>(l_Span.data());
+        m_Cursor    = m_SpanStart;
+        m_SpanEnd   = m_SpanStart + l_Span.size();
+    }
+    /// Mark the bytes written into the current span as pending
+    void PacketWriter::Sync()
+    {
+        m_Socket.m_OutQueue.Advance(m_Cursor - m_SpanStart);
+        m_SpanStart = m_Cursor;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
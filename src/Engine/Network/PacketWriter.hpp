@@ -0,0 +1,104 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <string_view>
+
+#include "Core/Core.hpp"
+#include "Socket.hpp"
+#include "Utility/UtiObjectGuard.hpp"
+
+#define PACKET_WRITER_LENGTH_HEADER_SIZE 3      ///< Base64 encoded length in front of every message
+#define PACKET_WRITER_MAX_LENGTH 262143         ///< Largest body 3 base64 characters can describe
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Serializes one message straight into the out queue of a socket
+    /// Room for the length header is reserved up front and filled in on Commit, fields are written
+    /// in place so the message is copied once, from the caller's data to the chunk it is sent from.
+    /// The socket lock is held from construction until the writer is gone, do not call Socket::Write
+    /// on the same socket meanwhile. A writer destroyed without Commit drops its message.
+    class PacketWriter
+    {
+        DISALLOW_COPY_AND_ASSIGN(PacketWriter);
+
+        public:
+            /// Constructor
+            /// @p_Socket    : Socket to queue the message on
+            /// @p_Flags     : Write flags, decide what happens to the message while over the outbound limits
+            /// @p_StatusKey : Key of a WriteFlags_Status message, a newer message of the same key replaces it
+            explicit PacketWriter(Socket& p_Socket, WriteFlags const p_Flags = WriteFlags_None, uint32 const p_StatusKey = 0);
+            /// Deconstructor
+            ~PacketWriter();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Write raw bytes
+            /// @p_Buffer : Buffer which holds the data
+            /// @p_Length : The length of the data
+            void WriteBytes(void const* p_Buffer, std::size_t const p_Length);
+            /// Write a byte
+            /// @p_Value : Value
+            void WriteUInt8(uint8 const p_Value);
+            /// Write a 16 bit integer, big endian
+            /// @p_Value : Value
+            void WriteUInt16(uint16 const p_Value);
+            /// Write a 32 bit integer, big endian
+            /// @p_Value : Value
+            void WriteUInt32(uint32 const p_Value);
+            /// Write an integer as base64 characters, like opcodes and lengths
+            /// @p_Value  : Value
+            /// @p_Digits : Characters to write, 6 bits each
+            void WriteBase64(uint32 const p_Value, uint32 const p_Digits);
+            /// Write an integer in the client's variable length encoding
+            /// @p_Value : Value
+            void WriteVL64(int32 const p_Value);
+            /// Write a string followed by a terminator
+            /// @p_String     : String
+            /// @p_Terminator : Byte written after the string
+            void WriteString(std::string_view const p_String, uint8 const p_Terminator = 2);
+
+            /// Get the length of the body written so far
+            std::size_t GetSize() const;
+            /// Fill in the length header and queue the message, the writer may not be used afterwards
+            void Commit();
+
+        private:
+            /// Mark the bytes written into the current span as pending and take the next span
+            void NextSpan();
+            /// Mark the bytes written into the current span as pending
+            void Sync();
+
+        private:
+            Socket& m_Socket;                                               ///< Socket we queue on
+            Utils::ObjectGuard<Socket> m_Guard;                             ///< Holds the socket lock while we write
+            WriteFlags const m_Flags;                                       ///< Write flags
+            uint32 const m_StatusKey;                                       ///< Status key
+            uint8* m_SpanStart;                                             ///< Start of the current span, bytes before it are pending
+            uint8* m_Cursor;                                                ///< Next byte to write
+            uint8* m_SpanEnd;                                               ///< End of the current span
+            uint8* m_Header[PACKET_WRITER_LENGTH_HEADER_SIZE];              ///< Reserved header bytes, may straddle two chunks
+            std::size_t m_Size;                                             ///< Body bytes written
+            bool m_Committed;                                               ///< Message is queued
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
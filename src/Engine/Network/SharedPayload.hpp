@@ -0,0 +1,81 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Immutable serialized message which can be queued on many sockets at once
+    /// Every socket holds a reference until the bytes are sent, the bytes are never copied
+    class SharedPayload
+    {
+        DISALLOW_COPY_AND_ASSIGN(SharedPayload);
+
+        public:
+            using Ptr = std::shared_ptr<SharedPayload const>;
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Copy a serialized message into a new payload
+            /// @p_Buffer : Buffer which holds the data
+            /// @p_Length : The length of the data
+            static Ptr Create(char const* p_Buffer, std::size_t const p_Length)
+            {
+                return std::make_shared<SharedPayload const>(p_Buffer, p_Length);
+            }
+
+            /// Constructor
+            /// @p_Buffer : Buffer which holds the data
+            /// @p_Length : The length of the data
+            SharedPayload(char const* p_Buffer, std::size_t const p_Length)
+                : m_Data(reinterpret_cast<uint8 const*>(p_Buffer), reinterpret_cast<uint8 const*>(p_Buffer) + p_Length)
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Get the serialized message
+            uint8 const* GetData() const
+            {
+                return m_Data.data();
+            }
+            /// Get the length of the serialized message
+            std::size_t GetSize() const
+            {
+                return m_Data.size();
+            }
+            /// Get the serialized message as a span, starting at p_Offset
+            /// @p_Offset : Bytes to skip
+            boost::asio::const_buffer GetSpan(std::size_t const p_Offset = 0) const
+            {
+                return boost::asio::const_buffer(m_Data.data() + p_Offset, m_Data.size() - p_Offset);
+            }
+
+        private:
+            std::vector<uint8> const m_Data;        ///< Serialized message
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -18,19 +18,57 @@
 */
 
 #include <boost/lexical_cast.hpp>
+#include <cstring>
+
+#ifdef NETWORK_HAS_HOT_RESTART
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
 
 #include "Socket.hpp"
 #include "Utility/UtiObjectGuard.hpp"
 
+#if defined(NETWORK_HAS_MIGRATION) && !defined(NETWORK_HAS_HOT_RESTART)
+    #include <unistd.h>
+#endif
+
 namespace SteerStone { namespace Core { namespace Network {
 
+    /// Used by sockets which were never given a policy by their NetworkThread
+    static FlushPolicy const s_DefaultFlushPolicy;
+    /// Used by sockets which were never given limits by their NetworkThread
+    static OutboundLimits const s_DefaultOutboundLimits;
+    static OutboundCounters s_DefaultOutboundCounters;
+    /// Used by sockets which were never given inbound limits by their NetworkThread
+    static InboundLimits const s_DefaultInboundLimits;
+    /// Used by sockets which were never given counters by their NetworkThread
+    static NetworkCounters s_DefaultNetworkCounters;
+    /// Next session id, seeded from the wall clock so ids of a restarted process never meet the ones it adopted
+    static std::atomic<uint64> s_NextSessionId(static_cast<uint64>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()));
+
     /// Constructor
     /// @p_Service : Socket to pass
     /// @p_CloseHandler : Custom Handler to handle our function
     Socket::Socket(boost::asio::io_service& p_Service, std::function<void(Socket*)> p_CloseHandler)
-        : m_WriteState(WriteState::Idle), m_ReadState(ReadState::Idle), m_Socket(p_Service),
-        m_CloseHandler(std::move(p_CloseHandler)), m_OutBufferFlushTimer(p_Service), m_Address("0.0.0.0") 
+        : m_Socket(p_Service), m_Service(&p_Service), m_MigrationService(nullptr), m_CloseHandler(std::move(p_CloseHandler)),
+        m_Address("0.0.0.0"), m_AddressSet(false), m_Handle(0), m_SessionId(0), m_InBuffer(STORAGE_INITIAL_SIZE, PacketBufferMode::Linear),
+        m_TlsContext(nullptr), m_Transport(SocketTransport::Raw), m_InboundLimits(&s_DefaultInboundLimits),
+        m_OutboundLimits(&s_DefaultOutboundLimits), m_OutboundCounters(&s_DefaultOutboundCounters), m_Evicted(false),
+        m_TimingWheel(nullptr), m_FlushPolicy(&s_DefaultFlushPolicy), m_HotWindowBytes(0), m_HotPreviousBytes(0),
+        m_NetworkCounters(&s_DefaultNetworkCounters), m_SendSize(0), m_InboundQueue(nullptr),
+        m_InboundFrames(0), m_InboundBytes(0), m_ReadPaused(false), m_ResumeFrames(0), m_ResumeBytes(0),
+        m_IoUring(nullptr), m_WriteState(WriteState::Idle), m_ReadState(ReadState::Idle)
     {
+        m_OutBufferFlushTimer.SetCallback([this]() { this->FlushOut(); });
+        m_RingRead.SetCallback([this](int32 p_Result, uint32 p_Flags) { this->OnRingRead(p_Result, p_Flags); });
+        m_RingWrite.SetCallback([this](int32 p_Result, uint32)
+        {
+            if (p_Result < 0)
+                this->OnWriteComplete(boost::system::error_code(-p_Result, boost::system::system_category()), 0);
+            else
+                this->OnWriteComplete(boost::system::error_code(), static_cast<std::size_t>(p_Result));
+        });
     }
 
     //////////////////////////////////////////////////////////////////////////
@@ -41,18 +79,46 @@ namespace SteerStone { namespace Core { namespace Network {
     {
         try
         {
-            const_cast<std::string&>(m_Address)         = m_Socket.remote_endpoint().address().to_string();
-            const_cast<std::string&>(m_RemoteEndPoint)  = boost::lexical_cast<std::string>(m_Socket.remote_endpoint());
+            m_Address           = m_Socket.remote_endpoint().address().to_string();
+            m_RemoteEndPoint    = boost::lexical_cast<std::string>(m_Socket.remote_endpoint());
         }
-        catch (boost::system::error_code&)
+        catch (boost::system::system_error const&)
         {
             LOG_ERROR("Socket", "Failed to initialize socket address");
             return false;
         }
 
-        m_OutBuffer.reset(new PacketBuffer);
-        m_SecondaryOutBuffer.reset(new PacketBuffer);
-        m_InBuffer.reset(new PacketBuffer);
+        /// We are in our NetworkThread registry already, counter snapshots only read our address from here on
+        m_AddressSet.store(true, std::memory_order_release);
+
+        /// Adopted sockets keep the session they had before the restart
+        if (!m_SessionId.load(std::memory_order_relaxed))
+            m_SessionId.store(s_NextSessionId.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+
+        boost::system::error_code l_ErrorCode;
+        m_Socket.set_option(boost::asio::ip::tcp::no_delay(m_FlushPolicy->NoDelay), l_ErrorCode);
+
+        /// Reads are made once the socket is readable, they must never block the NetworkThread
+        m_Socket.non_blocking(true, l_ErrorCode);
+        if (l_ErrorCode)
+        {
+            LOG_ERROR("Socket", "Failed to set socket non blocking: %0", l_ErrorCode.message());
+            return false;
+        }
+
+        /// The handshake starts once the client sends its hello
+        if (m_TlsContext)
+        {
+            m_Tls.reset(new TlsConnection(*m_TlsContext, m_Socket.native_handle()));
+
+            if (!m_Tls->IsValid())
+            {
+                LOG_ERROR("Socket", "Failed to set up TLS for client %0: %1", m_Address, TlsContext::GetLastError());
+                return false;
+            }
+        }
+
+        m_NetworkCounters->Accepts.Add(1);
 
         StartAsyncRead();
 
@@ -66,6 +132,7 @@ namespace SteerStone { namespace Core { namespace Network {
         if (IsClosed())
             return;
 
+        /// A receive or send our ring holds on the descriptor ends with the shutdown
         boost::system::error_code l_ErrorCode;
         m_Socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, l_ErrorCode);
         m_Socket.close();
@@ -83,6 +150,201 @@ namespace SteerStone { namespace Core { namespace Network {
     {
         return IsClosed();
     }
+    /// Let go of our connection so another process can resume it, from our NetworkThread only
+    /// Returns false while a write is in flight, try again later; once it returns true our socket is closed
+    /// without calling our close handler, unless we cannot be handed over
+    /// @p_Handoff : Our descriptor and unhandled / unsent bytes, Fd is -1 if we were already closed or cannot be handed over
+    bool Socket::Detach(SocketHandoff& p_Handoff)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        p_Handoff.Fd = -1;
+
+        if (IsClosed())
+            return true;
+
+        /// TLS state lives inside OpenSSL and cannot follow the descriptor, we keep serving the client until our
+        /// successor took the others, then it reconnects and resumes its session
+        if (m_Tls)
+            return true;
+
+        /// The kernel may still be reading our spans, what it takes is only known once the write completes
+        if (m_WriteState == WriteState::Sending)
+            return false;
+
+        /// The ring would keep receiving on our descriptor after we let go of it, stop reading until it came back
+        if (m_RingRead.IsPending())
+        {
+            m_ReadState = ReadState::Idle;
+            m_IoUring->Cancel(m_RingRead);
+            return false;
+        }
+
+        if (m_TimingWheel)
+            m_TimingWheel->Cancel(m_OutBufferFlushTimer);
+
+        p_Handoff.SessionId = m_SessionId.load(std::memory_order_relaxed);
+        p_Handoff.Transport = static_cast<uint8>(m_Transport);
+
+        /// Nothing is in flight, so our WebSocket output sits between frames
+        p_Handoff.TransportState.clear();
+        if (m_WebSocket)
+            m_WebSocket->SaveState(p_Handoff.TransportState);
+
+        /// Partial frame, the rest of it arrives in the process which adopts us
+        p_Handoff.InBuffer.assign(InPeak(), InPeak() + ReadLengthRemaining());
+
+        m_SendSpans.clear();
+        m_OutQueue.GetSpans(m_SendSpans);
+
+        p_Handoff.OutQueue.clear();
+        p_Handoff.OutQueue.reserve(m_OutQueue.GetSize());
+
+        for (boost::asio::const_buffer const& l_Span : m_SendSpans)
+            p_Handoff.OutQueue.insert(p_Handoff.OutQueue.end(), static_cast<uint8 const*>(l_Span.data()), static_cast<uint8 const*>(l_Span.data()) + l_Span.size());
+
+        /// Held status messages are the latest of their key, our successor sends them after the queue
+        for (auto const& l_Held : m_HeldStatus)
+            p_Handoff.OutQueue.insert(p_Handoff.OutQueue.end(), l_Held.second->GetData(), l_Held.second->GetData() + l_Held.second->GetSize());
+
+        /// Pending reads and writes complete with operation_aborted and find us closed
+        boost::system::error_code l_ErrorCode;
+        p_Handoff.Fd = m_Socket.release(l_ErrorCode);
+
+        if (l_ErrorCode)
+        {
+            LOG_ERROR("Socket", "Failed to release socket of client %0: %1", m_Address, l_ErrorCode.message());
+            p_Handoff.Fd = -1;
+
+            /// Nothing is left to hand over, the client reconnects on its own
+            m_Socket.close(l_ErrorCode);
+        }
+
+        m_OutQueue.Consume(m_OutQueue.GetSize());
+        m_OutQueue.Release();
+        m_HeldStatus.clear();
+        m_WriteState = WriteState::Idle;
+
+        return true;
+    }
+    /// Keep serving the client after Detach returned false and the hand off gave up on us, from our NetworkThread only
+    /// Detach stops our receive while it waits for a write in flight, nothing else stops reading without resuming it
+    void Socket::CancelDetach()
+    {
+        if (IsClosed() || !IsOnRing() || m_ReadState != ReadState::Idle || m_ReadPaused.load())
+            return;
+
+        StartAsyncRead();
+    }
+    /// Resume a connection handed over by the process we replace, instead of being accepted
+    /// @p_Handoff : Connection, we own its descriptor and close it if we fail
+    bool Socket::Adopt(SocketHandoff const& p_Handoff)
+    {
+    #ifdef NETWORK_HAS_HOT_RESTART
+        sockaddr_storage l_Address;
+        socklen_t l_Length = sizeof(l_Address);
+
+        boost::system::error_code l_ErrorCode;
+
+        if (getsockname(p_Handoff.Fd, reinterpret_cast<sockaddr*>(&l_Address), &l_Length) == 0)
+            m_Socket.assign(l_Address.ss_family == AF_INET6 ? boost::asio::ip::tcp::v6() : boost::asio::ip::tcp::v4(), p_Handoff.Fd, l_ErrorCode);
+        else
+            l_ErrorCode.assign(errno, boost::system::system_category());
+
+        if (l_ErrorCode)
+        {
+            LOG_ERROR("Socket", "Failed to adopt socket: %0", l_ErrorCode.message());
+            ::close(p_Handoff.Fd);
+            return false;
+        }
+
+        m_SessionId.store(p_Handoff.SessionId, std::memory_order_relaxed);
+        m_Transport = static_cast<SocketTransport>(p_Handoff.Transport);
+
+        /// Only plaintext connections are handed over
+        m_TlsContext = nullptr;
+
+        if (m_Transport == SocketTransport::Handshake || m_Transport == SocketTransport::WebSocket)
+        {
+            m_WebSocket.reset(new WebSocket());
+
+            if (!m_WebSocket->LoadState(p_Handoff.TransportState))
+            {
+                LOG_ERROR("Socket", "Failed to adopt socket: invalid WebSocket state");
+                m_Socket.close(l_ErrorCode);
+                return false;
+            }
+        }
+        else if (m_Transport != SocketTransport::Raw && m_Transport != SocketTransport::Detecting)
+        {
+            LOG_ERROR("Socket", "Failed to adopt socket: unknown transport %0", static_cast<uint32>(p_Handoff.Transport));
+            m_Socket.close(l_ErrorCode);
+            return false;
+        }
+
+        if (!p_Handoff.InBuffer.empty())
+            m_InBuffer.Write(reinterpret_cast<const char*>(p_Handoff.InBuffer.data()), p_Handoff.InBuffer.size());
+
+        if (!Open())
+        {
+            m_Socket.close(l_ErrorCode);
+            return false;
+        }
+
+        /// Already admitted once by the process we replace
+        if (!p_Handoff.OutQueue.empty())
+            Write(reinterpret_cast<const char*>(p_Handoff.OutQueue.data()), p_Handoff.OutQueue.size(), WriteFlags_Critical);
+
+        return true;
+    #else
+        UNUSED(p_Handoff);
+        return false;
+    #endif
+    }
+    /// Move to another NetworkThread, from our NetworkThread only
+    /// Our read wait is cancelled and we move once it comes back, when nothing of ours runs on the old thread;
+    /// returns false if we cannot start now (closed, a write in flight or already moving), try again later
+    /// @p_Service : Service of the NetworkThread taking us
+    /// @p_Attach  : Called from the old thread under our lock once we run on p_Service, gives us the limits,
+    ///              counters and timing wheel of the new thread
+    bool Socket::Migrate(boost::asio::io_service& p_Service, std::function<void(Socket*)> p_Attach)
+    {
+    #ifdef NETWORK_HAS_MIGRATION
+        Utils::ObjectGuard l_Guard(this);
+
+        /// Every open socket has exactly one read wait, one read posted or one receive on our ring, which we move behind
+        if (IsClosed() || m_MigrationService || m_ReadState != ReadState::Reading || (IsOnRing() && !m_RingRead.IsPending()))
+            return false;
+
+        /// The kernel may still be reading our spans, asio would complete the write on the old thread
+        if (m_WriteState == WriteState::Sending)
+            return false;
+
+        m_MigrationService = &p_Service;
+        m_MigrationAttach  = std::move(p_Attach);
+
+        /// A flush armed on the old wheel is armed again on the new one
+        if (m_WriteState == WriteState::Buffering && m_TimingWheel && m_TimingWheel->Cancel(m_OutBufferFlushTimer))
+            m_WriteState = WriteState::Idle;
+
+        /// The wait completes with operation_aborted, or the receive with -ECANCELED; OnReadable or OnRingRead
+        /// finishes the move from there
+        if (IsOnRing())
+        {
+            m_IoUring->Cancel(m_RingRead);
+            return true;
+        }
+
+        boost::system::error_code l_ErrorCode;
+        m_Socket.cancel(l_ErrorCode);
+
+        return true;
+    #else
+        UNUSED(p_Service);
+        UNUSED(p_Attach);
+        return false;
+    #endif
+    }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
@@ -95,7 +357,7 @@ namespace SteerStone { namespace Core { namespace Network {
         if (ReadLengthRemaining() < p_Length)
             return false;
 
-        m_InBuffer->Read(p_Buffer, p_Length);
+        m_InBuffer.Read(p_Buffer, p_Length);
 
         return true;
     }
@@ -103,37 +365,207 @@ namespace SteerStone { namespace Core { namespace Network {
     /// @p_Length : The length of the data to skip
     void Socket::ReadSkip(std::size_t const& p_Length)
     {
-        m_InBuffer->Read(nullptr, p_Length);
+        m_InBuffer.Read(nullptr, p_Length);
     }
     /// Write the data to be sent
-    /// @p_Buffer : Buffer which holds the data
-    /// @p_Length : The length of the data
-    void Socket::Write(const char* p_Buffer, std::size_t const& p_Length)
+    /// @p_Buffer    : Buffer which holds the data
+    /// @p_Length    : The length of the data
+    /// @p_Flags     : Write flags, decide what happens to the message while over the outbound limits
+    /// @p_StatusKey : Key of a WriteFlags_Status message, a newer message of the same key replaces it
+    void Socket::Write(const char* p_Buffer, std::size_t const& p_Length, WriteFlags const p_Flags, uint32 const p_StatusKey)
     {
         Utils::ObjectGuard l_Guard(this);
 
-        /// Get the correct buffer depending on the current writing state
-        /// We do this because we don't want to be writing in our buffer while we are sending it out
-        /// it will cause corrupt data
-        /// BOOST_ASIO_ENABLE_BUFFER_DEBUGGING tells us about it
-        PacketBuffer* l_OutBuffer = m_WriteState == WriteState::Sending ? m_SecondaryOutBuffer.get() : m_OutBuffer.get();
+        switch (AdmitWrite(p_Length, p_Flags, p_StatusKey))
+        {
+            case WriteAdmission::Discard:
+                return;
+            case WriteAdmission::Hold:
+                HoldStatus(p_StatusKey, SharedPayload::Create(p_Buffer, p_Length));
+                return;
+            default:
+                break;
+        }
+
+        /// Chunks never move, so it is safe to append while a send is in flight;
+        /// the new data lands past the spans asio is currently sending
+        m_OutQueue.Write(p_Buffer, p_Length);
 
-        /// Write the header
-        m_OutBuffer->Write(p_Buffer, p_Length);
+        m_Counters.MessagesOut.fetch_add(1, std::memory_order_relaxed);
+        m_NetworkCounters->MessagesOut.Add(1);
 
-        /// Flush data if need
-        if (m_WriteState == WriteState::Idle)
-            StartWriteFlushTimer();
+        OnQueued();
+    }
+    /// Queue a shared payload to be sent, without copying it
+    /// @p_Payload   : Payload, may be queued on many sockets
+    /// @p_Flags     : Write flags, decide what happens to the message while over the outbound limits
+    /// @p_StatusKey : Key of a WriteFlags_Status message, a newer message of the same key replaces it
+    void Socket::Write(SharedPayload::Ptr const& p_Payload, WriteFlags const p_Flags, uint32 const p_StatusKey)
+    {
+        if (!p_Payload)
+            return;
+
+        Utils::ObjectGuard l_Guard(this);
+
+        switch (AdmitWrite(p_Payload->GetSize(), p_Flags, p_StatusKey))
+        {
+            case WriteAdmission::Discard:
+                return;
+            case WriteAdmission::Hold:
+                HoldStatus(p_StatusKey, p_Payload);
+                return;
+            default:
+                break;
+        }
+
+        m_OutQueue.Write(p_Payload);
+
+        m_Counters.MessagesOut.fetch_add(1, std::memory_order_relaxed);
+        m_NetworkCounters->MessagesOut.Add(1);
+
+        OnQueued();
     }
     /// Get the total read length of the packet
     std::size_t const Socket::ReadLength()
     {
-        return m_InBuffer->ReadLength();
+        return m_InBuffer.ReadLength();
     }
     /// Get the length remaining to read
     std::size_t const Socket::ReadLengthRemaining()
     {
-        return m_InBuffer->ReadLengthRemaining();
+        return m_InBuffer.ReadLengthRemaining();
+    }
+
+    /// Set our handle in our NetworkThread registry
+    /// @p_Handle : Handle
+    void Socket::SetHandle(SocketHandle const p_Handle)
+    {
+        m_Handle.store(p_Handle, std::memory_order_relaxed);
+    }
+    /// Get our handle in our NetworkThread registry
+    SocketHandle Socket::GetHandle() const
+    {
+        return m_Handle.load(std::memory_order_relaxed);
+    }
+    /// Set the function called when we close, it removes us from our NetworkThread registry
+    /// @p_CloseHandler : Handler
+    void Socket::SetCloseHandler(std::function<void(Socket*)> p_CloseHandler)
+    {
+        m_CloseHandler = std::move(p_CloseHandler);
+    }
+
+    /// Set the policy deciding when buffered output is flushed
+    /// @p_FlushPolicy : Policy, must outlive the socket
+    void Socket::SetFlushPolicy(FlushPolicy const* p_FlushPolicy)
+    {
+        m_FlushPolicy = p_FlushPolicy;
+    }
+    /// Get the time between the first buffered write and its flush, in microseconds
+    Diagnostic::Histogram const& Socket::GetFlushLatency() const
+    {
+        return m_FlushLatency;
+    }
+    /// Set the timing wheel our timers are armed on
+    /// @p_TimingWheel : Wheel of our NetworkThread, must outlive the socket
+    void Socket::SetTimingWheel(TimingWheel* p_TimingWheel)
+    {
+        m_TimingWheel = p_TimingWheel;
+    }
+    /// Set the limits on our unsent data
+    /// @p_Limits   : Limits, must outlive the socket
+    /// @p_Counters : Overflow counters, must outlive the socket
+    void Socket::SetOutboundLimits(OutboundLimits const* p_Limits, OutboundCounters* p_Counters)
+    {
+        m_OutboundLimits    = p_Limits;
+        m_OutboundCounters  = p_Counters;
+    }
+    /// Set the limits on our reads and unhandled data
+    /// @p_Limits : Limits, must outlive the socket
+    void Socket::SetInboundLimits(InboundLimits const* p_Limits)
+    {
+        m_InboundLimits = p_Limits;
+    }
+    /// Set the pool our buffers borrow their storage from, before Open
+    /// @p_Pool : Pool of our NetworkThread
+    void Socket::SetBufferPool(std::shared_ptr<PacketBufferPool> const& p_Pool)
+    {
+        m_BufferPool = p_Pool;
+
+        m_InBuffer.SetPool(m_BufferPool.get());
+        m_OutQueue.SetPool(m_BufferPool.get());
+    }
+    /// Check if our buffers borrow storage right now, our pool cannot change until they hand it back
+    bool Socket::HasBufferStorage() const
+    {
+        return m_InBuffer.HasStorage() || m_OutQueue.HasStorage();
+    }
+    /// Set the counters of our NetworkThread, bumped next to our own
+    /// @p_Counters : Counters, must outlive the socket
+    void Socket::SetNetworkCounters(NetworkCounters* p_Counters)
+    {
+        m_NetworkCounters = p_Counters;
+        m_HandlerAllocator.SetHeapCounter(&p_Counters->HandlerHeapAllocs);
+    }
+    /// Get a copy of our counters
+    SocketCountersSnapshot Socket::GetCounters() const
+    {
+        SocketCountersSnapshot l_Snapshot;
+        l_Snapshot.Handle           = m_Handle.load(std::memory_order_relaxed);
+        l_Snapshot.SessionId        = m_SessionId.load(std::memory_order_relaxed);
+        l_Snapshot.Address          = m_AddressSet.load(std::memory_order_acquire) ? m_Address : std::string();
+        l_Snapshot.BytesIn          = m_Counters.BytesIn.load(std::memory_order_relaxed);
+        l_Snapshot.MessagesIn       = m_Counters.MessagesIn.load(std::memory_order_relaxed);
+        l_Snapshot.BytesOut         = m_Counters.BytesOut.load(std::memory_order_relaxed);
+        l_Snapshot.MessagesOut      = m_Counters.MessagesOut.load(std::memory_order_relaxed);
+        l_Snapshot.ReadCalls        = m_Counters.ReadCalls.load(std::memory_order_relaxed);
+        l_Snapshot.WriteCalls       = m_Counters.WriteCalls.load(std::memory_order_relaxed);
+        l_Snapshot.PartialWrites    = m_Counters.PartialWrites.load(std::memory_order_relaxed);
+        l_Snapshot.BufferGrows      = m_Counters.BufferGrows.load(std::memory_order_relaxed);
+        l_Snapshot.ReadPauses       = m_Counters.ReadPauses.load(std::memory_order_relaxed);
+        l_Snapshot.Queued           = m_OutQueue.GetQueuedSize();
+
+        return l_Snapshot;
+    }
+    /// Set the ring our reads and writes run on, before Open; TLS connections stay on the reactor
+    /// @p_IoUring : Ring of our NetworkThread, null for the reactor, must outlive the socket
+    void Socket::SetIoUring(IoUring* p_IoUring)
+    {
+        m_IoUring = p_IoUring;
+    }
+    /// Set the queue our frames are handed to the game tick through
+    /// @p_Queue : Queue of our NetworkThread, must outlive the socket
+    void Socket::SetInboundQueue(InboundQueue* p_Queue)
+    {
+        m_InboundQueue = p_Queue;
+    }
+
+    /// Get our session, kept across a hot restart
+    uint64 Socket::GetSessionId() const
+    {
+        return m_SessionId.load(std::memory_order_relaxed);
+    }
+
+    /// Wrap the connection in TLS, before Open
+    /// @p_Context : Context of our Listener, null for plaintext
+    void Socket::SetTlsContext(TlsContext const* p_Context)
+    {
+        m_TlsContext = p_Context;
+    }
+    /// Check if the connection is wrapped in TLS
+    bool Socket::IsTls() const
+    {
+        return m_Tls != nullptr;
+    }
+    /// Accept WebSocket clients next to raw ones, before Open
+    /// @p_Enable : Detect the transport from the first bytes the client sends
+    void Socket::SetWebSocket(bool const p_Enable)
+    {
+        m_Transport = p_Enable ? SocketTransport::Detecting : SocketTransport::Raw;
+    }
+    /// Get the transport the client talks to us over
+    SocketTransport Socket::GetTransport() const
+    {
+        return m_Transport;
     }
 
     /// Get our AsioSocket
@@ -158,21 +590,81 @@ namespace SteerStone { namespace Core { namespace Network {
     /// Get the current read position
     uint8 const* Socket::InPeak()
     {
-        return &m_InBuffer->m_Buffer[m_InBuffer->m_ReadPosition];
+        return m_InBuffer.m_Storage + m_InBuffer.m_ReadPosition;
     }
     /// ForceFlushOut - Send our current data in our buffer
     /// If the write state is idle, this will do nothing, which is correct
     /// If the write state is sending, this will do nothing, which is correct
-    /// If the write state is buffering, this will cancel the running timer, which will immediately trigger FlushOut()
+    /// If the write state is buffering, this will cancel the running timer and trigger FlushOut() instead
     void Socket::ForceFlushOut()
     {
-        m_OutBufferFlushTimer.cancel();
+        if (!m_TimingWheel)
+            return;
+
+        /// The wheel belongs to our NetworkThread; always post, our caller may hold our lock
+        /// and FlushOut takes it again
+        std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+        Post([l_Ptr]()
+        {
+            if (l_Ptr->m_TimingWheel->Cancel(l_Ptr->m_OutBufferFlushTimer))
+                l_Ptr->FlushOut();
+        });
+    }
+    /// Count frames handled by ProcessIncomingData
+    /// @p_Count : Amount of frames
+    void Socket::CountMessagesIn(uint32 const p_Count)
+    {
+        m_Counters.MessagesIn.fetch_add(p_Count, std::memory_order_relaxed);
+        m_NetworkCounters->MessagesIn.Add(p_Count);
+    }
+    /// Copy a frame into our inbound queue
+    /// @p_Frame : Frame body
+    InboundResult Socket::QueueInbound(FrameView const& p_Frame)
+    {
+        if (!m_InboundQueue)
+            return InboundResult::NoQueue;
+
+        /// Counted first, the game tick may handle the frame before Push returns
+        m_InboundFrames.fetch_add(1, std::memory_order_relaxed);
+        m_InboundBytes.fetch_add(p_Frame.GetSize(), std::memory_order_relaxed);
+
+        if (!m_InboundQueue->Push(shared_from_this(), p_Frame))
+        {
+            m_InboundFrames.fetch_sub(1, std::memory_order_relaxed);
+            m_InboundBytes.fetch_sub(p_Frame.GetSize(), std::memory_order_relaxed);
+
+            LOG_WARNING("Socket", "Inbound queue is full, disconnecting client %0", m_Address);
+            return InboundResult::Full;
+        }
+
+        return InboundResult::Queued;
+    }
+    /// One of our queued frames was handled, from the game tick only
+    /// @p_Size : Size of the frame
+    void Socket::OnInboundHandled(std::size_t const p_Size)
+    {
+        const uint32 l_Frames       = m_InboundFrames.fetch_sub(1) - 1;
+        const std::size_t l_Bytes   = m_InboundBytes.fetch_sub(p_Size) - p_Size;
+
+        /// m_Resume* were set before m_ReadPaused, only the one who clears it resumes our reads
+        if (!m_ReadPaused.load())
+            return;
+
+        if (l_Frames > m_ResumeFrames.load(std::memory_order_relaxed) || l_Bytes > m_ResumeBytes.load(std::memory_order_relaxed))
+            return;
+
+        if (!m_ReadPaused.exchange(false))
+            return;
+
+        std::shared_ptr<Socket> l_Ptr = shared_from_this();
+        Post([l_Ptr]() { l_Ptr->ResumeRead(); });
     }
 
     //////////////////////////////////////////////////////////////////////////
     //////////////////////////////////////////////////////////////////////////
 
-    /// Read incoming packets
+    /// Wait until incoming packets are ready to be read
+    /// Nothing is lent to the kernel while we wait, so an idle connection holds no in buffer
     void Socket::StartAsyncRead()
     {
         if (IsClosed())
@@ -183,123 +675,750 @@ namespace SteerStone { namespace Core { namespace Network {
 
         std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
         m_ReadState = ReadState::Reading;
-        m_Socket.async_read_some(boost::asio::buffer(&m_InBuffer->m_Buffer[m_InBuffer->m_WritePosition], m_InBuffer->m_Buffer.size() - m_InBuffer->m_WritePosition),
-            make_custom_alloc_handler(m_allocator,
-                [l_Ptr](boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length) { l_Ptr->OnRead(p_ErrorCode, p_Length); }));
+
+        /// One receive serves every read until it ends, one still armed (e.g while being cancelled) is armed again when it does
+        if (IsOnRing())
+        {
+            if (!m_RingRead.IsPending() && !m_IoUring->ReceiveMultishot(m_RingRead, m_Socket.native_handle(), l_Ptr))
+            {
+                m_ReadState = ReadState::Idle;
+                OnError(boost::asio::error::no_buffer_space);
+            }
+
+            return;
+        }
+
+        m_Socket.async_wait(boost::asio::ip::tcp::socket::wait_read,
+            MakeAllocHandler(m_HandlerAllocator, HandlerSlot_Read,
+                [l_Ptr](boost::system::error_code const& p_ErrorCode) { l_Ptr->OnReadable(p_ErrorCode); }));
     }
-    /// OnRead - Handle the incoming packet
-    /// @p_Error : Error code
-    /// @p_Length : Length of failed buffer
-    void Socket::OnRead(const boost::system::error_code& p_ErrorCode, const std::size_t& p_Length)
+    /// Read what the kernel has ready into our in buffer, a burst of reads at most
+    /// Frames are handled after every read, so we never hold more than a partial frame and one read;
+    /// whatever the burst leaves in the kernel wakes our next wait straight away
+    /// @p_Error : Error code of the wait
+    void Socket::OnReadable(boost::system::error_code const& p_ErrorCode)
     {
-        if (p_ErrorCode)
+        /// Our wait came back to let us move, whatever it says the data waits for us in the kernel
+        if (m_MigrationService)
         {
-            m_ReadState = ReadState::Idle;
-            OnError(p_ErrorCode);
+            FinishMigration();
             return;
         }
 
-        if (IsClosed())
+        if (p_ErrorCode)
         {
             m_ReadState = ReadState::Idle;
+            OnError(p_ErrorCode);
             return;
         }
 
-        m_InBuffer->m_WritePosition += p_Length;
-
-        const size_t l_Available = m_Socket.available();
-
-        /// If there is still data to read, increase the buffer size and do so (if necessary)
-        if (l_Available > 0 && (p_Length + l_Available) > m_InBuffer->m_Buffer.size())
-        {
-            m_InBuffer->m_Buffer.resize(m_InBuffer->m_Buffer.size() + l_Available);
-            StartAsyncRead();
+        /// The handshake reads and writes on its own, frames only flow once it is done
+        if (m_Tls && !m_Tls->IsEstablished() && !ContinueTlsHandshake())
             return;
-        }
 
-        ProcessState l_ProcessState = ProcessIncomingData();
+        const uint32 l_Burst = std::max<uint32>(m_InboundLimits->ReadBurst, 1);
 
-        if (l_ProcessState != ProcessState::Successful)
+        for (uint32 l_Read = 0; l_Read < l_Burst; l_Read++)
         {
-            if (l_ProcessState == ProcessState::Skip)
+            if (IsClosed())
             {
-                /// Reset buffer
-                m_InBuffer->m_WritePosition = 0;
-                m_InBuffer->m_ReadPosition = 0;
-
-                StartAsyncRead();
+                m_ReadState = ReadState::Idle;
+                return;
             }
-            else
+
+            const std::size_t l_Space = ReserveRead();
+            if (!l_Space)
+                return;
+
+            boost::system::error_code l_ErrorCode;
+            const std::size_t l_Length = m_Tls ? m_Tls->Read(m_InBuffer.m_Storage + m_InBuffer.m_WritePosition, l_Space, l_ErrorCode)
+                : m_Socket.read_some(boost::asio::buffer(m_InBuffer.m_Storage + m_InBuffer.m_WritePosition, l_Space), l_ErrorCode);
+
+            m_Counters.ReadCalls.fetch_add(1, std::memory_order_relaxed);
+            m_NetworkCounters->ReadCalls.Add(1);
+
+            /// Nothing left, or a spurious wakeup
+            if (l_ErrorCode == boost::asio::error::would_block || l_ErrorCode == boost::asio::error::try_again)
+                break;
+
+            if (l_ErrorCode)
             {
-                /// Bad data read - close down socket
-                if (!IsClosed())
-                    CloseSocket();
+                m_ReadState = ReadState::Idle;
+                OnError(l_ErrorCode);
+                return;
             }
+
+            if (!OnRead(l_Length))
+                return;
+
+            /// Leave the rest in the kernel, TCP pushes back on the client
+            if (IsInboundFull())
+                break;
+
+            /// The kernel had less than we asked for, do not spend a syscall to hear it is empty;
+            /// TLS hands out one record per read, only would_block tells it is empty
+            if (l_Length < l_Space && !m_Tls)
+                break;
         }
 
-        /// Reset buffer
-        m_InBuffer->m_WritePosition = 0;
-        m_InBuffer->m_ReadPosition = 0;
+        /// Every frame was handled, hand the storage back until more data arrives
+        m_InBuffer.Release();
+
+        /// The game tick is behind on our frames, it resumes our reads once it caught up
+        if (PauseRead())
+            return;
+
+        /// Decrypted bytes left inside OpenSSL never wake our wait
+        if (m_Tls && m_Tls->GetPending())
+        {
+            std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+            boost::asio::post(m_Socket.get_executor(), MakeAllocHandler(m_HandlerAllocator, HandlerSlot_Read,
+                [l_Ptr]() { l_Ptr->OnReadable(boost::system::error_code()); }));
+            return;
+        }
 
         StartAsyncRead();
     }
-    /// OnWriteComplete - Finished sending out our buffer
-    /// @p_Error : Error code
-    /// @p_Length : Length of failed buffer
-    void Socket::OnWriteComplete(boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length)
+    /// Check if our reads and writes run on the ring of our NetworkThread
+    bool Socket::IsOnRing() const
     {
-        /// We must check this before locking the mutex because the connection will be closed,
-        /// which leads to a locked mutex being destroyed.  not good!
-        if (p_ErrorCode)
+        return m_IoUring && !m_Tls;
+    }
+    /// Completion of our multishot receive
+    /// Bytes come in a buffer the kernel picked from the ring of our NetworkThread, so an idle connection holds no
+    /// storage at all; every completion but the last leaves the receive armed
+    /// @p_Result : Bytes received, 0 at end of stream or -errno
+    /// @p_Flags  : Flags of the completion, carry the ring buffer
+    void Socket::OnRingRead(int32 const p_Result, uint32 const p_Flags)
+    {
+        if (p_Result > 0 && !OnRingReceive(p_Flags, static_cast<std::size_t>(p_Result)))
+            return;
+
+        if (IoUring::IsArmed(p_Flags))
+            return;
+
+        /// Our receive ended to let us move, whatever came after it waits for us in the kernel
+        if (m_MigrationService)
         {
-            OnError(p_ErrorCode);
+            FinishMigration();
             return;
         }
 
         if (IsClosed())
         {
-            m_WriteState = WriteState::Idle;
+            m_ReadState = ReadState::Idle;
             return;
         }
 
-        Utils::ObjectGuard l_Guard(this);
-
-        LOG_ASSERT(m_WriteState == WriteState::Sending, "Socket", "Flushed out packet, but write state is not set to sending!");
-        LOG_ASSERT(p_Length <= m_OutBuffer->m_WritePosition, "Socket", "Sent length is more than OutBuffer length!");
-
-        /// If there is data left to write, move it to the start of the buffer
-        if (p_Length < m_OutBuffer->m_WritePosition)
+        if (!p_Result)
         {
-            memcpy(&(m_OutBuffer->m_Buffer[0]), &(m_OutBuffer->m_Buffer[p_Length]), (m_OutBuffer->m_WritePosition - p_Length) * sizeof(m_OutBuffer->m_Buffer[0]));
-            m_OutBuffer->m_WritePosition -= p_Length;
+            m_ReadState = ReadState::Idle;
+            OnError(boost::asio::error::eof);
+            return;
         }
-        /// If not, reset the write pointer
-        else
-            m_OutBuffer->m_WritePosition = 0;
 
-        /// If there is data in the secondary buffer, append it to the primary buffer
-        if (m_SecondaryOutBuffer->m_WritePosition > 0)
+        /// Cancelled or out of ring buffers, the data waits in the kernel
+        if (p_Result < 0 && p_Result != -ECANCELED && p_Result != -ENOBUFS)
         {
-            /// Do we have enough space? if not, resize
-            if (m_OutBuffer->m_Buffer.size() < (m_OutBuffer->m_WritePosition + m_SecondaryOutBuffer->m_WritePosition))
-                m_OutBuffer->m_Buffer.resize(m_OutBuffer->m_WritePosition + m_SecondaryOutBuffer->m_WritePosition);
-
-            memcpy(&(m_OutBuffer->m_Buffer[m_OutBuffer->m_WritePosition]), &(m_SecondaryOutBuffer->m_Buffer[0]), (m_SecondaryOutBuffer->m_WritePosition) * sizeof(m_SecondaryOutBuffer->m_Buffer[0]));
-
-            m_OutBuffer->m_WritePosition += m_SecondaryOutBuffer->m_WritePosition;
-            m_SecondaryOutBuffer->m_WritePosition = 0;
+            m_ReadState = ReadState::Idle;
+            OnError(boost::system::error_code(-p_Result, boost::system::system_category()));
+            return;
         }
 
-        /// If there is any data to write, do so immediately
-        if (m_OutBuffer->m_WritePosition > 0)
-        {
-            std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
-            m_Socket.async_write_some(boost::asio::buffer(m_OutBuffer->m_Buffer, m_OutBuffer->m_WritePosition),
-                make_custom_alloc_handler(m_allocator,
-                    [l_Ptr](boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length) { l_Ptr->OnWriteComplete(p_ErrorCode, p_Length); }));
+        /// Idle if we paused or are being detached meanwhile
+        if (m_ReadState == ReadState::Reading)
+            StartAsyncRead();
+    }
+    /// Copy a receive out of its ring buffer and handle it, false once we are closed or stopped receiving
+    /// The buffer goes back to the ring straight away, frames are handled from our in buffer like any read
+    /// @p_Flags  : Flags of the completion
+    /// @p_Length : Bytes received
+    bool Socket::OnRingReceive(uint32 const p_Flags, std::size_t const p_Length)
+    {
+        uint8 const* l_Data = m_IoUring->GetBuffer(p_Flags);
+
+        m_Counters.ReadCalls.fetch_add(1, std::memory_order_relaxed);
+        m_NetworkCounters->ReadCalls.Add(1);
+
+        bool l_Open = true;
+
+        for (std::size_t l_Offset = 0; l_Open && l_Offset < p_Length;)
+        {
+            const std::size_t l_Space = ReserveRead();
+            if (!l_Space)
+            {
+                l_Open = false;
+                break;
+            }
+
+            const std::size_t l_Length = std::min(l_Space, p_Length - l_Offset);
+            memcpy(m_InBuffer.m_Storage + m_InBuffer.m_WritePosition, l_Data + l_Offset, l_Length);
+            l_Offset += l_Length;
+
+            l_Open = OnRead(l_Length);
+        }
+
+        m_IoUring->RecycleBuffer(p_Flags);
+
+        if (!l_Open)
+            return false;
+
+        /// Every frame was handled, hand the storage back until more data arrives
+        m_InBuffer.Release();
+
+        /// The game tick is behind on our frames, stop receiving; it resumes our reads once it caught up
+        if (m_ReadState == ReadState::Reading && IsInboundFull())
+        {
+            if (PauseRead())
+            {
+                m_IoUring->Cancel(m_RingRead);
+                return false;
+            }
+
+            /// It caught up meanwhile, PauseRead left us idle
+            m_ReadState = ReadState::Reading;
+        }
+
+        return true;
+    }
+    /// Check if we hold as many frames waiting for the game tick as we may
+    bool Socket::IsInboundFull() const
+    {
+        if (m_InboundLimits->MaxQueuedFrames && m_InboundFrames.load(std::memory_order_relaxed) >= m_InboundLimits->MaxQueuedFrames)
+            return true;
+
+        return m_InboundLimits->MaxQueuedBytes && m_InboundBytes.load(std::memory_order_relaxed) >= m_InboundLimits->MaxQueuedBytes;
+    }
+    /// Stop reading while the game tick is behind on our frames, false if it caught up meanwhile
+    /// No read wait is left behind, so we cannot migrate until we resume
+    bool Socket::PauseRead()
+    {
+        if (!IsInboundFull())
+            return false;
+
+        /// Resume once half of them were handled, so we do not pause again on the next read
+        const uint32 l_ResumeFrames     = m_InboundLimits->MaxQueuedFrames ? m_InboundLimits->MaxQueuedFrames / 2 : std::numeric_limits<uint32>::max();
+        const std::size_t l_ResumeBytes = m_InboundLimits->MaxQueuedBytes ? m_InboundLimits->MaxQueuedBytes / 2 : std::numeric_limits<std::size_t>::max();
+
+        m_ResumeFrames.store(l_ResumeFrames, std::memory_order_relaxed);
+        m_ResumeBytes.store(l_ResumeBytes, std::memory_order_relaxed);
+
+        m_ReadState = ReadState::Idle;
+        m_ReadPaused.store(true);
+
+        m_Counters.ReadPauses.fetch_add(1, std::memory_order_relaxed);
+        m_NetworkCounters->ReadPauses.Add(1);
+
+        /// The game tick may have handled them before it could see us paused
+        if (m_InboundFrames.load() > l_ResumeFrames || m_InboundBytes.load() > l_ResumeBytes)
+            return true;
+
+        /// Already cleared, the game tick posted our resume
+        return !m_ReadPaused.exchange(false);
+    }
+    /// Start reading again once the game tick handled our frames, from our NetworkThread
+    void Socket::ResumeRead()
+    {
+        if (IsClosed())
+            return;
+
+        /// Decrypted bytes left inside OpenSSL never wake our wait
+        if (m_Tls && m_Tls->GetPending())
+        {
+            OnReadable(boost::system::error_code());
+            return;
+        }
+
+        StartAsyncRead();
+    }
+    /// Make progress on our TLS handshake, true once it completed
+    bool Socket::ContinueTlsHandshake()
+    {
+        switch (m_Tls->Handshake())
+        {
+            case TlsHandshake::Complete:
+                break;
+            case TlsHandshake::WantRead:
+                StartAsyncRead();
+                return false;
+            case TlsHandshake::WantWrite:
+            {
+                /// Our flight did not fit in the socket buffer, carry on once there is room
+                std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+                m_ReadState = ReadState::Reading;
+                m_Socket.async_wait(boost::asio::ip::tcp::socket::wait_write,
+                    MakeAllocHandler(m_HandlerAllocator, HandlerSlot_Read,
+                        [l_Ptr](boost::system::error_code const& p_ErrorCode) { l_Ptr->OnReadable(p_ErrorCode); }));
+                return false;
+            }
+            default:
+                LOG_WARNING("Socket", "TLS handshake with client %0 failed: %1", m_Address, TlsContext::GetLastError());
+                CloseSocket();
+                m_ReadState = ReadState::Idle;
+                return false;
+        }
+
+        m_NetworkCounters->TlsHandshakes.Add(1);
+
+        if (m_Tls->IsResumed())
+            m_NetworkCounters->TlsResumed.Add(1);
+
+        if (m_Tls->IsKernelSend())
+            m_NetworkCounters->TlsKernelSend.Add(1);
+
+        Utils::ObjectGuard l_Guard(this);
+
+        /// Output held while we had no keys
+        if (m_OutQueue.GetSize() && m_WriteState == WriteState::Idle)
+            OnQueued();
+
+        return true;
+    }
+    /// Move our descriptor to the service we migrate to, from our old NetworkThread once our read wait came back
+    /// No read or write of ours is in flight here, so asio holds nothing of ours on the old service
+    void Socket::FinishMigration()
+    {
+    #ifdef NETWORK_HAS_MIGRATION
+        Utils::ObjectGuard l_Guard(this);
+
+        boost::asio::io_service* l_Service = m_MigrationService;
+        std::function<void(Socket*)> l_Attach = std::move(m_MigrationAttach);
+
+        m_MigrationService = nullptr;
+        m_MigrationAttach  = nullptr;
+
+        /// Closed while the wait was coming back, our close handler already removed us
+        if (IsClosed())
+        {
+            m_ReadState = ReadState::Idle;
+            return;
+        }
+
+        /// A flush armed after the move started is armed again on the new wheel; one already posted follows us
+        if (m_WriteState == WriteState::Buffering && m_TimingWheel && m_TimingWheel->Cancel(m_OutBufferFlushTimer))
+            m_WriteState = WriteState::Idle;
+
+        boost::system::error_code l_ErrorCode;
+        const boost::asio::ip::tcp l_Protocol = m_Socket.local_endpoint(l_ErrorCode).protocol();
+
+        int l_Fd = -1;
+        if (!l_ErrorCode)
+            l_Fd = m_Socket.release(l_ErrorCode);
+
+        boost::asio::ip::tcp::socket l_Socket(*l_Service);
+
+        if (!l_ErrorCode)
+            l_Socket.assign(l_Protocol, l_Fd, l_ErrorCode);
+
+        if (l_ErrorCode)
+        {
+            LOG_ERROR("Socket", "Failed to move socket of client %0 to another NetworkThread: %1", m_Address, l_ErrorCode.message());
+
+            /// Released but not assigned, nobody owns the descriptor
+            if (l_Fd != -1)
+                ::close(l_Fd);
+
+            m_Socket.close(l_ErrorCode);
+            m_ReadState = ReadState::Idle;
+
+            /// CloseSocket without taking our lock again
+            if (m_CloseHandler)
+                m_CloseHandler(this);
+
+            return;
+        }
+
+        m_Socket = std::move(l_Socket);
+
+        /// Attach to our new NetworkThread before publishing its service, whoever reads
+        /// the new service must find us already attached to it
+        if (l_Attach)
+            l_Attach(this);
+
+        m_Service.store(l_Service, std::memory_order_release);
+
+        std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+        boost::asio::post(*l_Service, [l_Ptr]() { l_Ptr->OnMigrated(); });
+    #endif
+    }
+    /// Start reading and flushing again, from our new NetworkThread
+    void Socket::OnMigrated()
+    {
+        {
+            Utils::ObjectGuard l_Guard(this);
+
+            /// Output held or queued while we moved
+            if (m_WriteState == WriteState::Idle && (m_OutQueue.GetSize() || (m_WebSocket && m_WebSocket->HasOutput())))
+                OnQueued();
+        }
+
+        /// Decrypted bytes left inside OpenSSL never wake our wait
+        if (m_Tls && m_Tls->GetPending())
+        {
+            OnReadable(boost::system::error_code());
+            return;
+        }
+
+        StartAsyncRead();
+    }
+    /// Make room for the next read, returns the space to read into, 0 once a frame does not fit in our inbound limits
+    std::size_t Socket::ReserveRead()
+    {
+        /// Unhandled bytes are the start of a frame, compacted to the front of our storage
+        const std::size_t l_Unhandled = m_InBuffer.m_WritePosition;
+
+        if (l_Unhandled >= m_InboundLimits->MaxBytes)
+        {
+            LOG_WARNING("Socket", "Client %0 sent a frame larger than %1 bytes, disconnecting", m_Address, m_InboundLimits->MaxBytes);
+            m_NetworkCounters->InboundOverflows.Add(1);
+
+            CloseSocket();
+            m_ReadState = ReadState::Idle;
+            return 0;
+        }
+
+        const std::size_t l_Wanted = l_Unhandled + std::max<std::size_t>(m_InboundLimits->ReadChunk, 1);
+
+        /// Storage only grows past a chunk to fit a frame which arrives in pieces
+        if (m_InBuffer.m_Capacity && l_Wanted > m_InBuffer.m_Capacity)
+        {
+            m_Counters.BufferGrows.fetch_add(1, std::memory_order_relaxed);
+            m_NetworkCounters->BufferGrows.Add(1);
+        }
+
+        m_InBuffer.Reserve(l_Wanted);
+
+        return std::min<std::size_t>(m_InBuffer.m_Capacity, m_InboundLimits->MaxBytes) - l_Unhandled;
+    }
+    /// Handle the frames completed by a read, false once we are closed
+    /// @p_Length : Length read
+    bool Socket::OnRead(std::size_t const p_Length)
+    {
+        const std::size_t l_Start = m_InBuffer.m_WritePosition;
+        m_InBuffer.m_WritePosition += p_Length;
+
+        m_Counters.BytesIn.fetch_add(p_Length, std::memory_order_relaxed);
+        m_NetworkCounters->BytesIn.Add(p_Length);
+
+        ProcessState l_ProcessState = ProcessState::Successful;
+
+        if (m_Transport != SocketTransport::Raw)
+        {
+            l_ProcessState = ReadTransport(l_Start);
+
+            /// Upgrade request has not fully arrived, keep it as it is
+            if (l_ProcessState == ProcessState::Skip)
+                return true;
+        }
+
+        if (l_ProcessState == ProcessState::Successful)
+            l_ProcessState = ProcessIncomingData();
+
+        if (l_ProcessState == ProcessState::Error)
+        {
+            /// Bad data read - close down socket
+            if (!IsClosed())
+                CloseSocket();
+
+            m_ReadState = ReadState::Idle;
+            return false;
+        }
+
+        if (l_ProcessState == ProcessState::Skip)
+        {
+            /// Drop everything we have, including any partial frame
+            m_InBuffer.m_WritePosition = 0;
+            m_InBuffer.m_ReadPosition = 0;
         }
         else
+        {
+            /// Keep the partial frame (if any) for the next read
+            m_InBuffer.Compact();
+        }
+
+        return true;
+    }
+    /// Turn bytes just read into the game byte stream, Skip while an upgrade request has not fully arrived
+    /// WebSocket payloads are unmasked in place over the frame headers, so the in buffer only ever holds
+    /// game frames and ProcessIncomingData does not know which transport they came over
+    /// @p_Start : Position of the bytes just read in our in buffer
+    ProcessState Socket::ReadTransport(std::size_t p_Start)
+    {
+        Utils::ObjectGuard l_Guard(this);
+
+        switch (m_Transport)
+        {
+            case SocketTransport::Detecting:
+            {
+                if (!WebSocket::IsUpgradeRequest(InPeak(), ReadLengthRemaining()))
+                {
+                    m_Transport = SocketTransport::Raw;
+
+                    /// Output held while we did not know how to frame it
+                    if (m_OutQueue.GetSize() && m_WriteState == WriteState::Idle)
+                        OnQueued();
+
+                    return ProcessState::Successful;
+                }
+
+                if (ReadLengthRemaining() < WEBSOCKET_UPGRADE_METHOD_SIZE)
+                    return ProcessState::Skip;
+
+                m_WebSocket.reset(new WebSocket());
+                m_Transport = SocketTransport::Handshake;
+            }
+            [[fallthrough]];
+            case SocketTransport::Handshake:
+            {
+                std::string l_Response;
+                std::size_t l_Consumed = 0;
+
+                switch (WebSocket::ParseHandshake(InPeak(), ReadLengthRemaining(), l_Response, l_Consumed))
+                {
+                    case WebSocketHandshake::Incomplete:
+                        if (ReadLengthRemaining() < WEBSOCKET_MAX_HANDSHAKE_SIZE)
+                            return ProcessState::Skip;
+
+                        LOG_WARNING("Socket", "Client %0 sent an upgrade request larger than %1 bytes, closing", m_Address, WEBSOCKET_MAX_HANDSHAKE_SIZE);
+                        return ProcessState::Error;
+                    case WebSocketHandshake::Rejected:
+                        LOG_WARNING("Socket", "Client %0 sent an invalid WebSocket upgrade request, closing", m_Address);
+                        return ProcessState::Error;
+                    default:
+                        break;
+                }
+
+                /// Our response goes out as it is, ahead of the first frame
+                m_WebSocket->QueueRaw(reinterpret_cast<uint8 const*>(l_Response.data()), l_Response.size());
+                m_Transport = SocketTransport::WebSocket;
+
+                if (m_WriteState == WriteState::Idle)
+                    OnQueued();
+
+                /// Frames sent right behind the request
+                ReadSkip(l_Consumed);
+                p_Start = m_InBuffer.m_ReadPosition;
+            }
+            [[fallthrough]];
+            case SocketTransport::WebSocket:
+            {
+                std::size_t l_Payload = 0;
+                const WebSocketDecode l_Decode = m_WebSocket->Decode(m_InBuffer.m_Storage + p_Start, m_InBuffer.m_WritePosition - p_Start, l_Payload);
+                m_InBuffer.m_WritePosition = p_Start + l_Payload;
+
+                /// Pong or close reply
+                if (m_WebSocket->HasOutput() && m_WriteState == WriteState::Idle)
+                    OnQueued();
+
+                if (l_Decode == WebSocketDecode::Error)
+                {
+                    LOG_WARNING("Socket", "Client %0 broke the WebSocket protocol, closing", m_Address);
+                    return ProcessState::Error;
+                }
+
+                return ProcessState::Successful;
+            }
+            default:
+                return ProcessState::Successful;
+        }
+    }
+    /// OnWriteComplete - Finished sending out our buffer
+    /// @p_Error : Error code
+    /// @p_Length : Length of failed buffer
+    void Socket::OnWriteComplete(boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length)
+    {
+        /// We must check this before locking the mutex because the connection will be closed,
+        /// which leads to a locked mutex being destroyed.  not good!
+        if (p_ErrorCode)
+        {
+            OnError(p_ErrorCode);
+            return;
+        }
+
+        if (IsClosed())
+        {
+            m_WriteState = WriteState::Idle;
+            return;
+        }
+
+        Utils::ObjectGuard l_Guard(this);
+
+        LOG_ASSERT(m_WriteState == WriteState::Sending, "Socket", "Flushed out packet, but write state is not set to sending!");
+        LOG_ASSERT(p_Length <= m_SendSize, "Socket", "Sent length is more than we handed to the write!");
+
+        m_Counters.WriteCalls.fetch_add(1, std::memory_order_relaxed);
+        m_Counters.BytesOut.fetch_add(p_Length, std::memory_order_relaxed);
+        m_NetworkCounters->WriteCalls.Add(1);
+        m_NetworkCounters->BytesOut.Add(p_Length);
+
+        /// The kernel took less than we gave it, the rest goes out in the next write
+        if (p_Length < m_SendSize)
+        {
+            m_Counters.PartialWrites.fetch_add(1, std::memory_order_relaxed);
+            m_NetworkCounters->PartialWrites.Add(1);
+        }
+
+        /// Drop what was sent, anything left stays where it is; WebSocket headers and control frames are not in our queue
+        m_OutQueue.Consume(m_WebSocket ? m_WebSocket->Consume(p_Length) : p_Length);
+
+        /// Our close reply is out and nothing may follow it, close from outside our lock
+        if (m_WebSocket && m_WebSocket->IsClosing() && !m_WebSocket->HasOutput())
+        {
             m_WriteState = WriteState::Idle;
+
+            std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+            Post([l_Ptr]() { l_Ptr->CloseSocket(); });
+            return;
+        }
+
+        /// Room again, status messages held back while the client was slow go out now
+        if (!m_HeldStatus.empty())
+            QueueHeldStatus();
+
+        /// Messages queued while we were sending go out in the next gather write
+        if (m_OutQueue.GetSize() > 0 || (m_WebSocket && m_WebSocket->HasOutput()))
+            StartAsyncWrite();
+        else
+        {
+            /// Let the kernel push out whatever it held back
+            if (m_FlushPolicy->Cork)
+                SetCork(false);
+
+            /// Nothing queued, hand the chunks back to our pool
+            m_OutQueue.Release();
+
+            m_WriteState = WriteState::Idle;
+        }
+    }
+    /// Check a write against our outbound limits
+    /// @p_Length    : The length of the data
+    /// @p_Flags     : Write flags
+    /// @p_StatusKey : Status key
+    WriteAdmission Socket::AdmitWrite(std::size_t const p_Length, WriteFlags const p_Flags, uint32 const p_StatusKey)
+    {
+        /// Nothing may follow our WebSocket close reply
+        if (m_Evicted || (m_WebSocket && m_WebSocket->IsClosing()))
+            return WriteAdmission::Discard;
+
+        /// An older status of this key is already held, the new one replaces it so they never go out of order
+        if ((p_Flags & WriteFlags_Status) && !(p_Flags & WriteFlags_Critical))
+        {
+            for (auto const& l_Held : m_HeldStatus)
+                if (l_Held.first == p_StatusKey)
+                    return WriteAdmission::Hold;
+        }
+
+        const std::size_t l_Size = m_OutQueue.GetSize() + p_Length;
+
+        if (l_Size <= m_OutboundLimits->MaxBytes && m_OutQueue.GetMessageCount() < m_OutboundLimits->MaxMessages)
+            return WriteAdmission::Queue;
+
+        if (m_OutboundLimits->Mode == OverflowMode::Disconnect)
+        {
+            Evict();
+            return WriteAdmission::Discard;
+        }
+
+        /// Critical messages are allowed some slack, a client which cannot take even those is gone
+        if (p_Flags & WriteFlags_Critical)
+        {
+            if (l_Size <= static_cast<std::size_t>(m_OutboundLimits->MaxBytes) * 2)
+                return WriteAdmission::Queue;
+
+            Evict();
+            return WriteAdmission::Discard;
+        }
+
+        if (m_OutboundLimits->Mode == OverflowMode::Coalesce && (p_Flags & WriteFlags_Status))
+            return WriteAdmission::Hold;
+
+        m_OutboundCounters->Dropped.fetch_add(1, std::memory_order_relaxed);
+        return WriteAdmission::Discard;
+    }
+    /// Queue the message a PacketWriter serialized in place, our lock must be held
+    /// @p_Flags     : Write flags
+    /// @p_StatusKey : Status key
+    void Socket::CommitInPlace(WriteFlags const p_Flags, uint32 const p_StatusKey)
+    {
+        switch (AdmitWrite(m_OutQueue.GetPendingSize(), p_Flags, p_StatusKey))
+        {
+            case WriteAdmission::Discard:
+                m_OutQueue.DropPending();
+                return;
+            case WriteAdmission::Hold:
+                HoldStatus(p_StatusKey, m_OutQueue.DetachPending());
+                return;
+            default:
+                break;
+        }
+
+        m_OutQueue.EndPending();
+
+        m_Counters.MessagesOut.fetch_add(1, std::memory_order_relaxed);
+        m_NetworkCounters->MessagesOut.Add(1);
+
+        OnQueued();
+    }
+    /// Hold a status message aside until the queue drains, replacing an older one of the same key
+    /// @p_StatusKey : Status key
+    /// @p_Payload   : Message
+    void Socket::HoldStatus(uint32 const p_StatusKey, SharedPayload::Ptr const& p_Payload)
+    {
+        for (auto& l_Held : m_HeldStatus)
+        {
+            if (l_Held.first != p_StatusKey)
+                continue;
+
+            l_Held.second = p_Payload;
+            m_OutboundCounters->Coalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_HeldStatus.emplace_back(p_StatusKey, p_Payload);
+    }
+    /// Queue the held status messages which fit in our limits again
+    void Socket::QueueHeldStatus()
+    {
+        std::size_t l_Queued = 0;
+
+        for (; l_Queued < m_HeldStatus.size(); l_Queued++)
+        {
+            SharedPayload::Ptr const& l_Payload = m_HeldStatus[l_Queued].second;
+
+            if (m_OutQueue.GetSize() + l_Payload->GetSize() > m_OutboundLimits->MaxBytes
+                || m_OutQueue.GetMessageCount() >= m_OutboundLimits->MaxMessages)
+                break;
+
+            m_OutQueue.Write(l_Payload);
+        }
+
+        m_HeldStatus.erase(m_HeldStatus.begin(), m_HeldStatus.begin() + l_Queued);
+
+        m_Counters.MessagesOut.fetch_add(l_Queued, std::memory_order_relaxed);
+        m_NetworkCounters->MessagesOut.Add(l_Queued);
+    }
+    /// Disconnect a client which does not read what we send
+    void Socket::Evict()
+    {
+        m_Evicted = true;
+        m_HeldStatus.clear();
+        m_OutboundCounters->Disconnected.fetch_add(1, std::memory_order_relaxed);
+
+        LOG_WARNING("Socket", "Client %0 is not reading, %1 bytes in %2 messages unsent, disconnecting", m_Address, m_OutQueue.GetSize(), m_OutQueue.GetMessageCount());
+
+        /// We may be on any thread and hold our lock, close from our own NetworkThread
+        std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+        Post([l_Ptr]() { l_Ptr->CloseSocket(); });
+    }
+    /// Start or hurry the flush of data we just queued
+    void Socket::OnQueued()
+    {
+        /// Flush data if need
+        if (m_WriteState == WriteState::Idle)
+            StartWriteFlushTimer();
+        /// Enough buffered, no point waiting for the timer
+        else if (m_WriteState == WriteState::Buffering && m_OutQueue.GetSize() >= m_FlushPolicy->ByteThreshold)
+            ForceFlushOut();
     }
     /// Begin to send out our data in our buffer
     void Socket::FlushOut()
@@ -315,14 +1434,111 @@ namespace SteerStone { namespace Core { namespace Network {
 
         LOG_ASSERT(m_WriteState == WriteState::Buffering, "Socket", "Flushing out packet but write state is not set to buffering!");
 
+        /// We cannot encrypt or frame output before the handshakes are done, nor start a write on a thread we
+        /// are leaving; it waits in our queue
+        if ((m_Tls && !m_Tls->IsEstablished()) || m_Transport == SocketTransport::Detecting || m_Transport == SocketTransport::Handshake || m_MigrationService)
+        {
+            m_WriteState = WriteState::Idle;
+            return;
+        }
+
         /// At this point we are guarunteed that there is data to send in the primary buffer.  send it.
         m_WriteState = WriteState::Sending;
 
+        const std::chrono::steady_clock::time_point l_Now = std::chrono::steady_clock::now();
+        const uint64 l_FlushLatency = std::chrono::duration_cast<std::chrono::microseconds>(l_Now - m_BufferingStart).count();
+        m_FlushLatency.Record(l_FlushLatency);
+        m_NetworkCounters->RecordFlushLatency(l_FlushLatency);
+
+        /// Bytes flushed per window tell how fast output comes, a lone reply never makes us wait
+        const std::chrono::milliseconds l_HotWindow(m_FlushPolicy->HotWindow);
+        if (l_Now - m_HotWindowStart >= l_HotWindow)
+        {
+            m_HotPreviousBytes  = l_Now - m_HotWindowStart < 2 * l_HotWindow ? m_HotWindowBytes : 0;
+            m_HotWindowStart    = l_Now;
+            m_HotWindowBytes    = 0;
+        }
+
+        m_HotWindowBytes += m_OutQueue.GetSize();
+
+        if (m_FlushPolicy->Cork)
+            SetCork(true);
+
+        StartAsyncWrite();
+    }
+    /// Send every queued message in one gather write
+    /// One write syscall per call, OnWriteComplete sends whatever the kernel did not take
+    void Socket::StartAsyncWrite()
+    {
+        /// One span per chunk and per shared payload, the vector keeps its capacity so this does not allocate once warm
+        m_SendSpans.clear();
+
+        if (m_WebSocket)
+            m_WebSocket->GetSpans(m_OutQueue, m_SendSpans);
+        else
+            m_OutQueue.GetSpans(m_SendSpans);
+
+        m_SendSize = boost::asio::buffer_size(m_SendSpans);
+
+        /// With kTLS the kernel encrypts our plaintext spans as they are
+        if (m_Tls && !m_Tls->IsKernelSend())
+        {
+            StartTlsWrite();
+            return;
+        }
+
         std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
-        m_Socket.async_write_some(boost::asio::buffer(m_OutBuffer->m_Buffer, m_OutBuffer->m_WritePosition),
-            make_custom_alloc_handler(m_allocator,
+
+        if (IsOnRing())
+        {
+            /// Submission queue stays full, complete like a failed write from our NetworkThread once our lock is released
+            if (!m_IoUring->Send(m_RingWrite, m_Socket.native_handle(), m_SendSpans, l_Ptr))
+                boost::asio::post(m_Socket.get_executor(), MakeAllocHandler(m_HandlerAllocator, HandlerSlot_Write,
+                    [l_Ptr]() { l_Ptr->OnWriteComplete(boost::asio::error::no_buffer_space, 0); }));
+
+            return;
+        }
+
+        m_Socket.async_write_some(SpanSequence(m_SendSpans),
+            MakeAllocHandler(m_HandlerAllocator, HandlerSlot_Write,
                 [l_Ptr](boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length) { l_Ptr->OnWriteComplete(p_ErrorCode, p_Length); }));
     }
+    /// Send the spans through OpenSSL when the kernel does not encrypt for us, completes like a gather write
+    /// Records go out until the socket buffer is full; the rest, including a record OpenSSL only sent part of,
+    /// is sent by the next call, which starts with the same bytes
+    void Socket::StartTlsWrite()
+    {
+        std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
+        boost::system::error_code l_ErrorCode;
+        std::size_t l_Sent = 0;
+
+        for (boost::asio::const_buffer const& l_Span : m_SendSpans)
+        {
+            const std::size_t l_Length = m_Tls->Write(static_cast<uint8 const*>(l_Span.data()), l_Span.size(), l_ErrorCode);
+            l_Sent += l_Length;
+
+            if (l_ErrorCode || l_Length < l_Span.size())
+                break;
+        }
+
+        if (l_ErrorCode == boost::asio::error::would_block)
+        {
+            /// Nothing went out, wait for room; completes as a write which sent nothing
+            if (!l_Sent)
+            {
+                m_Socket.async_wait(boost::asio::ip::tcp::socket::wait_write,
+                    MakeAllocHandler(m_HandlerAllocator, HandlerSlot_Write,
+                        [l_Ptr](boost::system::error_code const& p_ErrorCode) { l_Ptr->OnWriteComplete(p_ErrorCode, 0); }));
+                return;
+            }
+
+            l_ErrorCode.clear();
+        }
+
+        /// We hold our lock, complete from our NetworkThread once it is released
+        boost::asio::post(m_Socket.get_executor(), MakeAllocHandler(m_HandlerAllocator, HandlerSlot_Write,
+            [l_Ptr, l_ErrorCode, l_Sent]() { l_Ptr->OnWriteComplete(l_ErrorCode, l_Sent); }));
+    }
     /// Start the time to send out our data in interval
     void Socket::StartWriteFlushTimer()
     {
@@ -336,10 +1552,67 @@ namespace SteerStone { namespace Core { namespace Network {
         }
 
         m_WriteState = WriteState::Buffering;
+        m_BufferingStart = std::chrono::steady_clock::now();
 
         std::shared_ptr<Socket> l_Ptr = Shared<Socket>();
-        m_OutBufferFlushTimer.expires_from_now(boost::posix_time::milliseconds(int32(m_BufferTimeout)));
-        m_OutBufferFlushTimer.async_wait([l_Ptr](const boost::system::error_code& p_Error) { l_Ptr->FlushOut(); });
+        const uint32 l_Delay = GetFlushDelay();
+
+        /// Idle connection, flush as soon as the current handler returns so writes
+        /// made in the same handler still go out together
+        if (l_Delay == 0 || !m_TimingWheel)
+        {
+            Post([l_Ptr]() { l_Ptr->FlushOut(); });
+            return;
+        }
+
+        /// The wheel belongs to our NetworkThread, arm inline when we are already on it
+        if (m_Service.load(std::memory_order_relaxed)->get_executor().running_in_this_thread())
+        {
+            m_TimingWheel->Arm(m_OutBufferFlushTimer, l_Delay, l_Ptr);
+            return;
+        }
+
+        Post([l_Ptr, l_Delay]()
+        {
+            l_Ptr->m_TimingWheel->Arm(l_Ptr->m_OutBufferFlushTimer, l_Delay, l_Ptr);
+        });
+    }
+    /// Get how long the data we just started buffering should wait
+    uint32 Socket::GetFlushDelay() const
+    {
+        if (m_FlushPolicy->Mode == FlushMode::Timer)
+            return m_FlushPolicy->CoalesceDelay;
+
+        if (m_OutQueue.GetSize() >= m_FlushPolicy->ByteThreshold)
+            return 0;
+
+        /// Bytes flushed within the last window, older windows say nothing about now
+        const std::chrono::milliseconds l_HotWindow(m_FlushPolicy->HotWindow);
+        const std::chrono::steady_clock::duration l_Age = m_BufferingStart - m_HotWindowStart;
+
+        std::size_t l_Recent = 0;
+        if (l_Age < l_HotWindow)
+            l_Recent = m_HotWindowBytes + m_HotPreviousBytes;
+        else if (l_Age < 2 * l_HotWindow)
+            l_Recent = m_HotWindowBytes;
+
+        /// Output is hot, wait a little so the next messages share a send; never longer than the window,
+        /// a client waiting on a reply only pays for it while we are streaming to it anyway
+        if (l_Recent >= m_FlushPolicy->HotBytes)
+            return std::min(m_FlushPolicy->CoalesceDelay, m_FlushPolicy->HotWindow);
+
+        return 0;
+    }
+    /// Toggle TCP_CORK
+    /// @p_Enable : Hold back partial segments
+    void Socket::SetCork(bool const p_Enable)
+    {
+    #ifdef TCP_CORK
+        boost::system::error_code l_ErrorCode;
+        m_Socket.set_option(boost::asio::detail::socket_option::boolean<IPPROTO_TCP, TCP_CORK>(p_Enable), l_ErrorCode);
+    #else
+        UNUSED(p_Enable);
+    #endif
     }
     /// Catch an error if packet is corrupted
     /// @p_Error : Error code
@@ -18,14 +18,38 @@
 
 #pragma once
 #include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <chrono>
 
 #include "PacketBuffer.hpp"
+#include "OutboundQueue.hpp"
+#include "FrameView.hpp"
+#include "FlushPolicy.hpp"
+#include "OutboundLimits.hpp"
+#include "InboundLimits.hpp"
+#include "TimingWheel.hpp"
+#include "NetworkCounters.hpp"
+#include "HandlerAllocator.hpp"
+#include "InboundQueue.hpp"
+#include "HotRestart.hpp"
+#include "WebSocket.hpp"
+#include "Tls.hpp"
+#include "IoUring.hpp"
+#include "Diagnostic/DiaHistogram.hpp"
 #include "Logger/Base.hpp"
 #include "Utility/UtiObjectGuard.hpp"
 #include "Utility/UtiLockable.hpp"
 
+/// A descriptor can be released from one io_service and assigned to another (not with IOCP)
+#if !defined(BOOST_ASIO_WINDOWS)
+    #define NETWORK_HAS_MIGRATION
+#endif
+
 namespace SteerStone { namespace Core { namespace Network {
 
+    /// Generation tagged index into a SocketRegistry, 0 is never a valid handle
+    using SocketHandle = uint64;
+
     /// Write States
     enum class WriteState
     {
@@ -41,6 +65,23 @@ namespace SteerStone { namespace Core { namespace Network {
         Reading                     ///< In progress of reading packet
     };
 
+    /// What became of a frame handed to the game tick
+    enum class InboundResult
+    {
+        Queued,                     ///< Waits for the game tick
+        NoQueue,                    ///< We have no inbound queue, handle it now
+        Full                        ///< Inbound queue is full, disconnect the client
+    };
+
+    /// Transports
+    enum class SocketTransport : uint8
+    {
+        Raw,                        ///< Game frames straight over TCP
+        Detecting,                  ///< Waiting for the first bytes, raw or a WebSocket upgrade request
+        Handshake,                  ///< Receiving the upgrade request
+        WebSocket                   ///< Game frames inside WebSocket frames
+    };
+
     /// Process States
     enum class ProcessState
     {
@@ -55,6 +96,8 @@ namespace SteerStone { namespace Core { namespace Network {
         friend class Utils::ObjectGuard<Socket>;
         friend class Utils::ObjectReadGuard<Socket>;
         friend class Utils::ObjectWriteGuard<Socket>;
+        /// Serializes straight into our out queue
+        friend class PacketWriter;
 
         public:
             /// Constructor
@@ -75,6 +118,26 @@ namespace SteerStone { namespace Core { namespace Network {
             bool IsClosed() const;
             /// Check if our socket can be deleted
             virtual bool Deletable() const;
+            /// Let go of our connection so another process can resume it, from our NetworkThread only
+            /// Returns false while a write is in flight, try again later; once it returns true our socket is closed
+            /// without calling our close handler, unless we cannot be handed over
+            /// @p_Handoff : Our descriptor and unhandled / unsent bytes, Fd is -1 if we were already closed or cannot be handed over
+            bool Detach(SocketHandoff& p_Handoff);
+            /// Keep serving the client after Detach returned false and the hand off gave up on us, from our NetworkThread only
+            void CancelDetach();
+            /// Resume a connection handed over by the process we replace, instead of being accepted
+            /// @p_Handoff : Connection, we own its descriptor and close it if we fail
+            bool Adopt(SocketHandoff const& p_Handoff);
+            /// Move to another NetworkThread, from our NetworkThread only
+            /// Our read wait is cancelled and we move once it comes back, when nothing of ours runs on the old thread;
+            /// returns false if we cannot start now (closed, a write in flight or already moving), try again later
+            /// @p_Service : Service of the NetworkThread taking us
+            /// @p_Attach  : Called from the old thread under our lock once we run on p_Service, gives us the limits,
+            ///              counters and timing wheel of the new thread
+            bool Migrate(boost::asio::io_service& p_Service, std::function<void(Socket*)> p_Attach);
+            /// Run a function on our NetworkThread from any thread, it follows us if we migrate before it runs
+            /// @p_Function : Function
+            template <typename Function> void Post(Function&& p_Function);
 
             /// Read the packet
             /// @p_Buffer : Buffer which holds the data
@@ -84,14 +147,79 @@ namespace SteerStone { namespace Core { namespace Network {
             /// @p_Length : The length of the data to skip
             void ReadSkip(std::size_t const& p_Length);
             /// Write the data to be sent
-            /// @p_Buffer : Buffer which holds the data
-            /// @p_Length : The length of the data
-            void Write(const char* p_Buffer, std::size_t const& p_Length);
+            /// Must not be called while a PacketWriter is open on this socket, it holds our lock
+            /// @p_Buffer    : Buffer which holds the data
+            /// @p_Length    : The length of the data
+            /// @p_Flags     : Write flags, decide what happens to the message while over the outbound limits
+            /// @p_StatusKey : Key of a WriteFlags_Status message, a newer message of the same key replaces it
+            void Write(const char* p_Buffer, std::size_t const& p_Length, WriteFlags const p_Flags = WriteFlags_None, uint32 const p_StatusKey = 0);
+            /// Queue a shared payload to be sent, without copying it
+            /// @p_Payload   : Payload, may be queued on many sockets
+            /// @p_Flags     : Write flags, decide what happens to the message while over the outbound limits
+            /// @p_StatusKey : Key of a WriteFlags_Status message, a newer message of the same key replaces it
+            void Write(SharedPayload::Ptr const& p_Payload, WriteFlags const p_Flags = WriteFlags_None, uint32 const p_StatusKey = 0);
             /// Get the total read length of the packet
             std::size_t const ReadLength();
             /// Get the length remaining to read
             std::size_t const ReadLengthRemaining();
 
+            /// Set our handle in our NetworkThread registry
+            /// @p_Handle : Handle
+            void SetHandle(SocketHandle const p_Handle);
+            /// Get our handle in our NetworkThread registry
+            SocketHandle GetHandle() const;
+            /// Set the function called when we close, it removes us from our NetworkThread registry
+            /// @p_CloseHandler : Handler
+            void SetCloseHandler(std::function<void(Socket*)> p_CloseHandler);
+
+            /// Set the policy deciding when buffered output is flushed
+            /// @p_FlushPolicy : Policy, must outlive the socket
+            void SetFlushPolicy(FlushPolicy const* p_FlushPolicy);
+            /// Get the time between the first buffered write and its flush, in microseconds
+            Diagnostic::Histogram const& GetFlushLatency() const;
+            /// Set the timing wheel our timers are armed on
+            /// @p_TimingWheel : Wheel of our NetworkThread, must outlive the socket
+            void SetTimingWheel(TimingWheel* p_TimingWheel);
+            /// Set the limits on our unsent data
+            /// @p_Limits   : Limits, must outlive the socket
+            /// @p_Counters : Overflow counters, must outlive the socket
+            void SetOutboundLimits(OutboundLimits const* p_Limits, OutboundCounters* p_Counters);
+            /// Set the limits on our reads and unhandled data
+            /// @p_Limits : Limits, must outlive the socket
+            void SetInboundLimits(InboundLimits const* p_Limits);
+            /// Set the pool our buffers borrow their storage from, before Open
+            /// @p_Pool : Pool of our NetworkThread
+            void SetBufferPool(std::shared_ptr<PacketBufferPool> const& p_Pool);
+            /// Check if our buffers borrow storage right now, our pool cannot change until they hand it back
+            bool HasBufferStorage() const;
+            /// Set the counters of our NetworkThread, bumped next to our own
+            /// @p_Counters : Counters, must outlive the socket
+            void SetNetworkCounters(NetworkCounters* p_Counters);
+            /// Get a copy of our counters
+            SocketCountersSnapshot GetCounters() const;
+            /// Set the ring our reads and writes run on, before Open; TLS connections stay on the reactor
+            /// @p_IoUring : Ring of our NetworkThread, null for the reactor, must outlive the socket
+            void SetIoUring(IoUring* p_IoUring);
+            /// Set the queue our frames are handed to the game tick through
+            /// @p_Queue : Queue of our NetworkThread, must outlive the socket
+            void SetInboundQueue(InboundQueue* p_Queue);
+            /// One of our queued frames was handled, from the game tick only
+            /// @p_Size : Size of the frame
+            void OnInboundHandled(std::size_t const p_Size);
+
+            /// Get our session, kept across a hot restart
+            uint64 GetSessionId() const;
+            /// Wrap the connection in TLS, before Open
+            /// @p_Context : Context of our Listener, null for plaintext
+            void SetTlsContext(TlsContext const* p_Context);
+            /// Check if the connection is wrapped in TLS
+            bool IsTls() const;
+            /// Accept WebSocket clients next to raw ones, before Open
+            /// @p_Enable : Detect the transport from the first bytes the client sends
+            void SetWebSocket(bool const p_Enable);
+            /// Get the transport the client talks to us over
+            SocketTransport GetTransport() const;
+
             /// Get our AsioSocket
             boost::asio::ip::tcp::socket& GetAsioSocket();
             /// Get our EndPoint
@@ -109,6 +237,7 @@ namespace SteerStone { namespace Core { namespace Network {
 
         protected:
             /// Virtual Function which passes into our derived class Socket
+            /// Bytes left unread are kept in the buffer for the next read (partial frames)
             virtual ProcessState ProcessIncomingData() = 0;
 
             /// Get the current read position
@@ -116,25 +245,88 @@ namespace SteerStone { namespace Core { namespace Network {
 
             /// Send our current data in our buffer
             void ForceFlushOut();
+            /// Count frames handled by ProcessIncomingData
+            /// @p_Count : Amount of frames
+            void CountMessagesIn(uint32 const p_Count = 1);
+            /// Copy a frame into our inbound queue
+            /// @p_Frame : Frame body
+            InboundResult QueueInbound(FrameView const& p_Frame);
 
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
 
         private:
-            /// Read incoming packets
+            /// Wait until incoming packets are ready to be read
             void StartAsyncRead();
-            /// Handle the incoming packet
-            /// @p_Error : Error code
-            /// @p_Length : Length of failed buffer
-            void OnRead(boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length);
+            /// Read what the kernel has ready into our in buffer, a burst of reads at most
+            /// @p_Error : Error code of the wait
+            void OnReadable(boost::system::error_code const& p_ErrorCode);
+            /// Check if our reads and writes run on the ring of our NetworkThread
+            bool IsOnRing() const;
+            /// Completion of our multishot receive
+            /// @p_Result : Bytes received, 0 at end of stream or -errno
+            /// @p_Flags  : Flags of the completion, carry the ring buffer
+            void OnRingRead(int32 const p_Result, uint32 const p_Flags);
+            /// Copy a receive out of its ring buffer and handle it, false once we are closed or stopped receiving
+            /// @p_Flags  : Flags of the completion
+            /// @p_Length : Bytes received
+            bool OnRingReceive(uint32 const p_Flags, std::size_t const p_Length);
+            /// Check if we hold as many frames waiting for the game tick as we may
+            bool IsInboundFull() const;
+            /// Stop reading while the game tick is behind on our frames, false if it caught up meanwhile
+            bool PauseRead();
+            /// Start reading again once the game tick handled our frames, from our NetworkThread
+            void ResumeRead();
+            /// Make progress on our TLS handshake, true once it completed
+            bool ContinueTlsHandshake();
+            /// Move our descriptor to the service we migrate to, from our old NetworkThread once our read wait came back
+            void FinishMigration();
+            /// Start reading and flushing again, from our new NetworkThread
+            void OnMigrated();
+            /// Make room for the next read, returns the space to read into, 0 once a frame does not fit in our inbound limits
+            std::size_t ReserveRead();
+            /// Handle the frames completed by a read, false once we are closed
+            /// @p_Length : Length read
+            bool OnRead(std::size_t const p_Length);
+            /// Turn bytes just read into the game byte stream, Skip while an upgrade request has not fully arrived
+            /// @p_Start : Position of the bytes just read in our in buffer
+            ProcessState ReadTransport(std::size_t p_Start);
             /// Finished sending out our buffer
             /// @p_Error : Error code
             /// @p_Length : Length of failed buffer
             void OnWriteComplete(boost::system::error_code const& p_ErrorCode, std::size_t const& p_Length);
+            /// Check a write against our outbound limits
+            /// @p_Length    : The length of the data
+            /// @p_Flags     : Write flags
+            /// @p_StatusKey : Status key
+            WriteAdmission AdmitWrite(std::size_t const p_Length, WriteFlags const p_Flags, uint32 const p_StatusKey);
+            /// Queue the message a PacketWriter serialized in place, our lock must be held
+            /// @p_Flags     : Write flags
+            /// @p_StatusKey : Status key
+            void CommitInPlace(WriteFlags const p_Flags, uint32 const p_StatusKey);
+            /// Hold a status message aside until the queue drains, replacing an older one of the same key
+            /// @p_StatusKey : Status key
+            /// @p_Payload   : Message
+            void HoldStatus(uint32 const p_StatusKey, SharedPayload::Ptr const& p_Payload);
+            /// Queue the held status messages which fit in our limits again
+            void QueueHeldStatus();
+            /// Disconnect a client which does not read what we send
+            void Evict();
+            /// Start or hurry the flush of data we just queued
+            void OnQueued();
             /// Begin to send out our data in our buffer
             void FlushOut();
+            /// Send every queued message in one gather write
+            void StartAsyncWrite();
+            /// Send the spans through OpenSSL when the kernel does not encrypt for us, completes like a gather write
+            void StartTlsWrite();
             /// Start the time to send out our data in interval
             void StartWriteFlushTimer();
+            /// Get how long the data we just started buffering should wait
+            uint32 GetFlushDelay() const;
+            /// Toggle TCP_CORK
+            /// @p_Enable : Hold back partial segments
+            void SetCork(bool const p_Enable);
             /// Catch an error if packet is corrupted
             /// @p_Error : Error code
             void OnError(boost::system::error_code const& p_ErrorCode);
@@ -142,110 +334,87 @@ namespace SteerStone { namespace Core { namespace Network {
         private:
             /// Socket
             boost::asio::ip::tcp::socket m_Socket;                                    ///< Socket
+            std::atomic<boost::asio::io_service*> m_Service;                          ///< Service of our NetworkThread, changed when we migrate
+            boost::asio::io_service* m_MigrationService;                              ///< Service we are moving to, null unless migrating
+            std::function<void(Socket*)> m_MigrationAttach;                           ///< Hands us the state of the NetworkThread we move to
             std::function<void(Socket*)> m_CloseHandler;                              ///< Socket Handler         
-            std::string const m_Address;                                              ///< Address of our Listener                           
-            std::string const m_RemoteEndPoint;                                       ///< End point of our Listener
+            std::string m_Address;                                                    ///< Address of our Listener, set once by Open
+            std::string m_RemoteEndPoint;                                             ///< End point of our Listener, set once by Open
+            std::atomic<bool> m_AddressSet;                                           ///< Publishes m_Address to counter snapshots from any thread
+            std::atomic<SocketHandle> m_Handle;                                       ///< Handle in our NetworkThread registry, read by counter snapshots from any thread
+            std::atomic<uint64> m_SessionId;                                          ///< Session, unique across restarts, read by counter snapshots from any thread
             /// Buffer
-            std::unique_ptr<PacketBuffer> m_InBuffer;                                 ///< In Buffer - recieving incoming packets
-            std::unique_ptr<PacketBuffer> m_OutBuffer;                                ///< Out Buffer - sending our packets
-            std::unique_ptr<PacketBuffer> m_SecondaryOutBuffer;                       ///< Secondary Out Buffer - sending our packets
-            boost::asio::deadline_timer m_OutBufferFlushTimer;                        ///< Time to send out packets
-            static int32 const m_BufferTimeout = 60;                                  ///< Interval of our flush out timer
+            std::shared_ptr<PacketBufferPool> m_BufferPool;                           ///< Pool our buffers borrow from, kept alive until we are gone
+            PacketBuffer m_InBuffer;                                                  ///< In Buffer - recieving incoming packets
+            OutboundQueue m_OutQueue;                                                 ///< Out Queue - sending our packets
+            std::vector<boost::asio::const_buffer> m_SendSpans;                       ///< Spans of the out queue being sent
+            /// Transport
+            TlsContext const* m_TlsContext;                                           ///< TLS context of our Listener, null for plaintext
+            std::unique_ptr<TlsConnection> m_Tls;                                     ///< TLS of the connection, used from our NetworkThread only
+            SocketTransport m_Transport;                                              ///< Transport of the client, changed under our lock
+            std::unique_ptr<WebSocket> m_WebSocket;                                   ///< WebSocket framing, once the client asked for an upgrade
+            InboundLimits const* m_InboundLimits;                                     ///< Limits, owned by our NetworkThread
+            /// Outbound Limits
+            OutboundLimits const* m_OutboundLimits;                                   ///< Limits, owned by our NetworkThread
+            OutboundCounters* m_OutboundCounters;                                     ///< Overflow counters, owned by our NetworkThread
+            std::vector<std::pair<uint32, SharedPayload::Ptr>> m_HeldStatus;          ///< Latest status message of each key, held while over the limits
+            bool m_Evicted;                                                           ///< Disconnect is pending, further writes are dropped
+            TimingWheel* m_TimingWheel;                                               ///< Wheel our timers are armed on, owned by our NetworkThread
+            WheelTimer m_OutBufferFlushTimer;                                         ///< Time to send out packets
+            /// Flushing
+            FlushPolicy const* m_FlushPolicy;                                         ///< When to flush, owned by our NetworkThread
+            std::chrono::steady_clock::time_point m_BufferingStart;                   ///< First write since the last flush
+            std::chrono::steady_clock::time_point m_HotWindowStart;                   ///< Start of the window our flushed bytes are counted in
+            std::size_t m_HotWindowBytes;                                             ///< Bytes flushed since m_HotWindowStart
+            std::size_t m_HotPreviousBytes;                                           ///< Bytes flushed in the window before, 0 if it was not the one just before
+            Diagnostic::Histogram m_FlushLatency;                                     ///< Buffering to flush latency
+            /// Counters
+            SocketCounters m_Counters;                                                ///< Our counters
+            NetworkCounters* m_NetworkCounters;                                       ///< Counters of our NetworkThread
+            std::size_t m_SendSize;                                                   ///< Bytes handed to the write in flight
+            /// Game tick
+            InboundQueue* m_InboundQueue;                                             ///< Frames to the game tick, owned by our NetworkThread
+            std::atomic<uint32> m_InboundFrames;                                      ///< Our frames waiting for the game tick
+            std::atomic<std::size_t> m_InboundBytes;                                  ///< Bytes of our frames waiting for the game tick
+            std::atomic<bool> m_ReadPaused;                                           ///< Reads wait for the game tick, whoever clears it resumes them
+            std::atomic<uint32> m_ResumeFrames;                                       ///< Reads resume at or below it, set before m_ReadPaused
+            std::atomic<std::size_t> m_ResumeBytes;                                   ///< Reads resume at or below it, set before m_ReadPaused
+            /// Handler memory
+            HandlerAllocator m_HandlerAllocator;                                      ///< Memory of our read and write completions
+            /// io_uring
+            IoUring* m_IoUring;                                                       ///< Ring of our NetworkThread, null on the reactor
+            UringOperation m_RingRead;                                                ///< Multishot receive, armed while we read
+            UringOperation m_RingWrite;                                               ///< Gather write in flight
             /// States
             WriteState m_WriteState;                                                  ///< State of where are at; idle, reading
             ReadState m_ReadState;                                                    ///< State of where are at; idle, reading, buffering
+    };
 
-#pragma region
-    private:
-        // custom allocator based on example from http://www.boost.org/doc/libs/1_62_0/doc/html/boost_asio/example/cpp11/allocation/server.cpp
-
-        // Class to manage the memory to be used for handler-based custom allocation.
-        // It contains a single block of memory which may be returned for allocation
-        // requests. If the memory is in use when an allocation request is made, the
-        // allocator delegates allocation to the global heap.
-        class handler_allocator
-        {
-        private:
-            static const size_t BufferSize = 512;
-
-            // Storage space used for handler-based custom memory allocation.
-            std::aligned_storage<BufferSize>::type mBuffer;
-
-            // Whether the handler-based custom allocation storage has been used.
-            bool m_inUse;
-
-        public:
-            handler_allocator() : m_inUse(false) {}
-
-            handler_allocator(const handler_allocator&) = delete;
-            handler_allocator& operator=(const handler_allocator&) = delete;
-
-            void* allocate(std::size_t size)
-            {
-                if (!m_inUse && size <= sizeof(mBuffer))
-                {
-                    m_inUse = true;
-                    return &mBuffer;
-                }
-
-                return ::operator new(size);
-            }
+    template<typename T>
+    inline std::shared_ptr<T> Socket::Shared()
+    {
+        return std::static_pointer_cast<T>(shared_from_this());
+    }
 
-            void deallocate(void* pointer)
-            {
-                if (pointer == &mBuffer)
-                    m_inUse = false;
-                else
-                    ::operator delete(pointer);
-            }
-        };
+    /// Run a function on our NetworkThread from any thread, it follows us if we migrate before it runs
+    /// @p_Function : Function
+    template <typename Function>
+    inline void Socket::Post(Function&& p_Function)
+    {
+        std::shared_ptr<Socket> l_Ptr = shared_from_this();
 
-        // Wrapper class template for handler objects to allow handler memory
-        // allocation to be customised. Calls to operator() are forwarded to the
-        // encapsulated handler.
-        template <typename Handler>
-        class custom_alloc_handler
+        boost::asio::post(*m_Service.load(std::memory_order_acquire), [l_Ptr, l_Function = std::forward<Function>(p_Function)]() mutable
         {
-        private:
-            handler_allocator& m_allocator;
-            Handler m_handler;
-
-        public:
-            custom_alloc_handler(handler_allocator& a, Handler h) : m_allocator(a), m_handler(h) {}
-
-            template <typename ...Args>
-            void operator()(Args&& ... args)
-            {
-                m_handler(std::forward<Args>(args)...);
-            }
-
-            friend void* asio_handler_allocate(std::size_t size, custom_alloc_handler<Handler>* this_handler)
+            /// We moved after it was posted, the old thread must not touch us any more
+            if (!l_Ptr->m_Service.load(std::memory_order_acquire)->get_executor().running_in_this_thread())
             {
-                return this_handler->m_allocator.allocate(size);
+                l_Ptr->Post(std::move(l_Function));
+                return;
             }
 
-            friend void asio_handler_deallocate(void* pointer, std::size_t /*size*/, custom_alloc_handler<Handler>* this_handler)
-            {
-                this_handler->m_allocator.deallocate(pointer);
-            }
-        };
-
-        // Helper function to wrap a handler object to add custom allocation.
-        template <typename Handler>
-        static custom_alloc_handler<Handler> make_custom_alloc_handler(handler_allocator& a, Handler h)
-        {
-            return custom_alloc_handler<Handler>(a, h);
-        }
-
-        handler_allocator m_allocator;
-    };
-
-    template<typename T>
-    inline std::shared_ptr<T> Socket::Shared()
-    {
-        return std::static_pointer_cast<T>(shared_from_this());
+            l_Function();
+        });
     }
-#pragma endregion CustomHandler; TODO
 }   ///< Network
 }   ///< Core
 }   ///< Steerstone
\ No newline at end of file
@@ -0,0 +1,170 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <atomic>
+#include <mutex>
+
+#include "Core/Core.hpp"
+#include "Socket.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Slot array of sockets, indexed by generation tagged handles
+    /// Add and Remove are O(1), a freed slot is reused by the next Add with a new generation
+    /// so a stale handle never resolves to the socket which took its slot
+    template<typename T> class SocketRegistry
+    {
+        DISALLOW_COPY_AND_ASSIGN(SocketRegistry);
+
+        /// Slot
+        struct Slot
+        {
+            std::shared_ptr<T> Socket;      ///< Socket, null when free
+            uint32 Generation;              ///< Bumped every time the slot is freed
+        };
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            SocketRegistry()
+                : m_Size(0)
+            {
+            }
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Store socket and give it its handle
+            /// @p_Socket : Socket to store
+            SocketHandle Add(std::shared_ptr<T> const& p_Socket)
+            {
+                std::lock_guard<std::mutex> l_Guard(m_Lock);
+
+                uint32 l_Index;
+                if (!m_FreeSlots.empty())
+                {
+                    l_Index = m_FreeSlots.back();
+                    m_FreeSlots.pop_back();
+                }
+                else
+                {
+                    l_Index = static_cast<uint32>(m_Slots.size());
+                    m_Slots.push_back(Slot{ nullptr, 1 });
+                }
+
+                Slot& l_Slot = m_Slots[l_Index];
+                l_Slot.Socket = p_Socket;
+
+                const SocketHandle l_Handle = MakeHandle(l_Index, l_Slot.Generation);
+                p_Socket->SetHandle(l_Handle);
+
+                m_Size.fetch_add(1, std::memory_order_relaxed);
+
+                return l_Handle;
+            }
+            /// Remove socket from storage
+            /// @p_Handle : Handle given by Add
+            bool Remove(SocketHandle const p_Handle)
+            {
+                std::lock_guard<std::mutex> l_Guard(m_Lock);
+
+                Slot* l_Slot = Find(p_Handle);
+                if (!l_Slot)
+                    return false;
+
+                l_Slot->Socket.reset();
+                l_Slot->Generation = l_Slot->Generation == UINT32_MAX ? 1 : l_Slot->Generation + 1;
+
+                m_FreeSlots.push_back(GetIndex(p_Handle));
+                m_Size.fetch_sub(1, std::memory_order_relaxed);
+
+                return true;
+            }
+            /// Get socket, null if the handle is stale
+            /// @p_Handle : Handle given by Add
+            std::shared_ptr<T> Get(SocketHandle const p_Handle)
+            {
+                std::lock_guard<std::mutex> l_Guard(m_Lock);
+
+                Slot* l_Slot = Find(p_Handle);
+                return l_Slot ? l_Slot->Socket : nullptr;
+            }
+            /// Copy every stored socket
+            std::vector<std::shared_ptr<T>> GetAll()
+            {
+                std::lock_guard<std::mutex> l_Guard(m_Lock);
+
+                std::vector<std::shared_ptr<T>> l_Sockets;
+                l_Sockets.reserve(m_Size.load(std::memory_order_relaxed));
+
+                for (Slot const& l_Slot : m_Slots)
+                    if (l_Slot.Socket)
+                        l_Sockets.push_back(l_Slot.Socket);
+
+                return l_Sockets;
+            }
+            /// Get amount of stored sockets, never locks
+            std::size_t GetSize() const
+            {
+                return m_Size.load(std::memory_order_relaxed);
+            }
+
+        private:
+            /// Build handle
+            /// @p_Index      : Slot index
+            /// @p_Generation : Slot generation
+            static SocketHandle MakeHandle(uint32 const p_Index, uint32 const p_Generation)
+            {
+                return (static_cast<SocketHandle>(p_Generation) << 32) | p_Index;
+            }
+            /// Get slot index of handle
+            /// @p_Handle : Handle
+            static uint32 GetIndex(SocketHandle const p_Handle)
+            {
+                return static_cast<uint32>(p_Handle & 0xFFFFFFFF);
+            }
+            /// Find slot of a live handle
+            /// @p_Handle : Handle
+            Slot* Find(SocketHandle const p_Handle)
+            {
+                const uint32 l_Index = GetIndex(p_Handle);
+
+                if (l_Index >= m_Slots.size())
+                    return nullptr;
+
+                Slot& l_Slot = m_Slots[l_Index];
+                if (!l_Slot.Socket || l_Slot.Generation != static_cast<uint32>(p_Handle >> 32))
+                    return nullptr;
+
+                return &l_Slot;
+            }
+
+        private:
+            std::vector<Slot> m_Slots;                  ///< Slots
+            std::vector<uint32> m_FreeSlots;            ///< Indexes of free slots
+            std::atomic<std::size_t> m_Size;            ///< Amount of stored sockets
+            std::mutex m_Lock;                          ///< Mutex, only held for the slot update
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
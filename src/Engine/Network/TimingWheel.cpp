@@ -0,0 +1,310 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cassert>
+
+#include "TimingWheel.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Constructor
+    /// @p_Callback : Called when the timer fires
+    WheelTimer::WheelTimer(std::function<void()> p_Callback)
+        : m_Callback(std::move(p_Callback)), m_Expiry(0)
+    {
+    }
+    /// Deconstructor
+    WheelTimer::~WheelTimer()
+    {
+        /// An armed timer keeps its owner alive, so it can never be destroyed while linked
+        assert(!IsArmed());
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Set function called when the timer fires
+    /// @p_Callback : Callback
+    void WheelTimer::SetCallback(std::function<void()> p_Callback)
+    {
+        m_Callback = std::move(p_Callback);
+    }
+    /// Check if the timer is armed
+    bool WheelTimer::IsArmed() const
+    {
+        return Next != nullptr;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Service : Service running the wheel, every call must be made from it
+    /// @p_TickMs  : Resolution in milliseconds
+    TimingWheel::TimingWheel(boost::asio::io_service& p_Service, uint32 const p_TickMs)
+        : m_Timer(p_Service), m_TickDuration(std::max<uint32>(p_TickMs, 1)), m_Start(std::chrono::steady_clock::now()),
+        m_Tick(0), m_Ticking(false), m_Size(0)
+    {
+        for (auto& l_Level : m_Slots)
+            for (TimerLink& l_Slot : l_Level)
+                l_Slot.Prev = l_Slot.Next = &l_Slot;
+    }
+    /// Deconstructor
+    TimingWheel::~TimingWheel()
+    {
+        /// Owners are released once every timer is unlinked, one of them may be the last reference to a socket
+        std::vector<std::shared_ptr<void>> l_Owners;
+        l_Owners.reserve(m_Size);
+
+        for (auto& l_Level : m_Slots)
+        {
+            for (TimerLink& l_Slot : l_Level)
+            {
+                while (l_Slot.Next != &l_Slot)
+                {
+                    WheelTimer* l_Timer = static_cast<WheelTimer*>(l_Slot.Next);
+                    Unlink(l_Timer);
+                    l_Owners.push_back(std::move(l_Timer->m_Owner));
+                }
+            }
+        }
+
+        m_Size = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Arm a timer, rearming an armed timer moves it
+    /// @p_Timer : Timer
+    /// @p_Delay : Milliseconds, rounded up to our resolution
+    /// @p_Owner : Kept alive until the timer fires or is cancelled
+    void TimingWheel::Arm(WheelTimer& p_Timer, uint32 const p_Delay, std::shared_ptr<void> p_Owner)
+    {
+        if (p_Timer.IsArmed())
+        {
+            Unlink(&p_Timer);
+            m_Size--;
+        }
+
+        /// Empty wheel, catch up with the clock before working out the expiry
+        if (!m_Size)
+            m_Tick = std::max(m_Tick, GetTargetTick());
+
+        const uint64 l_Ticks = (p_Delay + m_TickDuration.count() - 1) / m_TickDuration.count();
+
+        p_Timer.m_Expiry    = m_Tick + std::max<uint64>(l_Ticks, 1);
+        p_Timer.m_Owner     = std::move(p_Owner);
+
+        Insert(&p_Timer);
+        m_Size++;
+
+        StartTicking();
+    }
+    /// Cancel a timer, returns false if it was not armed
+    /// @p_Timer : Timer
+    bool TimingWheel::Cancel(WheelTimer& p_Timer)
+    {
+        if (!p_Timer.IsArmed())
+            return false;
+
+        Unlink(&p_Timer);
+        m_Size--;
+
+        /// Release last, it may be the last reference to the timer
+        std::shared_ptr<void> l_Owner = std::move(p_Timer.m_Owner);
+
+        return true;
+    }
+
+    /// Get amount of armed timers
+    std::size_t TimingWheel::GetSize() const
+    {
+        return m_Size;
+    }
+    /// Get resolution in milliseconds
+    uint32 TimingWheel::GetTickMs() const
+    {
+        return static_cast<uint32>(m_TickDuration.count());
+    }
+    /// Get how many timers fired per tick
+    Diagnostic::Histogram const& TimingWheel::GetFiredPerTick() const
+    {
+        return m_FiredPerTick;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Put an armed timer in the slot of its expiry
+    /// @p_Timer : Timer
+    void TimingWheel::Insert(WheelTimer* p_Timer)
+    {
+        const uint64 l_Delta = p_Timer->m_Expiry > m_Tick ? p_Timer->m_Expiry - m_Tick : 0;
+
+        for (uint32 l_Level = 0; l_Level < TIMING_WHEEL_LEVELS; l_Level++)
+        {
+            if (l_Delta < (uint64(1) << (TIMING_WHEEL_SLOT_BITS * (l_Level + 1))) || l_Level == TIMING_WHEEL_LEVELS - 1)
+            {
+                /// Past the top level, park in the furthest slot and cascade down from there
+                uint64 l_Expiry = p_Timer->m_Expiry;
+                if (l_Delta >= (uint64(1) << (TIMING_WHEEL_SLOT_BITS * TIMING_WHEEL_LEVELS)))
+                    l_Expiry = m_Tick + (uint64(1) << (TIMING_WHEEL_SLOT_BITS * TIMING_WHEEL_LEVELS)) - 1;
+
+                const uint64 l_Slot = (l_Expiry >> (TIMING_WHEEL_SLOT_BITS * l_Level)) & (TIMING_WHEEL_SLOTS - 1);
+                PushBack(&m_Slots[l_Level][l_Slot], p_Timer);
+                return;
+            }
+        }
+    }
+    /// Advance one tick, cascade the levels above and fire level 0
+    std::size_t TimingWheel::Advance()
+    {
+        m_Tick++;
+
+        /// Each time a level wraps, the next slot of the level above comes down
+        for (uint32 l_Level = 1; l_Level < TIMING_WHEEL_LEVELS; l_Level++)
+        {
+            if (m_Tick & ((uint64(1) << (TIMING_WHEEL_SLOT_BITS * l_Level)) - 1))
+                break;
+
+            TimerLink& l_Slot = m_Slots[l_Level][(m_Tick >> (TIMING_WHEEL_SLOT_BITS * l_Level)) & (TIMING_WHEEL_SLOTS - 1)];
+
+            TimerLink l_Cascade;
+            l_Cascade.Prev = l_Cascade.Next = &l_Cascade;
+            if (l_Slot.Next != &l_Slot)
+            {
+                /// Splice the slot out so reinserting into it cannot loop
+                l_Cascade.Next = l_Slot.Next;
+                l_Cascade.Prev = l_Slot.Prev;
+                l_Cascade.Next->Prev = l_Cascade.Prev->Next = &l_Cascade;
+                l_Slot.Prev = l_Slot.Next = &l_Slot;
+            }
+
+            while (l_Cascade.Next != &l_Cascade)
+            {
+                WheelTimer* l_Timer = static_cast<WheelTimer*>(l_Cascade.Next);
+                Unlink(l_Timer);
+                Insert(l_Timer);
+            }
+        }
+
+        TimerLink& l_Slot = m_Slots[0][m_Tick & (TIMING_WHEEL_SLOTS - 1)];
+
+        /// Fire from a detached list, callbacks may arm or cancel any timer
+        TimerLink l_Expired;
+        l_Expired.Prev = l_Expired.Next = &l_Expired;
+        if (l_Slot.Next == &l_Slot)
+            return 0;
+
+        l_Expired.Next = l_Slot.Next;
+        l_Expired.Prev = l_Slot.Prev;
+        l_Expired.Next->Prev = l_Expired.Prev->Next = &l_Expired;
+        l_Slot.Prev = l_Slot.Next = &l_Slot;
+
+        std::size_t l_Fired = 0;
+        while (l_Expired.Next != &l_Expired)
+        {
+            WheelTimer* l_Timer = static_cast<WheelTimer*>(l_Expired.Next);
+            Unlink(l_Timer);
+
+            /// Parked past the top level, not due yet
+            if (l_Timer->m_Expiry > m_Tick)
+            {
+                Insert(l_Timer);
+                continue;
+            }
+
+            m_Size--;
+
+            /// The callback may rearm the timer, which sets a new owner
+            std::shared_ptr<void> l_Owner = std::move(l_Timer->m_Owner);
+
+            if (l_Timer->m_Callback)
+                l_Timer->m_Callback();
+
+            l_Fired++;
+        }
+
+        return l_Fired;
+    }
+    /// Get the tick we should be on
+    uint64 TimingWheel::GetTargetTick() const
+    {
+        return static_cast<uint64>((std::chrono::steady_clock::now() - m_Start) / m_TickDuration);
+    }
+    /// Start ticking if we are not
+    void TimingWheel::StartTicking()
+    {
+        if (m_Ticking || !m_Size)
+            return;
+
+        m_Ticking = true;
+
+        m_Timer.expires_at(m_Start + m_TickDuration * (m_Tick + 1));
+        m_Timer.async_wait([this](boost::system::error_code const& p_ErrorCode) { this->OnTick(p_ErrorCode); });
+    }
+    /// Tick handler
+    /// @p_ErrorCode : Error code
+    void TimingWheel::OnTick(boost::system::error_code const& p_ErrorCode)
+    {
+        m_Ticking = false;
+
+        if (p_ErrorCode == boost::asio::error::operation_aborted)
+            return;
+
+        const uint64 l_Target = GetTargetTick();
+
+        std::size_t l_Fired = 0;
+        while (m_Tick < l_Target && m_Size)
+            l_Fired += Advance();
+
+        /// Nothing left, jump straight to now instead of walking empty ticks next time
+        if (!m_Size)
+            m_Tick = l_Target;
+
+        m_FiredPerTick.Record(l_Fired);
+
+        StartTicking();
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Unlink a link from its list
+    /// @p_Link : Link
+    void TimingWheel::Unlink(TimerLink* p_Link)
+    {
+        p_Link->Prev->Next = p_Link->Next;
+        p_Link->Next->Prev = p_Link->Prev;
+        p_Link->Prev = p_Link->Next = nullptr;
+    }
+    /// Link p_Link at the back of p_List
+    /// @p_List : List head
+    /// @p_Link : Link
+    void TimingWheel::PushBack(TimerLink* p_List, TimerLink* p_Link)
+    {
+        p_Link->Prev        = p_List->Prev;
+        p_Link->Next        = p_List;
+        p_List->Prev->Next  = p_Link;
+        p_List->Prev        = p_Link;
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,146 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+
+#include "Core/Core.hpp"
+#include "Diagnostic/DiaHistogram.hpp"
+
+#define TIMING_WHEEL_LEVELS 4
+#define TIMING_WHEEL_SLOT_BITS 6
+#define TIMING_WHEEL_SLOTS (1 << TIMING_WHEEL_SLOT_BITS)
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Link of an intrusive timer list
+    struct TimerLink
+    {
+        TimerLink* Prev = nullptr;
+        TimerLink* Next = nullptr;
+    };
+
+    /// Timer living inside its owner, armed on a TimingWheel
+    /// Only touched from the thread running the wheel
+    class WheelTimer : private TimerLink
+    {
+        DISALLOW_COPY_AND_ASSIGN(WheelTimer);
+
+        friend class TimingWheel;
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            /// @p_Callback : Called when the timer fires
+            explicit WheelTimer(std::function<void()> p_Callback = nullptr);
+            /// Deconstructor
+            ~WheelTimer();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Set function called when the timer fires
+            /// @p_Callback : Callback
+            void SetCallback(std::function<void()> p_Callback);
+            /// Check if the timer is armed
+            bool IsArmed() const;
+
+        private:
+            std::function<void()> m_Callback;       ///< Called when the timer fires
+            std::shared_ptr<void> m_Owner;          ///< Keeps our owner alive while armed
+            uint64 m_Expiry;                        ///< Tick to fire on
+    };
+
+    /// Hierarchical timing wheel, TIMING_WHEEL_LEVELS levels of TIMING_WHEEL_SLOTS slots
+    /// Arm and cancel are O(1), a timer is moved down one level each time its slot comes up
+    /// The wheel only ticks while it holds armed timers
+    class TimingWheel
+    {
+        DISALLOW_COPY_AND_ASSIGN(TimingWheel);
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Constructor
+            /// @p_Service : Service running the wheel, every call must be made from it
+            /// @p_TickMs  : Resolution in milliseconds
+            TimingWheel(boost::asio::io_service& p_Service, uint32 const p_TickMs);
+            /// Deconstructor
+            ~TimingWheel();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Arm a timer, rearming an armed timer moves it
+            /// @p_Timer : Timer
+            /// @p_Delay : Milliseconds, rounded up to our resolution
+            /// @p_Owner : Kept alive until the timer fires or is cancelled
+            void Arm(WheelTimer& p_Timer, uint32 const p_Delay, std::shared_ptr<void> p_Owner);
+            /// Cancel a timer, returns false if it was not armed
+            /// @p_Timer : Timer
+            bool Cancel(WheelTimer& p_Timer);
+
+            /// Get amount of armed timers
+            std::size_t GetSize() const;
+            /// Get resolution in milliseconds
+            uint32 GetTickMs() const;
+            /// Get how many timers fired per tick
+            Diagnostic::Histogram const& GetFiredPerTick() const;
+
+        private:
+            /// Put an armed timer in the slot of its expiry
+            /// @p_Timer : Timer
+            void Insert(WheelTimer* p_Timer);
+            /// Advance one tick, cascade the levels above and fire level 0
+            std::size_t Advance();
+            /// Get the tick we should be on
+            uint64 GetTargetTick() const;
+            /// Start ticking if we are not
+            void StartTicking();
+            /// Tick handler
+            /// @p_ErrorCode : Error code
+            void OnTick(boost::system::error_code const& p_ErrorCode);
+
+            /// Unlink a link from its list
+            /// @p_Link : Link
+            static void Unlink(TimerLink* p_Link);
+            /// Link p_Link at the back of p_List
+            /// @p_List : List head
+            /// @p_Link : Link
+            static void PushBack(TimerLink* p_List, TimerLink* p_Link);
+
+        private:
+            boost::asio::steady_timer m_Timer;                                      ///< Drives our ticks
+            std::chrono::milliseconds const m_TickDuration;                         ///< Resolution
+            std::chrono::steady_clock::time_point const m_Start;                    ///< Time of tick 0
+            uint64 m_Tick;                                                          ///< Current tick
+            bool m_Ticking;                                                         ///< m_Timer is armed
+            std::size_t m_Size;                                                     ///< Armed timers
+            TimerLink m_Slots[TIMING_WHEEL_LEVELS][TIMING_WHEEL_SLOTS];             ///< List heads
+            Diagnostic::Histogram m_FiredPerTick;                                   ///< Timers fired per tick handler
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,269 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <boost/asio/error.hpp>
+#include <climits>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include "Tls.hpp"
+#include "Logger/Base.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Same for every process, sessions are only resumed by servers which share our ticket key or cache
+    static unsigned char const s_SessionIdContext[] = "SteerStone";
+
+    /// Set up a context, null on failure
+    /// @p_Settings : Settings
+    std::shared_ptr<TlsContext> TlsContext::Create(TlsSettings const& p_Settings)
+    {
+        SSL_CTX* l_Context = SSL_CTX_new(TLS_server_method());
+        if (!l_Context)
+        {
+            LOG_ERROR("Tls", "Failed to create TLS context: %0", GetLastError());
+            return nullptr;
+        }
+
+        /// Owns the context from here on, frees it if we fail
+        std::shared_ptr<TlsContext> l_TlsContext(new TlsContext(l_Context, p_Settings.KernelTls));
+
+        SSL_CTX_set_min_proto_version(l_Context, TLS1_2_VERSION);
+        SSL_CTX_set_options(l_Context, SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE | (p_Settings.KernelTls ? SSL_OP_ENABLE_KTLS : 0));
+
+        /// Writes go out one record at a time from a queue which only moves forward, and idle connections give their buffers back
+        SSL_CTX_set_mode(l_Context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER | SSL_MODE_RELEASE_BUFFERS);
+
+        if (SSL_CTX_use_certificate_chain_file(l_Context, p_Settings.CertificateFile.c_str()) != 1)
+        {
+            LOG_ERROR("Tls", "Failed to load TLS certificate %0: %1", p_Settings.CertificateFile, GetLastError());
+            return nullptr;
+        }
+
+        if (SSL_CTX_use_PrivateKey_file(l_Context, p_Settings.PrivateKeyFile.c_str(), SSL_FILETYPE_PEM) != 1 || SSL_CTX_check_private_key(l_Context) != 1)
+        {
+            LOG_ERROR("Tls", "Failed to load TLS private key %0: %1", p_Settings.PrivateKeyFile, GetLastError());
+            return nullptr;
+        }
+
+        /// Resumption skips the key exchange and the certificate, a reconnect storm costs a fraction of the full handshakes
+        SSL_CTX_set_session_id_context(l_Context, s_SessionIdContext, sizeof(s_SessionIdContext) - 1);
+        SSL_CTX_set_session_cache_mode(l_Context, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(l_Context, p_Settings.SessionCacheSize);
+        SSL_CTX_set_timeout(l_Context, p_Settings.SessionTimeout);
+        SSL_CTX_set_num_tickets(l_Context, p_Settings.Tickets);
+
+        if (!p_Settings.TicketKeyFile.empty())
+        {
+            std::ifstream l_File(p_Settings.TicketKeyFile, std::ios::binary);
+            std::vector<char> l_Key((std::istreambuf_iterator<char>(l_File)), std::istreambuf_iterator<char>());
+
+            if (l_Key.size() != TLS_TICKET_KEY_SIZE || SSL_CTX_set_tlsext_ticket_keys(l_Context, l_Key.data(), TLS_TICKET_KEY_SIZE) != 1)
+            {
+                LOG_ERROR("Tls", "Failed to load TLS ticket key %0, it must hold %1 bytes", p_Settings.TicketKeyFile, TLS_TICKET_KEY_SIZE);
+                return nullptr;
+            }
+        }
+
+        return l_TlsContext;
+    }
+    /// Constructor
+    /// @p_Context   : OpenSSL context, we own it
+    /// @p_KernelTls : Connections try kTLS
+    TlsContext::TlsContext(SSL_CTX* p_Context, bool const p_KernelTls)
+        : m_Context(p_Context), m_KernelTls(p_KernelTls)
+    {
+    }
+    /// Deconstructor
+    TlsContext::~TlsContext()
+    {
+        /// Connections hold their own reference, the context lives on until the last of them is gone
+        SSL_CTX_free(m_Context);
+    }
+
+    /// Get the OpenSSL context
+    SSL_CTX* TlsContext::GetContext() const
+    {
+        return m_Context;
+    }
+    /// Check if connections try to hand record encryption to the kernel
+    bool TlsContext::IsKernelTls() const
+    {
+        return m_KernelTls;
+    }
+
+    /// Get the reason of the last failed OpenSSL call of this thread, clears it
+    std::string TlsContext::GetLastError()
+    {
+        char l_Error[256] = "unknown error";
+
+        const unsigned long l_Code = ERR_peek_last_error();
+        if (l_Code)
+            ERR_error_string_n(l_Code, l_Error, sizeof(l_Error));
+
+        ERR_clear_error();
+        return l_Error;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    /// @p_Context : Context, kept alive by the connection
+    /// @p_Fd      : Connected non blocking descriptor
+    TlsConnection::TlsConnection(TlsContext const& p_Context, int const p_Fd)
+        : m_Ssl(SSL_new(p_Context.GetContext())), m_Established(false)
+    {
+        if (!m_Ssl)
+            return;
+
+        if (SSL_set_fd(m_Ssl, p_Fd) != 1)
+        {
+            SSL_free(m_Ssl);
+            m_Ssl = nullptr;
+            return;
+        }
+
+        SSL_set_accept_state(m_Ssl);
+    }
+    /// Deconstructor
+    TlsConnection::~TlsConnection()
+    {
+        if (m_Ssl)
+            SSL_free(m_Ssl);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Check if the connection could be set up
+    bool TlsConnection::IsValid() const
+    {
+        return m_Ssl != nullptr;
+    }
+    /// Make progress on the handshake
+    TlsHandshake TlsConnection::Handshake()
+    {
+        ERR_clear_error();
+
+        const int l_Result = SSL_do_handshake(m_Ssl);
+        if (l_Result == 1)
+        {
+            m_Established = true;
+            return TlsHandshake::Complete;
+        }
+
+        switch (SSL_get_error(m_Ssl, l_Result))
+        {
+            case SSL_ERROR_WANT_READ:
+                return TlsHandshake::WantRead;
+            case SSL_ERROR_WANT_WRITE:
+                return TlsHandshake::WantWrite;
+            default:
+                return TlsHandshake::Failed;
+        }
+    }
+    /// Check if the handshake completed
+    bool TlsConnection::IsEstablished() const
+    {
+        return m_Established;
+    }
+    /// Check if the client resumed an earlier session
+    bool TlsConnection::IsResumed() const
+    {
+        return SSL_session_reused(m_Ssl) == 1;
+    }
+    /// Check if the kernel encrypts what we send
+    bool TlsConnection::IsKernelSend() const
+    {
+        return BIO_get_ktls_send(SSL_get_wbio(m_Ssl));
+    }
+
+    /// Read decrypted bytes, would_block once nothing is left
+    /// @p_Buffer    : Buffer
+    /// @p_Length    : Space in the buffer
+    /// @p_ErrorCode : Error code
+    std::size_t TlsConnection::Read(uint8* p_Buffer, std::size_t const p_Length, boost::system::error_code& p_ErrorCode)
+    {
+        ERR_clear_error();
+
+        const int l_Result = SSL_read(m_Ssl, p_Buffer, static_cast<int>(std::min<std::size_t>(p_Length, INT_MAX)));
+        if (l_Result > 0)
+        {
+            p_ErrorCode.clear();
+            return static_cast<std::size_t>(l_Result);
+        }
+
+        p_ErrorCode = GetErrorCode(l_Result);
+        return 0;
+    }
+    /// Encrypt and send bytes, returns how many went out in complete records; would_block if none did
+    /// A record left half sent is finished by the next call, which must start with the same bytes
+    /// @p_Buffer    : Buffer
+    /// @p_Length    : The length of the data
+    /// @p_ErrorCode : Error code
+    std::size_t TlsConnection::Write(uint8 const* p_Buffer, std::size_t const p_Length, boost::system::error_code& p_ErrorCode)
+    {
+        ERR_clear_error();
+
+        const int l_Result = SSL_write(m_Ssl, p_Buffer, static_cast<int>(std::min<std::size_t>(p_Length, INT_MAX)));
+        if (l_Result > 0)
+        {
+            p_ErrorCode.clear();
+            return static_cast<std::size_t>(l_Result);
+        }
+
+        p_ErrorCode = GetErrorCode(l_Result);
+        return 0;
+    }
+    /// Get the decrypted bytes OpenSSL holds, the descriptor does not wake us for them
+    std::size_t TlsConnection::GetPending() const
+    {
+        return static_cast<std::size_t>(SSL_pending(m_Ssl));
+    }
+
+    /// Turn the result of an OpenSSL call into an error code
+    /// @p_Result : Return value of the call
+    boost::system::error_code TlsConnection::GetErrorCode(int const p_Result) const
+    {
+        switch (SSL_get_error(m_Ssl, p_Result))
+        {
+            /// TLS 1.3 may need to write in a read (a key update); OpenSSL finishes it in a later call
+            case SSL_ERROR_WANT_READ:
+            case SSL_ERROR_WANT_WRITE:
+                return boost::asio::error::would_block;
+            /// close_notify
+            case SSL_ERROR_ZERO_RETURN:
+                return boost::asio::error::eof;
+            case SSL_ERROR_SYSCALL:
+                if (errno)
+                    return boost::system::error_code(errno, boost::system::system_category());
+                return boost::asio::error::eof;
+            default:
+                ERR_clear_error();
+                return boost::asio::error::connection_aborted;
+        }
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,133 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/system/error_code.hpp>
+#include <memory>
+#include <string>
+
+#include "Core/Core.hpp"
+#include "TlsSettings.hpp"
+
+/// Keeps OpenSSL headers out of everything which includes a Socket
+struct ssl_st;
+struct ssl_ctx_st;
+
+#define TLS_TICKET_KEY_SIZE 80          ///< Key name, HMAC secret and AES key of session tickets
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Handshake progress
+    enum class TlsHandshake
+    {
+        Complete,                   ///< Keys are set, application data may flow
+        WantRead,                   ///< Waiting for the client
+        WantWrite,                  ///< Socket buffer is full
+        Failed                      ///< Handshake failed, close down socket
+    };
+
+    /// Certificate, session cache and ticket keys shared by every connection of a Listener
+    /// Sharing them lets a client resume its session on any NetworkThread, a shared ticket key file
+    /// lets it resume on another process too
+    class TlsContext
+    {
+        DISALLOW_COPY_AND_ASSIGN(TlsContext);
+
+        public:
+            /// Set up a context, null on failure
+            /// @p_Settings : Settings
+            static std::shared_ptr<TlsContext> Create(TlsSettings const& p_Settings);
+            /// Deconstructor
+            ~TlsContext();
+
+            /// Get the OpenSSL context
+            ssl_ctx_st* GetContext() const;
+            /// Check if connections try to hand record encryption to the kernel
+            bool IsKernelTls() const;
+
+            /// Get the reason of the last failed OpenSSL call of this thread, clears it
+            static std::string GetLastError();
+
+        private:
+            /// Constructor
+            /// @p_Context   : OpenSSL context, we own it
+            /// @p_KernelTls : Connections try kTLS
+            TlsContext(ssl_ctx_st* p_Context, bool const p_KernelTls);
+
+        private:
+            ssl_ctx_st* m_Context;                                      ///< OpenSSL context
+            bool const m_KernelTls;                                     ///< Connections try kTLS
+    };
+
+    /// TLS of one connection, from its NetworkThread only
+    /// OpenSSL reads and writes the descriptor itself, so once kTLS took over record encryption the socket
+    /// sends plaintext with its usual gather writes and the kernel encrypts it without another copy
+    class TlsConnection
+    {
+        DISALLOW_COPY_AND_ASSIGN(TlsConnection);
+
+        public:
+            /// Constructor
+            /// @p_Context : Context, kept alive by the connection
+            /// @p_Fd      : Connected non blocking descriptor
+            TlsConnection(TlsContext const& p_Context, int const p_Fd);
+            /// Deconstructor
+            ~TlsConnection();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Check if the connection could be set up
+            bool IsValid() const;
+            /// Make progress on the handshake
+            TlsHandshake Handshake();
+            /// Check if the handshake completed
+            bool IsEstablished() const;
+            /// Check if the client resumed an earlier session
+            bool IsResumed() const;
+            /// Check if the kernel encrypts what we send
+            bool IsKernelSend() const;
+
+            /// Read decrypted bytes, would_block once nothing is left
+            /// @p_Buffer    : Buffer
+            /// @p_Length    : Space in the buffer
+            /// @p_ErrorCode : Error code
+            std::size_t Read(uint8* p_Buffer, std::size_t const p_Length, boost::system::error_code& p_ErrorCode);
+            /// Encrypt and send bytes, returns how many went out in complete records; would_block if none did
+            /// A record left half sent is finished by the next call, which must start with the same bytes
+            /// @p_Buffer    : Buffer
+            /// @p_Length    : The length of the data
+            /// @p_ErrorCode : Error code
+            std::size_t Write(uint8 const* p_Buffer, std::size_t const p_Length, boost::system::error_code& p_ErrorCode);
+            /// Get the decrypted bytes OpenSSL holds, the descriptor does not wake us for them
+            std::size_t GetPending() const;
+
+        private:
+            /// Turn the result of an OpenSSL call into an error code
+            /// @p_Result : Return value of the call
+            boost::system::error_code GetErrorCode(int const p_Result) const;
+
+        private:
+            ssl_st* m_Ssl;                                              ///< OpenSSL connection
+            bool m_Established;                                         ///< Handshake completed
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,41 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <string>
+#include "Core/Core.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// TLS every connection of a Listener is wrapped in
+    struct TlsSettings
+    {
+        bool Enabled            = false;                    ///< Every connection starts with a TLS handshake
+        std::string CertificateFile;                        ///< PEM certificate chain
+        std::string PrivateKeyFile;                         ///< PEM private key
+        std::string TicketKeyFile;                          ///< 80 byte session ticket key, shared by every server a client may resume on; empty uses a random key of our own
+        uint32 SessionCacheSize = 20480;                    ///< Sessions kept for TLS 1.2 session id resumption
+        uint32 SessionTimeout   = 7200;                     ///< Seconds a session or ticket may be resumed for
+        uint32 Tickets          = 2;                        ///< TLS 1.3 tickets sent after a full handshake
+        bool KernelTls          = true;                     ///< Hand record encryption to the kernel (kTLS) after the handshake, when it supports it
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,597 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <openssl/evp.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define WEBSOCKET_HAS_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define WEBSOCKET_HAS_NEON
+#endif
+
+#include "WebSocket.hpp"
+#include "Logger/Base.hpp"
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Remove surrounding spaces
+    /// @p_String : String
+    static std::string Trim(std::string const& p_String)
+    {
+        const std::size_t l_Begin = p_String.find_first_not_of(" \t");
+        if (l_Begin == std::string::npos)
+            return std::string();
+
+        return p_String.substr(l_Begin, p_String.find_last_not_of(" \t") - l_Begin + 1);
+    }
+    /// Compare two strings, ignoring case
+    /// @p_Left  : String
+    /// @p_Right : String
+    static bool EqualsNoCase(std::string const& p_Left, std::string const& p_Right)
+    {
+        return p_Left.size() == p_Right.size() && std::equal(p_Left.begin(), p_Left.end(), p_Right.begin(), [](char p_A, char p_B)
+        {
+            return std::tolower(static_cast<unsigned char>(p_A)) == std::tolower(static_cast<unsigned char>(p_B));
+        });
+    }
+    /// Check if a comma separated header value holds a token, ignoring case
+    /// @p_Value : Header value
+    /// @p_Token : Token
+    static bool HasTokenNoCase(std::string const& p_Value, std::string const& p_Token)
+    {
+        std::size_t l_Begin = 0;
+        while (l_Begin <= p_Value.size())
+        {
+            std::size_t l_End = p_Value.find(',', l_Begin);
+            if (l_End == std::string::npos)
+                l_End = p_Value.size();
+
+            if (EqualsNoCase(Trim(p_Value.substr(l_Begin, l_End - l_Begin)), p_Token))
+                return true;
+
+            l_Begin = l_End + 1;
+        }
+
+        return false;
+    }
+    /// Append a value to a saved state
+    /// @p_State : State
+    /// @p_Value : Value
+    template <typename T> static void AppendState(std::vector<uint8>& p_State, T const& p_Value)
+    {
+        uint8 const* l_Bytes = reinterpret_cast<uint8 const*>(&p_Value);
+        p_State.insert(p_State.end(), l_Bytes, l_Bytes + sizeof(T));
+    }
+    /// Read a value from a saved state
+    /// @p_State    : State
+    /// @p_Position : Read position, moved past the value
+    /// @p_Value    : Value
+    template <typename T> static bool ExtractState(std::vector<uint8> const& p_State, std::size_t& p_Position, T& p_Value)
+    {
+        if (p_State.size() - p_Position < sizeof(T))
+            return false;
+
+        std::memcpy(&p_Value, p_State.data() + p_Position, sizeof(T));
+        p_Position += sizeof(T);
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    WebSocket::WebSocket()
+        : m_HeaderSize(0), m_Opcode(WebSocketOpcode::Continuation), m_PayloadRemaining(0), m_PayloadOffset(0),
+        m_InFrame(false), m_InMessage(false), m_Closing(false), m_HeadSent(0), m_FrameRemaining(0)
+    {
+        std::memset(m_Header, 0, sizeof(m_Header));
+        std::memset(m_Mask, 0, sizeof(m_Mask));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Check if the first bytes of a connection may be an upgrade request, true while they match the start of WEBSOCKET_UPGRADE_METHOD
+    /// @p_Data   : First bytes
+    /// @p_Length : The length of the data
+    bool WebSocket::IsUpgradeRequest(uint8 const* p_Data, std::size_t const p_Length)
+    {
+        return std::memcmp(p_Data, WEBSOCKET_UPGRADE_METHOD, std::min<std::size_t>(p_Length, WEBSOCKET_UPGRADE_METHOD_SIZE)) == 0;
+    }
+    /// Parse an upgrade request
+    /// @p_Data     : Received bytes
+    /// @p_Length   : The length of the data
+    /// @p_Response : Response to send, when accepted
+    /// @p_Consumed : Length of the request, when accepted
+    WebSocketHandshake WebSocket::ParseHandshake(uint8 const* p_Data, std::size_t const p_Length, std::string& p_Response, std::size_t& p_Consumed)
+    {
+        static char const s_Terminator[] = "\r\n\r\n";
+
+        const char* l_Begin = reinterpret_cast<const char*>(p_Data);
+        const char* l_End   = std::search(l_Begin, l_Begin + p_Length, s_Terminator, s_Terminator + 4);
+
+        if (l_End == l_Begin + p_Length)
+            return WebSocketHandshake::Incomplete;
+
+        p_Consumed = l_End + 4 - l_Begin;
+
+        /// Request line, then one header per line
+        std::string const l_Request(l_Begin, l_End + 2);
+        std::size_t l_LineEnd = l_Request.find("\r\n");
+
+        std::string const l_RequestLine = l_Request.substr(0, l_LineEnd);
+        if (l_RequestLine.compare(0, WEBSOCKET_UPGRADE_METHOD_SIZE, WEBSOCKET_UPGRADE_METHOD) != 0
+            || l_RequestLine.size() < 9 || l_RequestLine.compare(l_RequestLine.size() - 9, 9, " HTTP/1.1") != 0)
+            return WebSocketHandshake::Rejected;
+
+        bool l_Upgrade      = false;
+        bool l_Connection   = false;
+        bool l_Version      = false;
+        std::string l_Key;
+
+        for (std::size_t l_LineBegin = l_LineEnd + 2; l_LineBegin < l_Request.size(); l_LineBegin = l_LineEnd + 2)
+        {
+            l_LineEnd = l_Request.find("\r\n", l_LineBegin);
+
+            const std::size_t l_Colon = l_Request.find(':', l_LineBegin);
+            if (l_Colon == std::string::npos || l_Colon > l_LineEnd)
+                return WebSocketHandshake::Rejected;
+
+            std::string const l_Name  = Trim(l_Request.substr(l_LineBegin, l_Colon - l_LineBegin));
+            std::string const l_Value = Trim(l_Request.substr(l_Colon + 1, l_LineEnd - l_Colon - 1));
+
+            if (EqualsNoCase(l_Name, "Upgrade"))
+                l_Upgrade = HasTokenNoCase(l_Value, "websocket");
+            else if (EqualsNoCase(l_Name, "Connection"))
+                l_Connection = HasTokenNoCase(l_Value, "Upgrade");
+            else if (EqualsNoCase(l_Name, "Sec-WebSocket-Version"))
+                l_Version = l_Value == "13";
+            else if (EqualsNoCase(l_Name, "Sec-WebSocket-Key"))
+                l_Key = l_Value;
+        }
+
+        /// The key is 16 random bytes in base64
+        if (!l_Upgrade || !l_Connection || !l_Version || l_Key.size() != 24)
+            return WebSocketHandshake::Rejected;
+
+        p_Response = "HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: " + GetAcceptKey(l_Key) + "\r\n\r\n";
+
+        return WebSocketHandshake::Accepted;
+    }
+    /// Get the Sec-WebSocket-Accept value of a key
+    /// @p_Key : Sec-WebSocket-Key of the client
+    std::string WebSocket::GetAcceptKey(std::string const& p_Key)
+    {
+        std::string const l_Input = p_Key + WEBSOCKET_GUID;
+
+        unsigned char l_Digest[EVP_MAX_MD_SIZE];
+        unsigned int l_DigestLength = 0;
+
+        if (!EVP_Digest(l_Input.data(), l_Input.size(), l_Digest, &l_DigestLength, EVP_sha1(), nullptr))
+            return std::string();
+
+        char l_Encoded[((EVP_MAX_MD_SIZE + 2) / 3) * 4 + 1];
+        const int l_Length = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(l_Encoded), l_Digest, static_cast<int>(l_DigestLength));
+
+        return std::string(l_Encoded, l_Length);
+    }
+    /// XOR a masked payload into p_Destination, p_Destination may be p_Source or before it
+    /// Every block is loaded before it is stored, so unmasking towards the front of the same buffer never reads a byte it already wrote
+    /// @p_Destination : Unmasked bytes
+    /// @p_Source      : Masked bytes
+    /// @p_Length      : The length of the data
+    /// @p_Mask        : Masking key of the frame
+    /// @p_Offset      : Payload bytes of the frame unmasked before these
+    void WebSocket::Unmask(uint8* p_Destination, uint8 const* p_Source, std::size_t const p_Length, uint8 const* p_Mask, std::size_t const p_Offset)
+    {
+        /// Key rotated to line up with p_Source[0], every block below starts on a multiple of 4
+        uint8 l_Key[4];
+        for (std::size_t l_I = 0; l_I < 4; l_I++)
+            l_Key[l_I] = p_Mask[(p_Offset + l_I) & 3];
+
+        uint32 l_Key32;
+        std::memcpy(&l_Key32, l_Key, sizeof(l_Key32));
+
+        std::size_t l_I = 0;
+
+    #if defined(WEBSOCKET_HAS_SSE2)
+        const __m128i l_Key128 = _mm_set1_epi32(static_cast<int>(l_Key32));
+        for (; l_I + 16 <= p_Length; l_I += 16)
+        {
+            const __m128i l_Block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p_Source + l_I));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p_Destination + l_I), _mm_xor_si128(l_Block, l_Key128));
+        }
+    #elif defined(WEBSOCKET_HAS_NEON)
+        const uint8x16_t l_Key128 = vreinterpretq_u8_u32(vdupq_n_u32(l_Key32));
+        for (; l_I + 16 <= p_Length; l_I += 16)
+            vst1q_u8(p_Destination + l_I, veorq_u8(vld1q_u8(p_Source + l_I), l_Key128));
+    #endif
+
+        const uint64 l_Key64 = static_cast<uint64>(l_Key32) | (static_cast<uint64>(l_Key32) << 32);
+        for (; l_I + 8 <= p_Length; l_I += 8)
+        {
+            uint64 l_Word;
+            std::memcpy(&l_Word, p_Source + l_I, sizeof(l_Word));
+            l_Word ^= l_Key64;
+            std::memcpy(p_Destination + l_I, &l_Word, sizeof(l_Word));
+        }
+
+        for (; l_I < p_Length; l_I++)
+            p_Destination[l_I] = p_Source[l_I] ^ l_Key[l_I & 3];
+    }
+    /// Write the header of a server frame, returns its length
+    /// Server frames are never masked and use the shortest length encoding
+    /// @p_Header : At least WEBSOCKET_MAX_HEADER_SIZE bytes
+    /// @p_Opcode : Opcode
+    /// @p_Length : Payload length
+    std::size_t WebSocket::WriteHeader(uint8* p_Header, WebSocketOpcode const p_Opcode, uint64 const p_Length)
+    {
+        p_Header[0] = 0x80 | static_cast<uint8>(p_Opcode);
+
+        if (p_Length < 126)
+        {
+            p_Header[1] = static_cast<uint8>(p_Length);
+            return 2;
+        }
+
+        if (p_Length <= 0xFFFF)
+        {
+            p_Header[1] = 126;
+            p_Header[2] = static_cast<uint8>(p_Length >> 8);
+            p_Header[3] = static_cast<uint8>(p_Length);
+            return 4;
+        }
+
+        p_Header[1] = 127;
+        for (std::size_t l_I = 0; l_I < 8; l_I++)
+            p_Header[2 + l_I] = static_cast<uint8>(p_Length >> (56 - l_I * 8));
+
+        return 10;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Decode received bytes in place, from our NetworkThread only
+    /// Payloads are packed to the front of p_Data, header bytes of a frame which has not fully arrived are kept aside
+    /// @p_Data    : Received bytes
+    /// @p_Length  : The length of the data
+    /// @p_Payload : Payload bytes now at the front of p_Data
+    WebSocketDecode WebSocket::Decode(uint8* p_Data, std::size_t const p_Length, std::size_t& p_Payload)
+    {
+        p_Payload = 0;
+
+        /// Anything sent after a close frame is ignored
+        if (m_Closing)
+            return WebSocketDecode::Closing;
+
+        std::size_t l_Read = 0;
+
+        while (l_Read < p_Length)
+        {
+            if (!m_InFrame)
+            {
+                std::size_t l_HeaderSize = GetHeaderSize();
+                while (m_HeaderSize < l_HeaderSize && l_Read < p_Length)
+                {
+                    const std::size_t l_Copy = std::min(l_HeaderSize - m_HeaderSize, p_Length - l_Read);
+                    std::memcpy(m_Header + m_HeaderSize, p_Data + l_Read, l_Copy);
+
+                    m_HeaderSize    += l_Copy;
+                    l_Read          += l_Copy;
+                    l_HeaderSize     = GetHeaderSize();
+                }
+
+                /// Rest of the header comes with the next read
+                if (m_HeaderSize < l_HeaderSize)
+                    break;
+
+                if (!ParseHeader())
+                    return WebSocketDecode::Error;
+            }
+
+            const std::size_t l_Take = static_cast<std::size_t>(std::min<uint64>(m_PayloadRemaining, p_Length - l_Read));
+
+            if (static_cast<uint8>(m_Opcode) & 0x8)
+            {
+                const std::size_t l_Size = m_ControlPayload.size();
+                m_ControlPayload.resize(l_Size + l_Take);
+                Unmask(m_ControlPayload.data() + l_Size, p_Data + l_Read, l_Take, m_Mask, m_PayloadOffset);
+            }
+            else
+            {
+                /// Packed behind the payloads before it, never past l_Read
+                Unmask(p_Data + p_Payload, p_Data + l_Read, l_Take, m_Mask, m_PayloadOffset);
+                p_Payload += l_Take;
+            }
+
+            l_Read              += l_Take;
+            m_PayloadOffset     += l_Take;
+            m_PayloadRemaining  -= l_Take;
+
+            if (m_PayloadRemaining)
+                break;
+
+            m_InFrame = false;
+
+            const WebSocketDecode l_Decode = EndFrame();
+            if (l_Decode != WebSocketDecode::Successful)
+                return l_Decode;
+        }
+
+        return WebSocketDecode::Successful;
+    }
+    /// Check if the close handshake started, input is ignored and no more data is sent
+    bool WebSocket::IsClosing() const
+    {
+        return m_Closing;
+    }
+
+    /// Queue bytes which go out as they are before the next frame, socket lock must be held
+    /// @p_Data   : Data
+    /// @p_Length : The length of the data
+    void WebSocket::QueueRaw(uint8 const* p_Data, std::size_t const p_Length)
+    {
+        m_Pending.insert(m_Pending.end(), p_Data, p_Data + p_Length);
+    }
+    /// Check if control frames or a frame header are waiting to be sent, socket lock must be held
+    bool WebSocket::HasOutput() const
+    {
+        return m_HeadSent < m_Head.size() || m_FrameRemaining || !m_Pending.empty();
+    }
+    /// Append the spans of the next write, starting a binary frame around the queued data at a frame boundary
+    /// Socket lock must be held
+    /// @p_Queue : Out queue of the socket
+    /// @p_Spans : Spans are pushed to the back of this
+    void WebSocket::GetSpans(OutboundQueue& p_Queue, std::vector<boost::asio::const_buffer>& p_Spans)
+    {
+        if (m_HeadSent == m_Head.size() && !m_FrameRemaining)
+        {
+            /// Control frames go out between data frames, the swap keeps the capacity of both
+            m_Head.clear();
+            m_Head.swap(m_Pending);
+            m_HeadSent = 0;
+
+            /// Nothing may follow our close frame
+            if (!m_Closing)
+                m_FrameRemaining = p_Queue.GetSize();
+
+            if (m_FrameRemaining)
+            {
+                uint8 l_Header[WEBSOCKET_MAX_HEADER_SIZE];
+                m_Head.insert(m_Head.end(), l_Header, l_Header + WriteHeader(l_Header, WebSocketOpcode::Binary, m_FrameRemaining));
+            }
+        }
+
+        if (m_HeadSent < m_Head.size())
+            p_Spans.push_back(boost::asio::const_buffer(m_Head.data() + m_HeadSent, m_Head.size() - m_HeadSent));
+
+        if (!m_FrameRemaining)
+            return;
+
+        /// Messages queued after the frame started belong to the next one
+        const std::size_t l_First = p_Spans.size();
+        p_Queue.GetSpans(p_Spans);
+
+        std::size_t l_Left = m_FrameRemaining;
+        for (std::size_t l_I = l_First; l_I < p_Spans.size(); l_I++)
+        {
+            if (!l_Left)
+            {
+                p_Spans.resize(l_I);
+                break;
+            }
+
+            if (p_Spans[l_I].size() > l_Left)
+                p_Spans[l_I] = boost::asio::const_buffer(p_Spans[l_I].data(), l_Left);
+
+            l_Left -= p_Spans[l_I].size();
+        }
+    }
+    /// Account sent bytes, returns how many of them came from the out queue; socket lock must be held
+    /// @p_Length : Bytes sent
+    std::size_t WebSocket::Consume(std::size_t const p_Length)
+    {
+        const std::size_t l_Head = std::min(p_Length, m_Head.size() - m_HeadSent);
+        m_HeadSent += l_Head;
+
+        const std::size_t l_Data = p_Length - l_Head;
+        LOG_ASSERT(l_Data <= m_FrameRemaining, "WebSocket", "Sent more than the current frame holds!");
+
+        m_FrameRemaining -= l_Data;
+        return l_Data;
+    }
+
+    /// Copy our state, only valid between frames of output
+    /// @p_State : State is appended to it
+    void WebSocket::SaveState(std::vector<uint8>& p_State) const
+    {
+        AppendState(p_State, m_HeaderSize);
+        p_State.insert(p_State.end(), m_Header, m_Header + sizeof(m_Header));
+        AppendState(p_State, m_Opcode);
+        p_State.insert(p_State.end(), m_Mask, m_Mask + sizeof(m_Mask));
+        AppendState(p_State, m_PayloadRemaining);
+        AppendState(p_State, m_PayloadOffset);
+        AppendState(p_State, m_InFrame);
+        AppendState(p_State, m_InMessage);
+        AppendState(p_State, m_Closing);
+
+        AppendState(p_State, static_cast<uint32>(m_ControlPayload.size()));
+        p_State.insert(p_State.end(), m_ControlPayload.begin(), m_ControlPayload.end());
+        AppendState(p_State, static_cast<uint32>(m_Pending.size()));
+        p_State.insert(p_State.end(), m_Pending.begin(), m_Pending.end());
+    }
+    /// Restore a state saved by SaveState
+    /// @p_State : State
+    bool WebSocket::LoadState(std::vector<uint8> const& p_State)
+    {
+        std::size_t l_Position = 0;
+        uint32 l_ControlSize = 0;
+        uint32 l_PendingSize = 0;
+
+        if (!ExtractState(p_State, l_Position, m_HeaderSize) || m_HeaderSize > sizeof(m_Header)
+            || p_State.size() - l_Position < sizeof(m_Header))
+            return false;
+
+        std::memcpy(m_Header, p_State.data() + l_Position, sizeof(m_Header));
+        l_Position += sizeof(m_Header);
+
+        if (!ExtractState(p_State, l_Position, m_Opcode) || p_State.size() - l_Position < sizeof(m_Mask))
+            return false;
+
+        std::memcpy(m_Mask, p_State.data() + l_Position, sizeof(m_Mask));
+        l_Position += sizeof(m_Mask);
+
+        if (!ExtractState(p_State, l_Position, m_PayloadRemaining) || !ExtractState(p_State, l_Position, m_PayloadOffset)
+            || !ExtractState(p_State, l_Position, m_InFrame) || !ExtractState(p_State, l_Position, m_InMessage)
+            || !ExtractState(p_State, l_Position, m_Closing) || !ExtractState(p_State, l_Position, l_ControlSize)
+            || p_State.size() - l_Position < l_ControlSize)
+            return false;
+
+        m_ControlPayload.assign(p_State.begin() + l_Position, p_State.begin() + l_Position + l_ControlSize);
+        l_Position += l_ControlSize;
+
+        if (!ExtractState(p_State, l_Position, l_PendingSize) || p_State.size() - l_Position != l_PendingSize)
+            return false;
+
+        m_Pending.assign(p_State.begin() + l_Position, p_State.end());
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get the size of the frame header being received, known once its first 2 bytes arrived
+    std::size_t WebSocket::GetHeaderSize() const
+    {
+        if (m_HeaderSize < 2)
+            return 2;
+
+        const uint8 l_Length = m_Header[1] & 0x7F;
+
+        return 2 + (l_Length == 126 ? 2 : l_Length == 127 ? 8 : 0) + ((m_Header[1] & 0x80) ? 4 : 0);
+    }
+    /// Parse the header of the next frame once all of it arrived, false on a protocol violation
+    bool WebSocket::ParseHeader()
+    {
+        const bool l_Final          = (m_Header[0] & 0x80) != 0;
+        const uint8 l_Opcode        = m_Header[0] & 0x0F;
+        const uint8 l_Length        = m_Header[1] & 0x7F;
+        std::size_t l_Position      = 2;
+
+        m_HeaderSize = 0;
+
+        /// No extension was negotiated, and clients must mask everything they send
+        if ((m_Header[0] & 0x70) || !(m_Header[1] & 0x80))
+            return false;
+
+        switch (static_cast<WebSocketOpcode>(l_Opcode))
+        {
+            case WebSocketOpcode::Continuation:
+                if (!m_InMessage)
+                    return false;
+                m_InMessage = !l_Final;
+                break;
+            case WebSocketOpcode::Text:
+            case WebSocketOpcode::Binary:
+                if (m_InMessage)
+                    return false;
+                m_InMessage = !l_Final;
+                break;
+            case WebSocketOpcode::Close:
+            case WebSocketOpcode::Ping:
+            case WebSocketOpcode::Pong:
+                if (!l_Final || l_Length > WEBSOCKET_MAX_CONTROL_SIZE)
+                    return false;
+                m_ControlPayload.clear();
+                break;
+            default:
+                return false;
+        }
+
+        m_PayloadRemaining = l_Length;
+
+        if (l_Length == 126)
+        {
+            m_PayloadRemaining = (static_cast<uint64>(m_Header[2]) << 8) | m_Header[3];
+            l_Position = 4;
+        }
+        else if (l_Length == 127)
+        {
+            m_PayloadRemaining = 0;
+            for (std::size_t l_I = 0; l_I < 8; l_I++)
+                m_PayloadRemaining = (m_PayloadRemaining << 8) | m_Header[2 + l_I];
+
+            /// Most significant bit must be 0
+            if (m_PayloadRemaining >> 63)
+                return false;
+
+            l_Position = 10;
+        }
+
+        std::memcpy(m_Mask, m_Header + l_Position, sizeof(m_Mask));
+
+        m_Opcode        = static_cast<WebSocketOpcode>(l_Opcode);
+        m_PayloadOffset = 0;
+        m_InFrame       = true;
+
+        return true;
+    }
+    /// Handle a frame whose payload fully arrived
+    WebSocketDecode WebSocket::EndFrame()
+    {
+        switch (m_Opcode)
+        {
+            case WebSocketOpcode::Ping:
+                if (m_Pending.size() < WEBSOCKET_MAX_PENDING_SIZE)
+                    QueueControl(WebSocketOpcode::Pong, m_ControlPayload.data(), m_ControlPayload.size());
+                break;
+            case WebSocketOpcode::Close:
+                /// Echo the status code, our reason is empty
+                QueueControl(WebSocketOpcode::Close, m_ControlPayload.data(), std::min<std::size_t>(m_ControlPayload.size(), 2));
+                m_Closing = true;
+                return WebSocketDecode::Closing;
+            default:
+                break;
+        }
+
+        return WebSocketDecode::Successful;
+    }
+    /// Queue a control frame
+    /// @p_Opcode  : Opcode
+    /// @p_Payload : Payload
+    /// @p_Length  : Payload length
+    void WebSocket::QueueControl(WebSocketOpcode const p_Opcode, uint8 const* p_Payload, std::size_t const p_Length)
+    {
+        uint8 l_Header[WEBSOCKET_MAX_HEADER_SIZE];
+        m_Pending.insert(m_Pending.end(), l_Header, l_Header + WriteHeader(l_Header, p_Opcode, p_Length));
+        m_Pending.insert(m_Pending.end(), p_Payload, p_Payload + p_Length);
+    }
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -0,0 +1,176 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <PCH/Precompiled.hpp>
+#include <boost/asio.hpp>
+#include <string>
+#include <vector>
+
+#include "Core/Core.hpp"
+#include "OutboundQueue.hpp"
+
+#define WEBSOCKET_MAX_HANDSHAKE_SIZE 8192       ///< Largest upgrade request we wait for
+#define WEBSOCKET_MAX_HEADER_SIZE 14            ///< Largest frame header, 64 bit length and mask
+#define WEBSOCKET_MAX_CONTROL_SIZE 125          ///< Largest control frame payload
+#define WEBSOCKET_MAX_PENDING_SIZE 4096         ///< Control frames held while the client does not read, pings past it go unanswered
+#define WEBSOCKET_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"  ///< Appended to the key of the client to get the accept key
+#define WEBSOCKET_UPGRADE_METHOD "GET "         ///< Start of every upgrade request
+#define WEBSOCKET_UPGRADE_METHOD_SIZE 4
+
+namespace SteerStone { namespace Core { namespace Network {
+
+    /// Frame opcodes
+    enum class WebSocketOpcode : uint8
+    {
+        Continuation    = 0x0,      ///< Next fragment of a message
+        Text            = 0x1,      ///< Text message
+        Binary          = 0x2,      ///< Binary message
+        Close           = 0x8,      ///< Close handshake
+        Ping            = 0x9,      ///< Ping, answered by a pong
+        Pong            = 0xA       ///< Pong
+    };
+
+    /// Outcome of an upgrade request
+    enum class WebSocketHandshake
+    {
+        Incomplete,                 ///< Request has not fully arrived
+        Accepted,                   ///< Valid upgrade request, the response is ready
+        Rejected                    ///< Not a WebSocket upgrade request
+    };
+
+    /// Outcome of decoding received bytes
+    enum class WebSocketDecode
+    {
+        Successful,                 ///< Payloads decoded
+        Closing,                    ///< Client started the close handshake, the reply is queued
+        Error                       ///< Protocol violation, close down socket
+    };
+
+    /// WebSocket transport of one socket (RFC 6455)
+    /// Game frames are a byte stream, WebSocket message boundaries carry no meaning for them: received
+    /// payloads are unmasked and packed together in place in the in buffer, so the game sees the same
+    /// bytes it would over raw TCP. Output is framed when it is sent; every write starts one binary
+    /// frame around whatever is queued, control frames go out between data frames
+    class WebSocket
+    {
+        DISALLOW_COPY_AND_ASSIGN(WebSocket);
+
+        public:
+            /// Constructor
+            WebSocket();
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Check if the first bytes of a connection may be an upgrade request, true while they match the start of WEBSOCKET_UPGRADE_METHOD
+            /// "GET" read as a base64 length is 29012, larger than any game frame, so raw clients never start with it
+            /// @p_Data   : First bytes
+            /// @p_Length : The length of the data
+            static bool IsUpgradeRequest(uint8 const* p_Data, std::size_t const p_Length);
+            /// Parse an upgrade request
+            /// @p_Data     : Received bytes
+            /// @p_Length   : The length of the data
+            /// @p_Response : Response to send, when accepted
+            /// @p_Consumed : Length of the request, when accepted
+            static WebSocketHandshake ParseHandshake(uint8 const* p_Data, std::size_t const p_Length, std::string& p_Response, std::size_t& p_Consumed);
+            /// Get the Sec-WebSocket-Accept value of a key
+            /// @p_Key : Sec-WebSocket-Key of the client
+            static std::string GetAcceptKey(std::string const& p_Key);
+            /// XOR a masked payload into p_Destination, p_Destination may be p_Source or before it
+            /// @p_Destination : Unmasked bytes
+            /// @p_Source      : Masked bytes
+            /// @p_Length      : The length of the data
+            /// @p_Mask        : Masking key of the frame
+            /// @p_Offset      : Payload bytes of the frame unmasked before these
+            static void Unmask(uint8* p_Destination, uint8 const* p_Source, std::size_t const p_Length, uint8 const* p_Mask, std::size_t const p_Offset);
+            /// Write the header of a server frame, returns its length
+            /// @p_Header : At least WEBSOCKET_MAX_HEADER_SIZE bytes
+            /// @p_Opcode : Opcode
+            /// @p_Length : Payload length
+            static std::size_t WriteHeader(uint8* p_Header, WebSocketOpcode const p_Opcode, uint64 const p_Length);
+
+            //////////////////////////////////////////////////////////////////////////
+            //////////////////////////////////////////////////////////////////////////
+
+            /// Decode received bytes in place, from our NetworkThread only
+            /// Payloads are packed to the front of p_Data, header bytes of a frame which has not fully arrived are kept aside
+            /// @p_Data    : Received bytes
+            /// @p_Length  : The length of the data
+            /// @p_Payload : Payload bytes now at the front of p_Data
+            WebSocketDecode Decode(uint8* p_Data, std::size_t const p_Length, std::size_t& p_Payload);
+            /// Check if the close handshake started, input is ignored and no more data is sent
+            bool IsClosing() const;
+
+            /// Queue bytes which go out as they are before the next frame, socket lock must be held
+            /// @p_Data   : Data
+            /// @p_Length : The length of the data
+            void QueueRaw(uint8 const* p_Data, std::size_t const p_Length);
+            /// Check if control frames or a frame header are waiting to be sent, socket lock must be held
+            bool HasOutput() const;
+            /// Append the spans of the next write, starting a binary frame around the queued data at a frame boundary
+            /// Socket lock must be held
+            /// @p_Queue : Out queue of the socket
+            /// @p_Spans : Spans are pushed to the back of this
+            void GetSpans(OutboundQueue& p_Queue, std::vector<boost::asio::const_buffer>& p_Spans);
+            /// Account sent bytes, returns how many of them came from the out queue; socket lock must be held
+            /// @p_Length : Bytes sent
+            std::size_t Consume(std::size_t const p_Length);
+
+            /// Copy our state, only valid between frames of output
+            /// @p_State : State is appended to it
+            void SaveState(std::vector<uint8>& p_State) const;
+            /// Restore a state saved by SaveState
+            /// @p_State : State
+            bool LoadState(std::vector<uint8> const& p_State);
+
+        private:
+            /// Get the size of the frame header being received, known once its first 2 bytes arrived
+            std::size_t GetHeaderSize() const;
+            /// Parse the header of the next frame once all of it arrived, false on a protocol violation
+            bool ParseHeader();
+            /// Handle a frame whose payload fully arrived
+            WebSocketDecode EndFrame();
+            /// Queue a control frame
+            /// @p_Opcode  : Opcode
+            /// @p_Payload : Payload
+            /// @p_Length  : Payload length
+            void QueueControl(WebSocketOpcode const p_Opcode, uint8 const* p_Payload, std::size_t const p_Length);
+
+        private:
+            /// Input, from our NetworkThread only
+            uint8 m_Header[WEBSOCKET_MAX_HEADER_SIZE];                  ///< Header bytes of the next frame
+            std::size_t m_HeaderSize;                                   ///< Header bytes received
+            WebSocketOpcode m_Opcode;                                   ///< Opcode of the frame being received
+            uint8 m_Mask[4];                                            ///< Masking key of the frame being received
+            uint64 m_PayloadRemaining;                                  ///< Payload bytes of the frame still to arrive
+            uint64 m_PayloadOffset;                                     ///< Payload bytes of the frame received
+            bool m_InFrame;                                             ///< Header parsed, payload arriving
+            bool m_InMessage;                                           ///< Fragmented message waiting for its continuation
+            std::vector<uint8> m_ControlPayload;                        ///< Payload of the control frame being received
+            bool m_Closing;                                             ///< Close handshake started
+            /// Output, socket lock held
+            std::vector<uint8> m_Pending;                               ///< Raw bytes and control frames waiting for a frame boundary
+            std::vector<uint8> m_Head;                                  ///< Bytes sent ahead of the current frame; control frames and its header
+            std::size_t m_HeadSent;                                     ///< Bytes of m_Head sent
+            std::size_t m_FrameRemaining;                               ///< Queued bytes of the current frame not sent yet
+    };
+
+}   ///< namespace Network
+}   ///< namespace Core
+}   ///< namespace Steerstone
@@ -29,7 +29,7 @@ namespace SteerStone { namespace Core { namespace Threading {
     /// @p_Name     : Task name
     /// @p_TaskType : Task type
     Task::Task(const std::string & p_Name, TaskType p_TaskType)
-        : m_TaskName(p_Name), m_TaskType(p_TaskType), m_TaskTimer(-1), m_TaskTotalRunTime(0), m_TaskTotalRunCount(0), m_TaskAverageRunTime(0), m_TaskLastDiffTime(0)
+        : m_TaskName(p_Name), m_TaskType(p_TaskType), m_CacheDomain(-1), m_TaskTimer(-1), m_TaskTotalRunTime(0), m_TaskTotalRunCount(0), m_TaskAverageRunTime(0), m_TaskLastDiffTime(0)
     {
         m_TaskStopWatch.Start();
     }
@@ -48,6 +48,12 @@ namespace SteerStone { namespace Core { namespace Threading {
     {
         m_TaskType = p_TaskType;
     }
+    /// Set the cache domain a Moderate task would rather run on
+    /// @p_CacheDomain : Cache domain, see Topology, -1 for any
+    void Task::SetCacheDomain(int32 p_CacheDomain)
+    {
+        m_CacheDomain = p_CacheDomain;
+    }
 
     /// Get name
     const std::string& Task::GetTaskName()
@@ -59,6 +65,11 @@ namespace SteerStone { namespace Core { namespace Threading {
     {
         return m_TaskType;
     }
+    /// Get the cache domain the task would rather run on, -1 for any
+    int32 Task::GetCacheDomain() const
+    {
+        return m_CacheDomain;
+    }
     /// Get flags
     uint64 Task::GetTaskTotalRunTime() const
     {
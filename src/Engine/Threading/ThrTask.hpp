@@ -61,11 +61,16 @@ namespace SteerStone { namespace Core { namespace Threading {
             /// Set Task
             /// @p_TaskType : Task type
             void SetTaskType(TaskType p_TaskType);
+            /// Set the cache domain a Moderate task would rather run on
+            /// @p_CacheDomain : Cache domain, see Topology, -1 for any
+            void SetCacheDomain(int32 p_CacheDomain);
 
             /// Get name
             const std::string & GetTaskName();
             /// Get flags
             TaskType GetTaskType() const;
+            /// Get the cache domain the task would rather run on, -1 for any
+            int32 GetCacheDomain() const;
             /// Get flags
             uint64 GetTaskTotalRunTime() const;
             /// Get flags
@@ -90,6 +95,7 @@ namespace SteerStone { namespace Core { namespace Threading {
         private:
             std::string m_TaskName;     ///< Name
             TaskType    m_TaskType;     ///< Type
+            int32       m_CacheDomain;  ///< Preferred cache domain, -1 for any
             int64       m_TaskTimer;    ///< Time until next execution in MS
 
             std::atomic_uint64_t m_TaskTotalRunTime;    ///< Total run time
@@ -71,8 +71,8 @@ namespace SteerStone { namespace Core { namespace Threading {
         {
             TaskWorker * l_CriticalWorker = new TaskWorker(WorkerType::Exclusive);
 
-            /// Skip CPU 0 at first iteration, to save some CPU for the kernel
-            l_CriticalWorker->SetCPUAffinty((m_CriticalTaskWorkers.size() + 1) % std::thread::hardware_concurrency());
+            /// Take the cores the pool workers left over before doubling up
+            l_CriticalWorker->SetCPUAffinty(sTopology->GetWorkerCPU(m_ExclusiveTaskWorkers.size() + m_InclusiveTaskWorkers.size() + m_CriticalTaskWorkers.size()));
             l_CriticalWorker->SetName(Utils::StringBuilder("CriticalTaskWorker_%0", m_CriticalTaskWorkers.size()));
             l_CriticalWorker->PushTask(p_Task);
 
@@ -80,12 +80,32 @@ namespace SteerStone { namespace Core { namespace Threading {
         }
         else if (p_Task->GetTaskType() == TaskType::Moderate)
         {
+            const int32 l_CacheDomain = p_Task->GetCacheDomain();
+
+            /// Tasks sharing data want to share a last level cache too, so look in their domain first
+            if (l_CacheDomain >= 0)
+            {
+                for (std::size_t l_I = 0; l_I < m_ExclusiveTaskWorkers.size(); l_I++)
+                {
+                    TaskWorker* l_CurrentWorker = m_ExclusiveTaskWorkers[l_I];
+
+                    if (l_CurrentWorker->GetTaskSize() == 0 && sTopology->GetCacheDomain(l_CurrentWorker->GetCPUAffinity()) == l_CacheDomain)
+                    {
+                        l_CurrentWorker->PushTask(p_Task);
+                        return;
+                    }
+                }
+            }
+
             for (std::size_t l_I = 0; l_I < m_ExclusiveTaskWorkers.size(); l_I++)
             {
                 TaskWorker* l_CurrentWorker = m_ExclusiveTaskWorkers[l_I];
 
                 if (l_CurrentWorker->GetTaskSize() == 0)
                 {
+                    if (l_CacheDomain >= 0)
+                        LOG_WARNING("ThrTaskManager", "No exclusive worker left on cache domain %0, task %1 runs on CPU %2", l_CacheDomain, p_Task->GetTaskName(), l_CurrentWorker->GetCPUAffinity());
+
                     l_CurrentWorker->PushTask(p_Task);
                     return;
                 }
@@ -122,10 +142,12 @@ namespace SteerStone { namespace Core { namespace Threading {
     /// @p_Name     : Task name
     /// @p_TaskType : Task Type
     /// @p_Period   : Task interval
-    /// @p_Function : Task
-    Task::Ptr TaskManager::PushTask(const std::string & p_Name, const TaskType p_TaskType, uint64 p_Period, const std::function<bool()> & p_Function)
+    /// @p_Function    : Task
+    /// @p_CacheDomain : Cache domain a Moderate task would rather run on, -1 for any
+    Task::Ptr TaskManager::PushTask(const std::string & p_Name, const TaskType p_TaskType, uint64 p_Period, const std::function<bool()> & p_Function, const int32 p_CacheDomain)
     {
         const Task::Ptr l_Task = std::make_shared<LambdaTask>(p_Name, p_TaskType, p_Period, p_Function);
+        l_Task->SetCacheDomain(p_CacheDomain);
 
         PushTask(l_Task);
 
@@ -271,7 +293,6 @@ namespace SteerStone { namespace Core { namespace Threading {
         }
         else if (p_Count > l_TaskWorkerCount)
         {
-            const uint32 l_HardwareConcurency = std::thread::hardware_concurrency() - 1;
             const uint32 l_ExclusiveCount     = std::floor(p_Count * EXLUSIVE_CURRENCY_COUNT);
 
             LOG_ASSERT(l_ExclusiveCount, "ThrTaskManager", "ERROR: MONGOOSE. Please refer to SteerStone Documentation.");
@@ -280,8 +301,8 @@ namespace SteerStone { namespace Core { namespace Threading {
             {
                 TaskWorker* l_Worker = new TaskWorker(WorkerType::Exclusive);
 
-                /// Skip CPU 0 at first iteration, to save some CPU for the kernel
-                l_Worker->SetCPUAffinty(static_cast<int32>((l_I + 1) % l_HardwareConcurency));
+                /// Exclusive workers come first so every cache domain gets some, the core of CPU 0 is left to the kernel
+                l_Worker->SetCPUAffinty(static_cast<int32>(sTopology->GetWorkerCPU(l_I)));
                 l_Worker->SetName(Utils::StringBuilder("TaskWorker_%0", l_I));
 
                 m_ExclusiveTaskWorkers.push_back(l_Worker);
@@ -293,7 +314,7 @@ namespace SteerStone { namespace Core { namespace Threading {
             {
                 TaskWorker * l_Worker = new TaskWorker(WorkerType::Inclusive);
 
-                l_Worker->SetCPUAffinty(static_cast<int32>((l_I + 1) % l_HardwareConcurency));
+                l_Worker->SetCPUAffinty(static_cast<int32>(sTopology->GetWorkerCPU(l_I)));
                 l_Worker->SetName(Utils::StringBuilder("TaskWorker_%0", l_I));
 
                 m_InclusiveTaskWorkers.push_back(l_Worker);
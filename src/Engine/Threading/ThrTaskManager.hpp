@@ -22,6 +22,7 @@
 #include "Singleton/Singleton.hpp"
 #include "Threading/ThrTaskWorker.hpp"
 #include "Threading/ThrOptimizeTask.hpp"
+#include "Threading/ThrTopology.hpp"
 
 #include <vector>
 #include <functional>
@@ -48,8 +49,9 @@ namespace SteerStone { namespace Core { namespace Threading {
             /// @p_Name     : Task name
             /// @p_TaskType : Task Type
             /// @p_Period   : Task interval
-            /// @p_Function : Task
-            Task::Ptr PushTask(const std::string & p_Name, const TaskType p_TaskType, const uint64 p_Period, const std::function<bool()> & p_Function);
+            /// @p_Function    : Task
+            /// @p_CacheDomain : Cache domain a Moderate task would rather run on, -1 for any
+            Task::Ptr PushTask(const std::string & p_Name, const TaskType p_TaskType, const uint64 p_Period, const std::function<bool()> & p_Function, const int32 p_CacheDomain = -1);
             /// Push a lambda task
             /// @p_TaskType : Task Type
             /// @p_Period   : Task interval
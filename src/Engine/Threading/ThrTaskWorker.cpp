@@ -186,6 +186,11 @@ namespace SteerStone { namespace Core { namespace Threading {
 
         Thread::SetThreadCPUAffinity(m_Thread->native_handle(), p_Affinity);
     }
+    /// Get thread CPU affinity
+    int32 TaskWorker::GetCPUAffinity() const
+    {
+        return m_CPUAffinity;
+    }
     /// Set task worker name
     /// @p_Name : New name
     void TaskWorker::SetName(const std::string & p_Name)
@@ -78,6 +78,8 @@ namespace SteerStone { namespace Core { namespace Threading {
             /// Set thread CPU affinity
             /// @p_Affinity : Affinity
             void SetCPUAffinty(int32 p_Affinity);
+            /// Get thread CPU affinity
+            int32 GetCPUAffinity() const;
             /// Set task worker name
             /// @p_Name : New name
             void SetName(const std::string & p_Name);
@@ -0,0 +1,356 @@
+/*
+* Liam Ashdown
+* HardCPP (Merydwin)
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <PCH/Precompiled.hpp>
+
+#include "Threading/ThrTopology.hpp"
+
+#include "Logger/Base.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <thread>
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    SINGLETON_P_I(Topology);
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Constructor
+    Topology::Topology()
+        : m_CoreCount(0), m_CacheDomainCount(0), m_NodeCount(0)
+    {
+        if (!LoadSysfs())
+            LoadFallback();
+
+        BuildPlacement();
+
+        LOG_INFO("ThrTopology", "%0 CPUs, %1 physical cores, %2 cache domains, %3 NUMA nodes", m_CPUs.size(), m_CoreCount, m_CacheDomainCount, m_NodeCount);
+    }
+    /// Destructor
+    Topology::~Topology()
+    {
+
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get online CPUs
+    std::vector<TopologyCPU> const& Topology::GetCPUs() const
+    {
+        return m_CPUs;
+    }
+    /// Get physical core count
+    uint32 Topology::GetCoreCount() const
+    {
+        return m_CoreCount;
+    }
+    /// Get last level cache domain count
+    uint32 Topology::GetCacheDomainCount() const
+    {
+        return m_CacheDomainCount;
+    }
+    /// Get NUMA node count
+    uint32 Topology::GetNodeCount() const
+    {
+        return m_NodeCount;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Get the CPU a worker is pinned to
+    /// @p_Worker : Worker number from 0, wraps around
+    uint32 Topology::GetWorkerCPU(uint32 p_Worker) const
+    {
+        return m_Placement[p_Worker % m_Placement.size()];
+    }
+    /// Get the cache domain of a CPU, -1 if the CPU is unknown
+    /// @p_CPU : Logical CPU
+    int32 Topology::GetCacheDomain(int32 p_CPU) const
+    {
+        if (p_CPU < 0 || static_cast<std::size_t>(p_CPU) >= m_CPUIndex.size() || m_CPUIndex[p_CPU] < 0)
+            return -1;
+
+        return m_CPUs[m_CPUIndex[p_CPU]].CacheDomain;
+    }
+    /// Get the cache domain hot threads share when none is configured, the one of the first worker
+    uint32 Topology::GetDefaultCacheDomain() const
+    {
+        return GetCacheDomain(GetWorkerCPU(0));
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Read the topology from sysfs
+    bool Topology::LoadSysfs()
+    {
+        std::vector<uint32> l_Online;
+        if (!ReadCPUList(TOPOLOGY_SYSFS_CPU_PATH "/online", l_Online) || l_Online.empty())
+            return false;
+
+    #if defined(__linux__)
+        /// A cpuset or taskset may keep us off some of them, pinning there would fail
+        cpu_set_t l_Allowed;
+        CPU_ZERO(&l_Allowed);
+
+        if (!sched_getaffinity(0, sizeof(l_Allowed), &l_Allowed))
+        {
+            l_Online.erase(std::remove_if(l_Online.begin(), l_Online.end(), [&l_Allowed](uint32 p_CPU) -> bool {
+                return p_CPU >= CPU_SETSIZE || !CPU_ISSET(p_CPU, &l_Allowed);
+            }), l_Online.end());
+
+            if (l_Online.empty())
+                return false;
+        }
+    #endif
+
+        std::map<std::pair<int64, int64>, uint32>   l_Cores;        ///< Package and core id to core
+        std::map<std::string, uint32>               l_Domains;      ///< Shared CPU list to cache domain
+        std::vector<uint32>                         l_CoreThreads;  ///< SMT threads seen on each core
+
+        for (uint32 l_Id : l_Online)
+        {
+            const std::string l_Path = Utils::StringBuilder("%0/cpu%1", TOPOLOGY_SYSFS_CPU_PATH, l_Id);
+            std::string l_Value;
+
+            /// Some hypervisors report -1 for the package
+            const int64 l_Package = ReadLine(l_Path + "/topology/physical_package_id", l_Value) ? std::max<int64>(std::strtoll(l_Value.c_str(), nullptr, 10), 0) : 0;
+            const int64 l_Core    = ReadLine(l_Path + "/topology/core_id", l_Value) ? std::strtoll(l_Value.c_str(), nullptr, 10) : l_Id;
+
+            /// Last level cache is the highest level a data or unified cache is shared on
+            uint32      l_CacheLevel = 0;
+            std::string l_CacheShared;
+
+            for (uint32 l_Index = 0; l_Index < TOPOLOGY_MAX_CACHE_INDEX; l_Index++)
+            {
+                const std::string l_CachePath = Utils::StringBuilder("%0/cache/index%1", l_Path, l_Index);
+
+                if (!ReadLine(l_CachePath + "/level", l_Value))
+                    break;
+
+                const uint32 l_Level = std::strtoul(l_Value.c_str(), nullptr, 10);
+
+                if (l_Level <= l_CacheLevel || (ReadLine(l_CachePath + "/type", l_Value) && l_Value == "Instruction"))
+                    continue;
+
+                if (!ReadLine(l_CachePath + "/shared_cpu_list", l_Value))
+                    continue;
+
+                l_CacheLevel  = l_Level;
+                l_CacheShared = l_Value;
+            }
+
+            /// Without cache information the package is the best guess
+            if (l_CacheShared.empty())
+                l_CacheShared = Utils::StringBuilder("package%0", l_Package);
+
+            TopologyCPU l_CPU;
+            l_CPU.Id            = l_Id;
+            l_CPU.Package       = static_cast<uint32>(l_Package);
+            l_CPU.Core          = l_Cores.emplace(std::make_pair(l_Package, l_Core), static_cast<uint32>(l_Cores.size())).first->second;
+            l_CPU.CacheDomain   = l_Domains.emplace(l_CacheShared, static_cast<uint32>(l_Domains.size())).first->second;
+
+            if (l_CPU.Core >= l_CoreThreads.size())
+                l_CoreThreads.resize(l_CPU.Core + 1, 0);
+
+            /// CPUs come sorted, the lowest id of a core ranks first
+            l_CPU.Sibling = l_CoreThreads[l_CPU.Core]++;
+
+            m_CPUs.push_back(l_CPU);
+        }
+
+        m_CoreCount        = static_cast<uint32>(l_Cores.size());
+        m_CacheDomainCount = static_cast<uint32>(l_Domains.size());
+        m_CPUIndex.assign(m_CPUs.back().Id + 1, -1);
+
+        for (std::size_t l_I = 0; l_I < m_CPUs.size(); l_I++)
+            m_CPUIndex[m_CPUs[l_I].Id] = static_cast<int32>(l_I);
+
+        /// Machines without NUMA have no node directory, everything is node 0
+        std::vector<uint32> l_Nodes;
+        if (!ReadCPUList(TOPOLOGY_SYSFS_NODE_PATH "/online", l_Nodes) || l_Nodes.empty())
+        {
+            m_NodeCount = 1;
+            return true;
+        }
+
+        m_NodeCount = static_cast<uint32>(l_Nodes.size());
+
+        for (uint32 l_Node : l_Nodes)
+        {
+            std::vector<uint32> l_NodeCPUs;
+            if (!ReadCPUList(Utils::StringBuilder("%0/node%1/cpulist", TOPOLOGY_SYSFS_NODE_PATH, l_Node), l_NodeCPUs))
+                continue;
+
+            for (uint32 l_Id : l_NodeCPUs)
+            {
+                if (l_Id < m_CPUIndex.size() && m_CPUIndex[l_Id] >= 0)
+                    m_CPUs[m_CPUIndex[l_Id]].Node = l_Node;
+            }
+        }
+
+        return true;
+    }
+    /// One core, one cache domain and one node per CPU we are told about
+    void Topology::LoadFallback()
+    {
+        const uint32 l_Count = std::max<uint32>(std::thread::hardware_concurrency(), 1);
+
+        m_CPUs.clear();
+        m_CPUIndex.clear();
+
+        for (uint32 l_I = 0; l_I < l_Count; l_I++)
+        {
+            TopologyCPU l_CPU;
+            l_CPU.Id    = l_I;
+            l_CPU.Core  = l_I;
+
+            m_CPUs.push_back(l_CPU);
+            m_CPUIndex.push_back(static_cast<int32>(l_I));
+        }
+
+        m_CoreCount        = l_Count;
+        m_CacheDomainCount = 1;
+        m_NodeCount        = 1;
+    }
+    /// Build the worker placement order
+    void Topology::BuildPlacement()
+    {
+        const int32 l_KernelCore = m_CPUIndex.empty() || m_CPUIndex[0] < 0 ? -1 : static_cast<int32>(m_CPUs[m_CPUIndex[0]].Core);
+
+        uint32 l_MaxSibling = 0;
+        for (TopologyCPU const& l_CPU : m_CPUs)
+            l_MaxSibling = std::max(l_MaxSibling, l_CPU.Sibling);
+
+        /// First threads of every core, then the second ones, so two busy workers only share a core once every core has one
+        for (uint32 l_Rank = 0; l_Rank <= l_MaxSibling; l_Rank++)
+        {
+            std::vector<std::vector<uint32>>    l_Domains(m_CacheDomainCount);
+            std::vector<uint32>                 l_Kernel;
+
+            for (TopologyCPU const& l_CPU : m_CPUs)
+            {
+                if (l_CPU.Sibling != l_Rank)
+                    continue;
+
+                if (static_cast<int32>(l_CPU.Core) == l_KernelCore)
+                    l_Kernel.push_back(l_CPU.Id);
+                else
+                    l_Domains[l_CPU.CacheDomain].push_back(l_CPU.Id);
+            }
+
+            /// Round the domains, each one gets exclusive workers before the inclusive ones come in
+            for (std::size_t l_Round = 0;; l_Round++)
+            {
+                bool l_Placed = false;
+
+                for (std::vector<uint32> const& l_Domain : l_Domains)
+                {
+                    if (l_Round >= l_Domain.size())
+                        continue;
+
+                    m_Placement.push_back(l_Domain[l_Round]);
+                    l_Placed = true;
+                }
+
+                if (!l_Placed)
+                    break;
+            }
+
+            m_Placement.insert(m_Placement.end(), l_Kernel.begin(), l_Kernel.end());
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Read a sysfs CPU list, e.g "0-3,8-11"
+    /// @p_Path : File to read
+    /// @p_CPUs : Parsed CPUs
+    bool Topology::ReadCPUList(std::string const& p_Path, std::vector<uint32>& p_CPUs)
+    {
+        std::string l_List;
+        if (!ReadLine(p_Path, l_List))
+            return false;
+
+        p_CPUs.clear();
+
+        const char* l_Cursor = l_List.c_str();
+        while (*l_Cursor)
+        {
+            char* l_End = nullptr;
+            const uint32 l_First = std::strtoul(l_Cursor, &l_End, 10);
+
+            if (l_End == l_Cursor)
+                return false;
+
+            uint32 l_Last = l_First;
+            l_Cursor = l_End;
+
+            if (*l_Cursor == '-')
+            {
+                l_Last = std::strtoul(l_Cursor + 1, &l_End, 10);
+
+                if (l_End == l_Cursor + 1 || l_Last < l_First)
+                    return false;
+
+                l_Cursor = l_End;
+            }
+
+            for (uint32 l_CPU = l_First; l_CPU <= l_Last; l_CPU++)
+                p_CPUs.push_back(l_CPU);
+
+            if (*l_Cursor == ',')
+                l_Cursor++;
+            else if (*l_Cursor)
+                return false;
+        }
+
+        std::sort(p_CPUs.begin(), p_CPUs.end());
+        p_CPUs.erase(std::unique(p_CPUs.begin(), p_CPUs.end()), p_CPUs.end());
+
+        return true;
+    }
+    /// Read the first line of a sysfs file
+    /// @p_Path  : File to read
+    /// @p_Value : Line read
+    bool Topology::ReadLine(std::string const& p_Path, std::string& p_Value)
+    {
+        std::ifstream l_Stream(p_Path, std::ifstream::in);
+        if (!l_Stream.is_open() || !std::getline(l_Stream, p_Value))
+            return false;
+
+        /// Strip the trailing whitespace sysfs leaves
+        p_Value.erase(p_Value.find_last_not_of(" \t\r\n") + 1);
+
+        return !p_Value.empty();
+    }
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
@@ -0,0 +1,108 @@
+/*
+* Liam Ashdown
+* HardCPP (Merydwin)
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Core/Core.hpp"
+#include "Singleton/Singleton.hpp"
+
+#include <vector>
+#include <string>
+
+#define TOPOLOGY_SYSFS_CPU_PATH     "/sys/devices/system/cpu"
+#define TOPOLOGY_SYSFS_NODE_PATH    "/sys/devices/system/node"
+#define TOPOLOGY_MAX_CACHE_INDEX    16      ///< cache/indexN entries looked at for each CPU
+
+namespace SteerStone { namespace Core { namespace Threading {
+
+    /// One logical CPU
+    struct TopologyCPU
+    {
+        uint32 Id           = 0;    ///< Logical CPU, as given to the affinity calls
+        uint32 Core         = 0;    ///< Physical core, unique across packages
+        uint32 Package      = 0;    ///< Physical package (socket)
+        uint32 Node         = 0;    ///< NUMA node
+        uint32 CacheDomain  = 0;    ///< CPUs sharing the same last level cache
+        uint32 Sibling      = 0;    ///< Rank among the SMT threads of its core, 0 for the first
+    };
+
+    /// CPU topology of the host, read once from sysfs
+    /// Falls back to one cache domain of hardware_concurrency cores when sysfs is not there
+    class Topology
+    {
+        SINGLETON_P_D(Topology);
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        public:
+            /// Get online CPUs
+            std::vector<TopologyCPU> const& GetCPUs() const;
+            /// Get physical core count
+            uint32 GetCoreCount() const;
+            /// Get last level cache domain count
+            uint32 GetCacheDomainCount() const;
+            /// Get NUMA node count
+            uint32 GetNodeCount() const;
+
+            /// Get the CPU a worker is pinned to
+            /// Workers take one SMT thread of every physical core before any sibling, going round the cache
+            /// domains so each one gets workers; the core of CPU 0 comes last to leave it to the kernel
+            /// @p_Worker : Worker number from 0, wraps around
+            uint32 GetWorkerCPU(uint32 p_Worker) const;
+            /// Get the cache domain of a CPU, -1 if the CPU is unknown
+            /// @p_CPU : Logical CPU
+            int32 GetCacheDomain(int32 p_CPU) const;
+            /// Get the cache domain hot threads share when none is configured, the one of the first worker
+            uint32 GetDefaultCacheDomain() const;
+
+        //////////////////////////////////////////////////////////////////////////
+        //////////////////////////////////////////////////////////////////////////
+
+        private:
+            /// Read the topology from sysfs
+            bool LoadSysfs();
+            /// One core, one cache domain and one node per CPU we are told about
+            void LoadFallback();
+            /// Build the worker placement order
+            void BuildPlacement();
+
+            /// Read a sysfs CPU list, e.g "0-3,8-11"
+            /// @p_Path : File to read
+            /// @p_CPUs : Parsed CPUs
+            static bool ReadCPUList(std::string const& p_Path, std::vector<uint32>& p_CPUs);
+            /// Read the first line of a sysfs file
+            /// @p_Path  : File to read
+            /// @p_Value : Line read
+            static bool ReadLine(std::string const& p_Path, std::string& p_Value);
+
+        private:
+            std::vector<TopologyCPU>    m_CPUs;             ///< Online CPUs, sorted by id
+            std::vector<int32>          m_CPUIndex;         ///< Logical CPU to index in m_CPUs, -1 if offline
+            std::vector<uint32>         m_Placement;        ///< CPU of each worker, see GetWorkerCPU
+            uint32                      m_CoreCount;        ///< Physical cores
+            uint32                      m_CacheDomainCount; ///< Last level cache domains
+            uint32                      m_NodeCount;        ///< NUMA nodes
+
+    };
+
+}   ///< namespace Threading
+}   ///< namespace Core
+}   ///< namespace SteerStone
+
+#define sTopology SteerStone::Core::Threading::Topology::GetSingleton()
@@ -0,0 +1,115 @@
+/*
+* Liam Ashdown
+* Copyright (C) 2019
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include "Server/Socket.hpp"
+
+#define OPCODE_HEADER_SIZE 2                ///< Base64 encoded opcode in front of every frame body
+#define OPCODE_MAX 4096                     ///< Two base64 characters give 12 bits of opcode
+
+namespace SteerStone { namespace Game { namespace Server {
+
+    /// Client Opcodes
+    enum ClientOpcodes : uint16
+    {
+        CLIENT_GET_INFO             = 7,
+        CLIENT_GET_CREDITS          = 8,
+        CLIENT_PONG                 = 196,
+        CLIENT_GENERATE_KEY         = 202,
+        CLIENT_SSO_TICKET           = 204,
+        CLIENT_INIT_CRYPTO          = 206,
+    };
+
+    /// Handler of one opcode
+    struct OpcodeHandler
+    {
+        using Function = Core::Network::ProcessState (GameSocket::*)(Core::Network::FrameView const&);
+
+        char const* Name            = nullptr;                          ///< Opcode name, null for an unhandled opcode
+        Authenticated MinimumState  = Authenticated::Authenticed;       ///< Lowest state a client must be in
+        std::size_t MaxPayload      = 0;                                ///< Largest payload accepted, after the opcode
+        Function Handler            = nullptr;                          ///< Handler
+    };
+
+    /// Opcode definition, as listed in s_OpcodeList
+    struct OpcodeDefinition
+    {
+        uint16 Opcode;                                                  ///< Opcode
+        OpcodeHandler Handler;                                          ///< Handler
+    };
+
+    /// Every handled client opcode, the dispatch table is generated from this
+    static constexpr OpcodeDefinition s_OpcodeList[] =
+    {
+        { CLIENT_INIT_CRYPTO,   { "CLIENT_INIT_CRYPTO",     Authenticated::NotAuthenticated,    0,      &GameSocket::HandleNULL } },
+        { CLIENT_GENERATE_KEY,  { "CLIENT_GENERATE_KEY",    Authenticated::NotAuthenticated,    256,    &GameSocket::HandleNULL } },
+        { CLIENT_SSO_TICKET,    { "CLIENT_SSO_TICKET",      Authenticated::NotAuthenticated,    256,    &GameSocket::HandleNULL } },
+        { CLIENT_PONG,          { "CLIENT_PONG",            Authenticated::Authenticed,         0,      &GameSocket::HandleNULL } },
+        { CLIENT_GET_INFO,      { "CLIENT_GET_INFO",        Authenticated::Authenticed,         0,      &GameSocket::HandleNULL } },
+        { CLIENT_GET_CREDITS,   { "CLIENT_GET_CREDITS",     Authenticated::Authenticed,         0,      &GameSocket::HandleNULL } },
+    };
+
+    /// Dispatch table, indexed by opcode
+    struct OpcodeTable
+    {
+        OpcodeHandler Handlers[OPCODE_MAX];
+    };
+
+    /// Build the dispatch table from s_OpcodeList
+    constexpr OpcodeTable BuildOpcodeTable()
+    {
+        OpcodeTable l_Table{};
+
+        for (OpcodeDefinition const& l_Definition : s_OpcodeList)
+            l_Table.Handlers[l_Definition.Opcode] = l_Definition.Handler;
+
+        return l_Table;
+    }
+    /// Check every listed opcode is in range and listed once
+    constexpr bool IsOpcodeListValid()
+    {
+        for (std::size_t l_I = 0; l_I < sizeof(s_OpcodeList) / sizeof(s_OpcodeList[0]); l_I++)
+        {
+            if (s_OpcodeList[l_I].Opcode >= OPCODE_MAX || !s_OpcodeList[l_I].Handler.Handler)
+                return false;
+
+            for (std::size_t l_J = l_I + 1; l_J < sizeof(s_OpcodeList) / sizeof(s_OpcodeList[0]); l_J++)
+                if (s_OpcodeList[l_I].Opcode == s_OpcodeList[l_J].Opcode)
+                    return false;
+        }
+
+        return true;
+    }
+
+    static_assert(IsOpcodeListValid(), "s_OpcodeList has an opcode out of range, without handler or listed twice");
+
+    static constexpr OpcodeTable s_OpcodeTable = BuildOpcodeTable();
+
+    /// Get handler of an opcode, null if it is not handled
+    /// @p_Opcode : Opcode
+    inline OpcodeHandler const* GetOpcodeHandler(uint16 const p_Opcode)
+    {
+        if (p_Opcode >= OPCODE_MAX || !s_OpcodeTable.Handlers[p_Opcode].Handler)
+            return nullptr;
+
+        return &s_OpcodeTable.Handlers[p_Opcode];
+    }
+
+}   ///< namespace Server
+}   ///< namespace Game
+}   ///< namespace Steerstone
@@ -17,6 +17,8 @@
 */
 
 #include "Socket.hpp"
+#include "Opcodes/Opcodes.hpp"
+#include "Network/PacketReader.hpp"
 
 namespace SteerStone { namespace Game { namespace Server {
 
@@ -33,19 +35,98 @@ namespace SteerStone { namespace Game { namespace Server {
     //////////////////////////////////////////////////////////////////////////
 
     /// Handle incoming data
+    /// Splits the in buffer into frames in place, a frame which has not fully arrived
+    /// yet is left in the buffer and picked up on the next read
     Core::Network::ProcessState GameSocket::ProcessIncomingData()
     {
-        std::vector<uint8> l_BufferVec;
-        l_BufferVec.resize(ReadLengthRemaining());
+        while (ReadLengthRemaining() >= PACKET_LENGTH_HEADER_SIZE)
+        {
+            uint8 const* l_Header = InPeak();
+
+            /// Length is encoded as 3 base64 characters
+            uint32 l_Length = 0;
+            if (!Core::Network::PacketReader::DecodeBase64(l_Header, PACKET_LENGTH_HEADER_SIZE, l_Length))
+            {
+                LOG_ERROR("GameSocket", "Client %0 sent a malformed frame header, closing", GetRemoteAddress());
+                return Core::Network::ProcessState::Error;
+            }
+
+            if (l_Length > PACKET_MAX_LENGTH)
+            {
+                LOG_ERROR("GameSocket", "Client %0 sent a frame of %1 bytes, closing", GetRemoteAddress(), l_Length);
+                return Core::Network::ProcessState::Error;
+            }
+
+            /// Wait for the rest of the frame
+            if (ReadLengthRemaining() < PACKET_LENGTH_HEADER_SIZE + l_Length)
+                break;
+
+            Core::Network::FrameView l_Frame(l_Header + PACKET_LENGTH_HEADER_SIZE, l_Length);
+            ReadSkip(PACKET_LENGTH_HEADER_SIZE + l_Length);
+            CountMessagesIn();
+
+            /// Handled by the game tick; without an inbound queue we handle it here
+            const Core::Network::InboundResult l_Result = QueueInbound(l_Frame);
+
+            if (l_Result == Core::Network::InboundResult::Full)
+                return Core::Network::ProcessState::Error;
+
+            if (l_Result == Core::Network::InboundResult::NoQueue && ProcessPacket(l_Frame) == Core::Network::ProcessState::Error)
+                return Core::Network::ProcessState::Error;
+        }
+
+        return Core::Network::ProcessState::Successful;
+    }
+    /// Handle a complete frame, on the game tick
+    /// @p_Frame : Frame body, only valid until we return
+    Core::Network::ProcessState GameSocket::ProcessPacket(Core::Network::FrameView const& p_Frame)
+    {
+        Core::Network::PacketReader l_Reader(p_Frame);
+
+        /// Opcode is encoded as 2 base64 characters
+        const uint16 l_Opcode = static_cast<uint16>(l_Reader.ReadBase64(OPCODE_HEADER_SIZE));
+
+        if (l_Reader.HasError())
+        {
+            LOG_ERROR("GameSocket", "Client %0 sent a frame without a valid opcode, closing", GetRemoteAddress());
+            return Core::Network::ProcessState::Error;
+        }
+
+        Core::Network::FrameView l_Payload = l_Reader.ReadBytes(l_Reader.GetRemaining());
+
+        OpcodeHandler const* l_Handler = GetOpcodeHandler(l_Opcode);
+        if (!l_Handler)
+        {
+            LOG_VERBOSE("GameSocket", "Client %0 sent unhandled opcode %1", GetRemoteAddress(), l_Opcode);
+            return Core::Network::ProcessState::Successful;
+        }
+
+        if (m_AuthenticateState < l_Handler->MinimumState)
+        {
+            LOG_WARNING("GameSocket", "Client %0 sent %1 before being authenticated, ignoring", GetRemoteAddress(), l_Handler->Name);
+            return Core::Network::ProcessState::Successful;
+        }
 
-        /// Read the entire buffer
-        if (Read((char*)& l_BufferVec[0], ReadLengthRemaining()))
+        if (l_Payload.GetSize() > l_Handler->MaxPayload)
         {
-            /// Remove junk data
-            l_BufferVec.resize(l_BufferVec.size() + 1);
-            l_BufferVec[l_BufferVec.size() - 1] = 0;
+            LOG_ERROR("GameSocket", "Client %0 sent %1 with a payload of %2 bytes, closing", GetRemoteAddress(), l_Handler->Name, l_Payload.GetSize());
+            return Core::Network::ProcessState::Error;
         }
 
+        return (this->*l_Handler->Handler)(l_Payload);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////
+
+    /// Opcode which is accepted but not handled yet
+    /// @p_Frame : Frame body, after the opcode
+    Core::Network::ProcessState GameSocket::HandleNULL(Core::Network::FrameView const& p_Frame)
+    {
+        UNUSED(p_Frame);
+
+        LOG_VERBOSE("GameSocket", "Client %0 sent an opcode without handler, %1 bytes", GetRemoteAddress(), p_Frame.GetSize());
+
         return Core::Network::ProcessState::Successful;
     }
 }   ///< namespace Server
@@ -20,12 +20,16 @@
 #include "Network/Listener.hpp"
 #include "Diagnostic/DiaStopWatch.hpp"
 
+#define PACKET_LENGTH_HEADER_SIZE 3         ///< Base64 encoded length in front of every client frame
+#define PACKET_MAX_LENGTH 16384             ///< Largest frame body a client is allowed to send
+
 namespace SteerStone { namespace Game { namespace Server {
 
+    /// Client states, in order; an opcode handler names the lowest state it accepts
     enum class Authenticated
     {
-        Authenticed,            ///< Authenticated from server
         NotAuthenticated,       ///< Is not authenticated yet from server
+        Authenticed,            ///< Authenticated from server
     };
 
     class GameSocket : public Core::Network::Socket
@@ -46,6 +50,15 @@ namespace SteerStone { namespace Game { namespace Server {
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////
 
+        public:
+            /// Handle a complete frame, on the game tick
+            /// @p_Frame : Frame body, only valid until we return
+            Core::Network::ProcessState ProcessPacket(Core::Network::FrameView const& p_Frame);
+
+            /// Handlers, see Opcodes.hpp
+            /// Opcode which is accepted but not handled yet
+            /// @p_Frame : Frame body, after the opcode
+            Core::Network::ProcessState HandleNULL(Core::Network::FrameView const& p_Frame);
 
         //////////////////////////////////////////////////////////////////////////
         //////////////////////////////////////////////////////////////////////////